@@ -0,0 +1,170 @@
+#include "answer_index.h"
+
+#include <string.h>
+
+// Składanie wielkości liter dla pojedynczego znaku Unicode
+static uint32_t fold_codepoint(uint32_t c) {
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+    }
+    // Latin-1: À..Þ (bez znaku mnożenia ×)
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) return c + 0x20;
+    // Latin Extended-A: pary wielka/mała litera (Ą, Ć, Ę, Ł, Ń, Ś, Ź, Ż ...)
+    if (c >= 0x100 && c <= 0x137) return c | 1;
+    if (c >= 0x139 && c <= 0x148) return (c & 1) ? c + 1 : c;
+    if (c >= 0x14A && c <= 0x177) return c | 1;
+    if (c == 0x178) return 0xFF;
+    if (c >= 0x179 && c <= 0x17E) return (c & 1) ? c + 1 : c;
+    // Greka: Α..Ω (bez nieużywanego U+03A2)
+    if (c >= 0x391 && c <= 0x3A9 && c != 0x3A2) return c + 0x20;
+    // Cyrylica: Ѐ..Џ oraz А..Я
+    if (c >= 0x400 && c <= 0x40F) return c + 0x50;
+    if (c >= 0x410 && c <= 0x42F) return c + 0x20;
+    // Wielkie ẞ -> ß
+    if (c == 0x1E9E) return 0xDF;
+    return c;
+}
+
+// Dekoder wewnętrzny (statyczny, żeby kompilator wstawiał go w pętle normalizacji)
+static inline int decode_char(const unsigned char *s, uint32_t *cp) {
+    if (s[0] < 0x80) {
+        *cp = s[0];
+        return 1;
+    }
+    if ((s[0] & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        return *cp >= 0x80 ? 2 : 0;
+    }
+    if ((s[0] & 0xF0) == 0xE0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(s[0] & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        return *cp >= 0x800 ? 3 : 0;
+    }
+    if ((s[0] & 0xF8) == 0xF0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80) {
+        *cp = ((uint32_t)(s[0] & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12)
+            | ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        return (*cp >= 0x10000 && *cp <= 0x10FFFF) ? 4 : 0;
+    }
+    return 0;
+}
+
+int utf8_decode(const unsigned char *s, uint32_t *cp) {
+    return decode_char(s, cp);
+}
+
+static int utf8_encode(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Litera bez znaków diakrytycznych dla małych liter Latin-1 i Latin Extended-A (po fold_codepoint)
+static uint32_t strip_diacritic(uint32_t c) {
+    static const struct { uint16_t first, last; char base; } ranges[] = {
+        {0xDF, 0xDF, 's'}, {0xE0, 0xE6, 'a'}, {0xE7, 0xE7, 'c'}, {0xE8, 0xEB, 'e'}, {0xEC, 0xEF, 'i'},
+        {0xF0, 0xF0, 'd'}, {0xF1, 0xF1, 'n'}, {0xF2, 0xF6, 'o'}, {0xF8, 0xF8, 'o'}, {0xF9, 0xFC, 'u'},
+        {0xFD, 0xFD, 'y'}, {0xFF, 0xFF, 'y'},
+        {0x100, 0x105, 'a'}, {0x106, 0x10D, 'c'}, {0x10E, 0x111, 'd'}, {0x112, 0x11B, 'e'}, {0x11C, 0x123, 'g'},
+        {0x124, 0x127, 'h'}, {0x128, 0x133, 'i'}, {0x134, 0x135, 'j'}, {0x136, 0x138, 'k'}, {0x139, 0x142, 'l'},
+        {0x143, 0x14B, 'n'}, {0x14C, 0x153, 'o'}, {0x154, 0x159, 'r'}, {0x15A, 0x161, 's'}, {0x162, 0x167, 't'},
+        {0x168, 0x173, 'u'}, {0x174, 0x175, 'w'}, {0x176, 0x178, 'y'}, {0x179, 0x17E, 'z'}, {0x17F, 0x17F, 's'},
+    };
+    if (c < 0xDF || c > 0x17F) return c;
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        if (c >= ranges[i].first && c <= ranges[i].last) return (uint32_t)ranges[i].base;
+    }
+    return c;
+}
+
+static int is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+size_t normalize_answer(const char *in, char *out, size_t cap) {
+    if (cap == 0) return 0;
+    const unsigned char *s = (const unsigned char *)in;
+    size_t len = strlen(in);
+
+    // Obcinamy białe znaki z obu stron (np. "\r" od klientów z Windowsa)
+    while (len > 0 && is_space(*s)) { s++; len--; }
+    while (len > 0 && is_space(s[len - 1])) len--;
+
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        if (s[i] < 0x80) {
+            // ASCII bez dekodowania (większość odpowiedzi)
+            if (o + 1 >= cap) break;
+            out[o++] = (char)fold_codepoint(s[i++]);
+            continue;
+        }
+        // Wejście jest zakończone '\0', a ten nie jest bajtem kontynuacji,
+        // więc dekoder nie wyjdzie poza napis
+        uint32_t cp;
+        int n = decode_char(s + i, &cp);
+        char enc[4];
+        int m;
+        if (n == 0) {
+            // Niepoprawny UTF-8 -> bajt przepisujemy bez zmian
+            enc[0] = (char)s[i];
+            m = 1;
+            n = 1;
+        } else {
+            m = utf8_encode(fold_codepoint(cp), enc);
+        }
+        if (o + m >= cap) break;
+        memcpy(out + o, enc, m);
+        o += m;
+        i += n;
+    }
+    out[o] = '\0';
+    return o;
+}
+
+size_t fold_answer(const char *in, char *out, size_t cap) {
+    size_t len = normalize_answer(in, out, cap);
+    // Zdjęcie ogonka/akcentu nie wydłuża znaku, więc przepisujemy w miejscu
+    size_t o = 0;
+    size_t i = 0;
+    while (i < len) {
+        if ((unsigned char)out[i] < 0x80) {
+            out[o++] = out[i++];
+            continue;
+        }
+        uint32_t cp;
+        int n = decode_char((const unsigned char *)out + i, &cp);
+        if (n == 0) {
+            out[o++] = out[i++];
+            continue;
+        }
+        o += utf8_encode(strip_diacritic(cp), out + o);
+        i += n;
+    }
+    out[o] = '\0';
+    return o;
+}
+
+uint32_t answer_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
@@ -0,0 +1,23 @@
+#ifndef ANSWER_INDEX_H
+#define ANSWER_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Normalizuje odpowiedź: obcina białe znaki z brzegów i składa wielkość liter
+// w UTF-8 (ASCII, Latin-1, Latin Extended-A, greka, cyrylica), np. "BIAŁORUŚ" -> "białoruś".
+// Wynik nigdy nie jest dłuższy niż wejście. Zwraca długość wyniku (bez '\0').
+size_t normalize_answer(const char *in, char *out, size_t cap);
+
+// Klucz do dopasowania przybliżonego: normalize_answer() i zdjęcie znaków diakrytycznych
+// (Latin-1, Latin Extended-A), np. "BIAŁORUŚ" -> "bialorus". Wynik nie jest dłuższy niż wejście.
+size_t fold_answer(const char *in, char *out, size_t cap);
+
+// Dekoduje jeden znak UTF-8. Zwraca liczbę zużytych bajtów (0 = niepoprawna sekwencja).
+// Napis musi być zakończony '\0' (dekoder nie czyta za nim).
+int utf8_decode(const unsigned char *s, uint32_t *cp);
+
+// Hash FNV-1a (32 bit) po bajtach znormalizowanej odpowiedzi
+uint32_t answer_hash(const char *s, size_t len);
+
+#endif
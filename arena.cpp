@@ -0,0 +1,60 @@
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void arena_init(Arena *a, size_t blockSize) {
+    a->head = NULL;
+    a->current = NULL;
+    a->blockSize = blockSize ? blockSize : ARENA_BLOCK_SIZE;
+}
+
+void *arena_alloc(Arena *a, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+
+    // Szukamy miejsca od bieżącego bloku; bloki z poprzednich rund są już wyzerowane przez arena_reset()
+    ArenaBlock *b = a->current;
+    ArenaBlock *prev = NULL;
+    while (b && b->cap - b->used < size) {
+        prev = b;
+        b = b->next;
+    }
+    if (!b) {
+        size_t cap = size > a->blockSize ? size : a->blockSize;
+        b = (ArenaBlock *)malloc(sizeof(ArenaBlock) + cap);
+        if (!b) return NULL;
+        b->next = NULL;
+        b->cap = cap;
+        b->used = 0;
+        if (prev) prev->next = b;
+        else a->head = b;
+    }
+    a->current = b;
+
+    void *p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+char *arena_strdup(Arena *a, const char *s) {
+    size_t len = strlen(s) + 1;
+    char *copy = (char *)arena_alloc(a, len);
+    if (copy) memcpy(copy, s, len);
+    return copy;
+}
+
+void arena_reset(Arena *a) {
+    for (ArenaBlock *b = a->head; b; b = b->next) b->used = 0;
+    a->current = a->head;
+}
+
+void arena_free(Arena *a) {
+    ArenaBlock *b = a->head;
+    while (b) {
+        ArenaBlock *next = b->next;
+        free(b);
+        b = next;
+    }
+    a->head = NULL;
+    a->current = NULL;
+}
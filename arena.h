@@ -0,0 +1,32 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Arena (bump allocator) na dane żyjące najwyżej jedną rundę, np. odpowiedzi graczy.
+// Alokacja to przesunięcie wskaźnika w bieżącym bloku; arena_reset() zwalnia wszystko naraz,
+// ale bloki zostają, więc kolejne rundy nie wołają już malloc.
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t cap;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock *head;
+    ArenaBlock *current;       // blok, z którego teraz alokujemy (wcześniejsze są pełne)
+    size_t blockSize;          // domyślny rozmiar nowego bloku
+} Arena;
+
+#define ARENA_BLOCK_SIZE 16384
+
+void arena_init(Arena *a, size_t blockSize);
+// Pamięć wyrównana do 8 bajtów albo NULL przy braku pamięci
+void *arena_alloc(Arena *a, size_t size);
+char *arena_strdup(Arena *a, const char *s);
+// Unieważnia wszystkie alokacje, bloki zostają do ponownego użycia
+void arena_reset(Arena *a);
+void arena_free(Arena *a);
+
+#endif
@@ -0,0 +1,512 @@
+#include "bank_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "answer_index.h"
+#include "fuzzy_match.h"
+
+// --- Odczyt obrazu ---
+
+static const uint32_t *u32_at(const QuestionBank *bank, uint64_t off) {
+    return (const uint32_t *)(bank->data + off);
+}
+
+// Czy tablica 'count' liczb uint32 od 'off' mieści się w obrazie
+static int array_ok(size_t size, uint64_t off, uint64_t count) {
+    if (off % sizeof(uint32_t) != 0 || off > size) return 0;
+    return count <= (size - off) / sizeof(uint32_t);
+}
+
+// Sprawdza strukturę obrazu: nagłówek i granice tablic każdego pytania (O(liczba pytań)).
+// Offsety pojedynczych napisów są sprawdzane przy odczycie.
+static int validate(QuestionBank *bank) {
+    if (bank->size < sizeof(BankHeader)) {
+        fprintf(stderr, "Obraz bazy pytań jest za krótki.\n");
+        return -1;
+    }
+    const BankHeader *hdr = (const BankHeader *)bank->data;
+    if (memcmp(hdr->magic, BANK_MAGIC, sizeof(hdr->magic)) != 0) {
+        fprintf(stderr, "To nie jest obraz bazy pytań.\n");
+        return -1;
+    }
+    if (hdr->version != BANK_VERSION) {
+        fprintf(stderr, "Nieobsługiwana wersja obrazu bazy pytań: %u (oczekiwano %d).\n", hdr->version, BANK_VERSION);
+        return -1;
+    }
+    if (hdr->fileSize != bank->size || hdr->questionsOff % 8 != 0 || hdr->questionsOff > bank->size
+        || hdr->questionCount > (bank->size - hdr->questionsOff) / sizeof(BankQuestion)
+        || hdr->poolOff > bank->size || hdr->poolSize == 0 || hdr->poolSize > bank->size - hdr->poolOff
+        || bank->data[hdr->poolOff + hdr->poolSize - 1] != '\0') {
+        fprintf(stderr, "Uszkodzony obraz bazy pytań (nagłówek).\n");
+        return -1;
+    }
+
+    bank->questions = (const BankQuestion *)(bank->data + hdr->questionsOff);
+    bank->pool = bank->data + hdr->poolOff;
+    bank->poolSize = hdr->poolSize;
+    bank->questionCount = (int)hdr->questionCount;
+
+    for (int i = 0; i < bank->questionCount; i++) {
+        const BankQuestion *q = &bank->questions[i];
+        int capOk = q->indexCapacity > 0 && (q->indexCapacity & (q->indexCapacity - 1)) == 0;
+        if (q->textOff >= hdr->poolSize || !capOk
+            || !array_ok(bank->size, q->answersOff, q->answerCount)
+            || !array_ok(bank->size, q->keysOff, q->answerCount)
+            || !array_ok(bank->size, q->keyLensOff, q->answerCount)
+            || !array_ok(bank->size, q->slotsOff, q->indexCapacity)
+            || !array_ok(bank->size, q->hashesOff, q->indexCapacity)
+            || q->fuzzyCount > q->answerCount || q->fuzzyOff % 8 != 0 || q->fuzzyOff > bank->size
+            || q->fuzzyCount > (bank->size - q->fuzzyOff) / sizeof(BankFuzzyEntry)) {
+            fprintf(stderr, "Uszkodzony obraz bazy pytań (pytanie %d).\n", i + 1);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int bank_image_open(QuestionBank *bank, const char *path) {
+    memset(bank, 0, sizeof(*bank));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        fprintf(stderr, "Nie można otworzyć obrazu bazy pytań %s.\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0) {
+        fprintf(stderr, "Pusty lub nieczytelny obraz bazy pytań %s.\n", path);
+        close(fd);
+        return -1;
+    }
+    // Mapowanie współdzielone: strony obrazu są wspólne dla wszystkich procesów serwera
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    bank->data = (const char *)p;
+    bank->size = (size_t)st.st_size;
+    bank->mapped = 1;
+    if (validate(bank) != 0) {
+        bank_image_close(bank);
+        return -1;
+    }
+    return 0;
+}
+
+int bank_image_from_memory(QuestionBank *bank, char *data, size_t size) {
+    memset(bank, 0, sizeof(*bank));
+    bank->data = data;
+    bank->size = size;
+    if (validate(bank) != 0) {
+        bank_image_close(bank);
+        return -1;
+    }
+    return 0;
+}
+
+void bank_image_close(QuestionBank *bank) {
+    if (bank->data) {
+        if (bank->mapped) munmap((void *)bank->data, bank->size);
+        else free((void *)bank->data);
+    }
+    memset(bank, 0, sizeof(*bank));
+}
+
+static const char *pool_string(const QuestionBank *bank, uint32_t off) {
+    return off < bank->poolSize ? bank->pool + off : "";
+}
+
+const char *bank_question_text(const QuestionBank *bank, int q) {
+    if (q < 0 || q >= bank->questionCount) return "";
+    return pool_string(bank, bank->questions[q].textOff);
+}
+
+int bank_answer_count(const QuestionBank *bank, int q) {
+    if (q < 0 || q >= bank->questionCount) return 0;
+    return (int)bank->questions[q].answerCount;
+}
+
+const char *bank_answer_text(const QuestionBank *bank, int q, int id) {
+    if (id < 0 || id >= bank_answer_count(bank, q)) return "";
+    return pool_string(bank, u32_at(bank, bank->questions[q].answersOff)[id]);
+}
+
+int bank_find_answer(const QuestionBank *bank, int q, const char *response) {
+    if (q < 0 || q >= bank->questionCount) return -1;
+    const BankQuestion *bq = &bank->questions[q];
+
+    char key[1024];
+    size_t len = normalize_answer(response, key, sizeof(key));
+    uint32_t h = answer_hash(key, len);
+
+    const uint32_t *slots = u32_at(bank, bq->slotsOff);
+    const uint32_t *hashes = u32_at(bank, bq->hashesOff);
+    const uint32_t *keys = u32_at(bank, bq->keysOff);
+    const uint32_t *keyLens = u32_at(bank, bq->keyLensOff);
+    uint32_t mask = bq->indexCapacity - 1;
+    uint32_t pos = h & mask;
+
+    // Sondowanie ograniczone rozmiarem indeksu (uszkodzony obraz nie zapętli serwera)
+    for (uint32_t n = 0; n < bq->indexCapacity && slots[pos] != 0; n++) {
+        uint32_t id = slots[pos] - 1;
+        if (hashes[pos] == h && id < bq->answerCount && keyLens[id] == len
+            && keys[id] < bank->poolSize && len < bank->poolSize - keys[id]
+            && memcmp(bank->pool + keys[id], key, len) == 0) {
+            return (int)id;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return -1;
+}
+
+int bank_match_answer(const QuestionBank *bank, int q, const char *response, int defaultMaxEdits) {
+    int id = bank_find_answer(bank, q, response);
+    if (id >= 0 || q < 0 || q >= bank->questionCount) return id;
+    const BankQuestion *bq = &bank->questions[q];
+    int maxEdits = bq->maxEdits == BANK_FUZZY_DEFAULT ? defaultMaxEdits : (int)bq->maxEdits;
+    if (maxEdits <= 0 || bq->fuzzyCount == 0) return -1;
+
+    char key[1024];
+    size_t len = fold_answer(response, key, sizeof(key));
+    FuzzyPattern pat;
+    if (fuzzy_pattern_init(&pat, key, len) != 0) return -1;
+    // Krótkie odpowiedzi dostają mniej literówek (przy zerze zostaje porównanie bez diakrytyków)
+    if (maxEdits > pat.len / FUZZY_CHARS_PER_EDIT) maxEdits = pat.len / FUZZY_CHARS_PER_EDIT;
+
+    // Filtr długości: wpisy są posortowane po liczbie znaków, szukamy pierwszego >= len - maxEdits
+    const BankFuzzyEntry *entries = (const BankFuzzyEntry *)(bank->data + bq->fuzzyOff);
+    uint32_t minChars = pat.len > maxEdits ? (uint32_t)(pat.len - maxEdits) : 0;
+    uint32_t maxChars = (uint32_t)(pat.len + maxEdits);
+    uint32_t lo = 0, hi = bq->fuzzyCount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (entries[mid].chars < minChars) lo = mid + 1;
+        else hi = mid;
+    }
+
+    int best = -1;
+    int limit = maxEdits;   // po trafieniu: odległość najlepszego (remis rozstrzyga niższe id)
+    for (uint32_t i = lo; i < bq->fuzzyCount && entries[i].chars <= maxChars; i++) {
+        const BankFuzzyEntry *e = &entries[i];
+        if (!fuzzy_signature_ok(e->sig, pat.sig, e->bigrams, pat.bigrams, limit)) continue;
+        if (e->id >= bq->answerCount || e->keyOff >= bank->poolSize || e->keyLen >= bank->poolSize - e->keyOff) {
+            continue;
+        }
+        int dist = fuzzy_distance(&pat, bank->pool + e->keyOff, e->keyLen, limit);
+        if (dist > limit || (best >= 0 && dist == limit && (int)e->id > best)) continue;
+        best = (int)e->id;
+        limit = dist;
+    }
+    return best;
+}
+
+// --- Budowanie obrazu ---
+
+void bank_builder_init(BankBuilder *b) {
+    memset(b, 0, sizeof(*b));
+}
+
+void bank_builder_free(BankBuilder *b) {
+    free(b->pool);
+    free(b->qText);
+    free(b->qFirst);
+    free(b->qCount);
+    free(b->qMaxEdits);
+    free(b->answers);
+    memset(b, 0, sizeof(*b));
+}
+
+// Dopisuje napis (z '\0') do puli; zwraca jego offset albo -1
+static int64_t pool_add(BankBuilder *b, const char *s, size_t len) {
+    if (b->poolLen + len + 1 > UINT32_MAX) {
+        fprintf(stderr, "Baza pytań przekracza 4 GB napisów.\n");
+        return -1;
+    }
+    if (b->poolLen + len + 1 > b->poolCap) {
+        size_t cap = b->poolCap ? b->poolCap : 4096;
+        while (cap < b->poolLen + len + 1) cap *= 2;
+        char *tmp = (char *)realloc(b->pool, cap);
+        if (!tmp) return -1;
+        b->pool = tmp;
+        b->poolCap = cap;
+    }
+    int64_t off = (int64_t)b->poolLen;
+    memcpy(b->pool + b->poolLen, s, len);
+    b->pool[b->poolLen + len] = '\0';
+    b->poolLen += len + 1;
+    return off;
+}
+
+int bank_builder_add_question(BankBuilder *b, const char *text) {
+    if (b->questions == b->questionsCap) {
+        int cap = b->questionsCap ? b->questionsCap * 2 : 64;
+        uint32_t *t = (uint32_t *)realloc(b->qText, sizeof(uint32_t) * cap);
+        if (!t) return -1;
+        b->qText = t;
+        uint32_t *f = (uint32_t *)realloc(b->qFirst, sizeof(uint32_t) * cap);
+        if (!f) return -1;
+        b->qFirst = f;
+        uint32_t *c = (uint32_t *)realloc(b->qCount, sizeof(uint32_t) * cap);
+        if (!c) return -1;
+        b->qCount = c;
+        uint32_t *e = (uint32_t *)realloc(b->qMaxEdits, sizeof(uint32_t) * cap);
+        if (!e) return -1;
+        b->qMaxEdits = e;
+        b->questionsCap = cap;
+    }
+    int64_t off = pool_add(b, text, strlen(text));
+    if (off < 0) return -1;
+    b->qText[b->questions] = (uint32_t)off;
+    b->qFirst[b->questions] = (uint32_t)b->answerCount;
+    b->qCount[b->questions] = 0;
+    b->qMaxEdits[b->questions] = BANK_FUZZY_DEFAULT;
+    b->questions++;
+    return 0;
+}
+
+void bank_builder_set_max_edits(BankBuilder *b, uint32_t maxEdits) {
+    if (b->questions > 0) b->qMaxEdits[b->questions - 1] = maxEdits;
+}
+
+int bank_builder_add_answer(BankBuilder *b, const char *answer) {
+    // Odpowiedź przed pierwszym pytaniem nie ma do czego należeć
+    if (b->questions == 0) return 0;
+    if (b->answerCount == b->answersCap) {
+        size_t cap = b->answersCap ? b->answersCap * 2 : 1024;
+        uint32_t *tmp = (uint32_t *)realloc(b->answers, sizeof(uint32_t) * cap);
+        if (!tmp) return -1;
+        b->answers = tmp;
+        b->answersCap = cap;
+    }
+    int64_t off = pool_add(b, answer, strlen(answer));
+    if (off < 0) return -1;
+    b->answers[b->answerCount++] = (uint32_t)off;
+    b->qCount[b->questions - 1]++;
+    return 0;
+}
+
+int bank_builder_feed_line(BankBuilder *b, const char *line) {
+    if (strcmp(line, "[QUESTION]") == 0) {
+        b->state = 1;
+        return 1;
+    }
+    if (strcmp(line, "[ANSWER]") == 0) {
+        b->state = 2;
+        return 1;
+    }
+    if (b->state == 1) {
+        // Linia po [QUESTION] to treść pytania
+        b->state = 3;
+        return bank_builder_add_question(b, line) == 0 ? 1 : -1;
+    }
+    if (b->state == 3) {
+        // Między treścią a [ANSWER]: własny limit literówek pytania (FUZZY=0 - tylko dokładne trafienia)
+        if (strncmp(line, "FUZZY=", 6) == 0) {
+            int edits = atoi(line + 6);
+            bank_builder_set_max_edits(b, edits > 0 ? (uint32_t)edits : 0);
+            return 1;
+        }
+        b->state = 0;
+    }
+    if (b->state == 2) {
+        // Puste linie w sekcji odpowiedzi pomijamy (pusta odpowiedź gracza nie może być trafieniem)
+        if (line[0] == '\0') return 1;
+        return bank_builder_add_answer(b, line) == 0 ? 1 : -1;
+    }
+    return 0;
+}
+
+static int compare_fuzzy_entries(const void *a, const void *b) {
+    const BankFuzzyEntry *x = (const BankFuzzyEntry *)a;
+    const BankFuzzyEntry *y = (const BankFuzzyEntry *)b;
+    if (x->chars != y->chars) return x->chars < y->chars ? -1 : 1;
+    return x->id < y->id ? -1 : (x->id > y->id);
+}
+
+static uint64_t align8(uint64_t off) {
+    return (off + 7) & ~(uint64_t)7;
+}
+
+static uint32_t index_capacity(uint32_t count) {
+    uint32_t capacity = 16;
+    while (capacity < count * 2) capacity <<= 1;
+    return capacity;
+}
+
+int bank_builder_finish(BankBuilder *b, char **image, size_t *size) {
+    *image = NULL;
+    *size = 0;
+
+    // Klucze (odpowiedzi po normalizacji) trafiają do tej samej puli; normalizacja nie wydłuża napisu
+    uint32_t *keys = (uint32_t *)malloc(sizeof(uint32_t) * (b->answerCount ? b->answerCount : 1));
+    uint32_t *keyLens = (uint32_t *)malloc(sizeof(uint32_t) * (b->answerCount ? b->answerCount : 1));
+    uint32_t *folded = (uint32_t *)malloc(sizeof(uint32_t) * (b->answerCount ? b->answerCount : 1));
+    uint32_t *foldedLens = (uint32_t *)malloc(sizeof(uint32_t) * (b->answerCount ? b->answerCount : 1));
+    char *norm = NULL;
+    size_t normCap = 0;
+    if (!keys || !keyLens || !folded || !foldedLens) goto fail;
+    // Pula nigdy nie jest pusta (ostatni bajt obrazu to zawsze '\0')
+    if (b->poolLen == 0 && pool_add(b, "", 0) < 0) goto fail;
+    for (size_t i = 0; i < b->answerCount; i++) {
+        size_t len = strlen(b->pool + b->answers[i]);
+        if (len + 1 > normCap) {
+            normCap = (len + 1) * 2;
+            char *tmp = (char *)realloc(norm, normCap);
+            if (!tmp) goto fail;
+            norm = tmp;
+        }
+        size_t klen = normalize_answer(b->pool + b->answers[i], norm, len + 1);
+        int64_t off = pool_add(b, norm, klen);
+        if (off < 0) goto fail;
+        keys[i] = (uint32_t)off;
+        keyLens[i] = (uint32_t)klen;
+
+        // Klucz bez diakrytyków; zwykle (ASCII) identyczny z poprzednim i nie zajmuje miejsca w puli
+        size_t flen = fold_answer(b->pool + b->answers[i], norm, len + 1);
+        if (flen != klen || memcmp(norm, b->pool + keys[i], klen) != 0) {
+            off = pool_add(b, norm, flen);
+            if (off < 0) goto fail;
+        }
+        folded[i] = (uint32_t)off;
+        foldedLens[i] = (uint32_t)flen;
+    }
+
+    {
+        // Rozmieszczenie: nagłówek, opisy pytań, tablice pytań, pula
+        uint64_t off = sizeof(BankHeader);
+        uint64_t questionsOff = off;
+        off += sizeof(BankQuestion) * (uint64_t)b->questions;
+        for (int q = 0; q < b->questions; q++) {
+            off += sizeof(uint32_t) * (3 * (uint64_t)b->qCount[q] + 2 * (uint64_t)index_capacity(b->qCount[q]));
+            off = align8(off) + sizeof(BankFuzzyEntry) * (uint64_t)b->qCount[q];
+        }
+        uint64_t poolOff = off;
+        uint64_t total = poolOff + b->poolLen;
+
+        char *img = (char *)calloc(1, (size_t)total);
+        if (!img) goto fail;
+
+        BankHeader *hdr = (BankHeader *)img;
+        memcpy(hdr->magic, BANK_MAGIC, sizeof(hdr->magic));
+        hdr->version = BANK_VERSION;
+        hdr->questionCount = (uint32_t)b->questions;
+        hdr->answerCount = b->answerCount;
+        hdr->questionsOff = questionsOff;
+        hdr->poolOff = poolOff;
+        hdr->poolSize = b->poolLen;
+        hdr->fileSize = total;
+        memcpy(img + poolOff, b->pool, b->poolLen);
+
+        BankQuestion *questions = (BankQuestion *)(img + questionsOff);
+        uint64_t arr = questionsOff + sizeof(BankQuestion) * (uint64_t)b->questions;
+        for (int q = 0; q < b->questions; q++) {
+            BankQuestion *bq = &questions[q];
+            uint32_t count = b->qCount[q];
+            uint32_t first = b->qFirst[q];
+            uint32_t capacity = index_capacity(count);
+            bq->textOff = b->qText[q];
+            bq->answerCount = count;
+            bq->indexCapacity = capacity;
+            bq->maxEdits = b->qMaxEdits[q];
+            bq->answersOff = arr;  arr += sizeof(uint32_t) * (uint64_t)count;
+            bq->keysOff = arr;     arr += sizeof(uint32_t) * (uint64_t)count;
+            bq->keyLensOff = arr;  arr += sizeof(uint32_t) * (uint64_t)count;
+            bq->slotsOff = arr;    arr += sizeof(uint32_t) * (uint64_t)capacity;
+            bq->hashesOff = arr;   arr += sizeof(uint32_t) * (uint64_t)capacity;
+            arr = align8(arr);
+            bq->fuzzyOff = arr;    arr += sizeof(BankFuzzyEntry) * (uint64_t)count;
+
+            uint32_t *answersArr = (uint32_t *)(img + bq->answersOff);
+            uint32_t *keysArr = (uint32_t *)(img + bq->keysOff);
+            uint32_t *lensArr = (uint32_t *)(img + bq->keyLensOff);
+            uint32_t *slots = (uint32_t *)(img + bq->slotsOff);
+            uint32_t *hashes = (uint32_t *)(img + bq->hashesOff);
+            BankFuzzyEntry *fuzzy = (BankFuzzyEntry *)(img + bq->fuzzyOff);
+            for (uint32_t id = 0; id < count; id++) {
+                answersArr[id] = b->answers[first + id];
+                keysArr[id] = keys[first + id];
+                lensArr[id] = keyLens[first + id];
+
+                const char *key = b->pool + keysArr[id];
+                uint32_t h = answer_hash(key, lensArr[id]);
+                uint32_t pos = h & (capacity - 1);
+                int duplicate = 0;
+                while (slots[pos] != 0) {
+                    uint32_t other = slots[pos] - 1;
+                    if (hashes[pos] == h && lensArr[other] == lensArr[id]
+                        && memcmp(b->pool + keysArr[other], key, lensArr[id]) == 0) {
+                        // Duplikaty w bazie zostawiają pierwsze wystąpienie
+                        duplicate = 1;
+                        break;
+                    }
+                    pos = (pos + 1) & (capacity - 1);
+                }
+                if (duplicate) continue;
+                slots[pos] = id + 1;
+                hashes[pos] = h;
+
+                BankFuzzyEntry *e = &fuzzy[bq->fuzzyCount++];
+                e->keyOff = folded[first + id];
+                e->keyLen = foldedLens[first + id];
+                e->sig = fuzzy_signature(b->pool + e->keyOff, e->keyLen, &e->chars);
+                e->bigrams = fuzzy_bigrams(b->pool + e->keyOff, e->keyLen);
+                e->id = id;
+            }
+            qsort(fuzzy, bq->fuzzyCount, sizeof(BankFuzzyEntry), compare_fuzzy_entries);
+        }
+
+        *image = img;
+        *size = (size_t)total;
+    }
+    free(keys);
+    free(keyLens);
+    free(folded);
+    free(foldedLens);
+    free(norm);
+    return 0;
+
+fail:
+    fprintf(stderr, "Błąd alokacji pamięci przy budowie obrazu bazy pytań.\n");
+    free(keys);
+    free(keyLens);
+    free(folded);
+    free(foldedLens);
+    free(norm);
+    return -1;
+}
+
+int bank_compile_file(const char *filename, char **image, size_t *size) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        fprintf(stderr, "Brak pliku %s lub nie można wczytać.\n", filename);
+        return -1;
+    }
+
+    BankBuilder b;
+    bank_builder_init(&b);
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t n;
+    int rc = 0;
+    while ((n = getline(&line, &lineCap, fp)) != -1) {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+        if (bank_builder_feed_line(&b, line) < 0) {
+            fprintf(stderr, "Błąd alokacji pamięci dla bazy pytań.\n");
+            rc = -1;
+            break;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (rc == 0) rc = bank_builder_finish(&b, image, size);
+    bank_builder_free(&b);
+    return rc;
+}
@@ -0,0 +1,118 @@
+#ifndef BANK_IMAGE_H
+#define BANK_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Skompilowana baza pytań: jeden plik (obraz), który serwer mapuje przez mmap i czyta bez kopiowania.
+// Układ: nagłówek | opisy pytań | tablice każdego pytania | pula napisów (zakończonych '\0').
+// Liczby zapisane w porządku bajtów maszyny, która skompilowała obraz (little-endian na x86/ARM).
+#define BANK_MAGIC   "QUIZBANK"
+#define BANK_VERSION 2
+
+// BankQuestion.maxEdits: pytanie bez własnego FUZZY=<n> (obowiązuje FUZZY_MAX_EDITS z konfiguracji)
+#define BANK_FUZZY_DEFAULT 0xFFFFFFFFu
+// Dopuszczalna liczba literówek zależy też od długości odpowiedzi: jedna na każde tyle znaków
+#define FUZZY_CHARS_PER_EDIT 4
+
+typedef struct BankHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t questionCount;
+    uint64_t answerCount;       // suma odpowiedzi wszystkich pytań
+    uint64_t questionsOff;      // BankQuestion[questionCount]
+    uint64_t poolOff;
+    uint64_t poolSize;
+    uint64_t fileSize;
+} BankHeader;
+
+typedef struct BankQuestion {
+    uint32_t textOff;           // treść pytania (offset w puli)
+    uint32_t answerCount;
+    uint32_t indexCapacity;     // liczba slotów indeksu (potęga dwójki)
+    uint32_t maxEdits;          // limit literówek z FUZZY=<n> albo BANK_FUZZY_DEFAULT
+    uint32_t fuzzyCount;        // wpisy indeksu przybliżonego (bez duplikatów)
+    uint32_t reserved;
+    uint64_t answersOff;        // uint32[answerCount]: odpowiedzi w oryginalnej postaci (offsety w puli)
+    uint64_t keysOff;           // uint32[answerCount]: odpowiedzi po normalize_answer() (offsety w puli)
+    uint64_t keyLensOff;        // uint32[answerCount]: długości kluczy
+    uint64_t slotsOff;          // uint32[indexCapacity]: id odpowiedzi + 1 (0 = pusty slot)
+    uint64_t hashesOff;         // uint32[indexCapacity]: answer_hash() klucza w slocie
+    uint64_t fuzzyOff;          // BankFuzzyEntry[fuzzyCount] posortowane po długości klucza
+} BankQuestion;
+
+// Wpis indeksu przybliżonego: odpowiedź po fold_answer() z filtrami długości, znaków i par znaków
+typedef struct BankFuzzyEntry {
+    uint64_t sig;               // fuzzy_signature() klucza
+    uint64_t bigrams;           // fuzzy_bigrams() klucza
+    uint32_t keyOff;            // klucz po fold_answer() (offset w puli)
+    uint32_t keyLen;            // długość klucza w bajtach
+    uint32_t chars;             // długość klucza w znakach
+    uint32_t id;                // id odpowiedzi
+} BankFuzzyEntry;
+
+// Załadowany obraz (zmapowany z pliku albo zbudowany w pamięci)
+typedef struct QuestionBank {
+    const char *data;
+    size_t size;
+    int mapped;                 // 1 = munmap przy zamknięciu, 0 = free
+    const BankQuestion *questions;
+    const char *pool;
+    uint64_t poolSize;
+    int questionCount;
+} QuestionBank;
+
+// Mapuje obraz z pliku i sprawdza jego strukturę. Zwraca 0 albo -1 (komunikat na stderr).
+int bank_image_open(QuestionBank *bank, const char *path);
+// Przejmuje obraz zbudowany w pamięci (malloc). Przy błędzie zwalnia 'data' i zwraca -1.
+int bank_image_from_memory(QuestionBank *bank, char *data, size_t size);
+void bank_image_close(QuestionBank *bank);
+
+const char *bank_question_text(const QuestionBank *bank, int q);
+int bank_answer_count(const QuestionBank *bank, int q);
+const char *bank_answer_text(const QuestionBank *bank, int q, int id);
+// Id pasującej odpowiedzi (po normalizacji) albo -1
+int bank_find_answer(const QuestionBank *bank, int q, const char *response);
+// Jak bank_find_answer(), a przy braku dokładnego trafienia dopasowanie przybliżone: bez znaków
+// diakrytycznych i z odległością edycyjną do limitu pytania (FUZZY=<n>, inaczej 'defaultMaxEdits'),
+// ale nie większą niż długość odpowiedzi / FUZZY_CHARS_PER_EDIT. Wygrywa najbliższa odpowiedź
+// (przy remisie: o niższym id). Limit 0 = tylko dokładne trafienia.
+int bank_match_answer(const QuestionBank *bank, int q, const char *response, int defaultMaxEdits);
+
+// Budowanie obrazu z sekcji [QUESTION]/[ANSWER] pliku konfiguracyjnego
+typedef struct BankBuilder {
+    char *pool;
+    size_t poolLen;
+    size_t poolCap;
+
+    uint32_t *qText;            // offset treści pytania w puli
+    uint32_t *qFirst;           // indeks pierwszej odpowiedzi pytania w 'answers'
+    uint32_t *qCount;
+    uint32_t *qMaxEdits;        // FUZZY=<n> pytania albo BANK_FUZZY_DEFAULT
+    int questions;
+    int questionsCap;
+
+    uint32_t *answers;          // offsety odpowiedzi w puli, kolejno dla wszystkich pytań
+    size_t answerCount;
+    size_t answersCap;
+
+    int state;                  // 0 = poza sekcją, 1 = czekamy na treść pytania, 2 = odpowiedzi,
+                                // 3 = po treści pytania (przed [ANSWER] może być FUZZY=<n>)
+} BankBuilder;
+
+void bank_builder_init(BankBuilder *b);
+void bank_builder_free(BankBuilder *b);
+int bank_builder_add_question(BankBuilder *b, const char *text);
+int bank_builder_add_answer(BankBuilder *b, const char *answer);
+// Limit literówek (FUZZY=<n>) dla ostatnio dodanego pytania
+void bank_builder_set_max_edits(BankBuilder *b, uint32_t maxEdits);
+// Przekazuje linię pliku (bez '\n'). Zwraca 1, gdy linia należy do bazy pytań,
+// 0 gdy to zwykła linia konfiguracji, -1 przy błędzie alokacji.
+int bank_builder_feed_line(BankBuilder *b, const char *line);
+// Składa obraz (wraz z indeksami haszującymi) w jednym buforze z malloc
+int bank_builder_finish(BankBuilder *b, char **image, size_t *size);
+
+// Wczytuje plik .ini (tylko sekcje bazy) i składa z niego obraz
+int bank_compile_file(const char *filename, char **image, size_t *size);
+
+#endif
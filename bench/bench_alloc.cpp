@@ -0,0 +1,113 @@
+// Licznik alokacji na ścieżce rundy: odpowiedzi graczy, koniec rundy (punkty, ranking, rozsyłka)
+// i start kolejnej rundy. Pierwsza gra rozgrzewa arenę, pulę ramek i tablice pokoju;
+// w kolejnych grach runda nie powinna już wołać malloc/calloc/realloc.
+// Połączenia piszą do /dev/null, rundy kończą się po odpowiedzi większości (check_round_complete).
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -pthread -o bench_alloc bench/bench_alloc.cpp game_room.cpp
+//       question_bank.cpp answer_index.cpp connection.cpp frame.cpp timer_wheel.cpp player_registry.cpp
+//       leaderboard.cpp bank_image.cpp fuzzy_match.cpp arena.cpp metrics.cpp protocol.cpp session.cpp profile_log.cpp capture.cpp uring.cpp
+//       join_queue.cpp logger.cpp
+// Użycie: ./bench_alloc [gracze]   (uruchamiać w katalogu z config.ini)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../game_room.h"
+#include "../connection.h"
+
+// Podmiana alokatora: zliczamy wywołania i przekazujemy je do glibc
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static unsigned long allocCalls = 0;
+
+extern "C" void *malloc(size_t size) {
+    allocCalls++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+    allocCalls++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    allocCalls++;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+static const char *answers[] = {"Polska", "niemcy", "Francja ", "Atlantyda", "BIAŁORUŚ"};
+
+// Jedna gra: g_max_rounds rund, w każdej odpowiada większość graczy. Zwraca liczbę alokacji.
+static unsigned long play_game(GameRoom *room, int players) {
+    unsigned long before = allocCalls;
+    for (int r = 0; r < g_max_rounds; r++) {
+        int round = room->current_round;
+        for (int i = 0; i < players && room->current_round == round && room->round_in_progress; i++) {
+            Player *p = &room->players.items[i];
+            room_handle_message(room, p, answers[(i + r) % 5]);
+        }
+        conn_flush_all(NULL, NULL);
+    }
+    // Koniec rankingu końcowego - nowa gra (zegar pokoju wywołujemy ręcznie)
+    room_on_timer(room);
+    conn_flush_all(NULL, NULL);
+    return allocCalls - before;
+}
+
+int main(int argc, char **argv) {
+    int players = argc > 1 ? atoi(argv[1]) : 200;
+    if (players < 1) players = 1;
+
+    g_time_limit = 30;
+    if (load_config("config.ini", &g_time_limit, &g_max_rounds) != 0) return 1;
+    if (load_answers_from_config("config.ini") != 0) {
+        fprintf(stderr, "Uruchom w katalogu z config.ini\n");
+        return 1;
+    }
+    g_output_high_water = (size_t)1 << 34;
+
+    // Logi DEBUG z pokoju nie są tu istotne
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+    int devnull = open("/dev/null", O_WRONLY);
+
+    GameRoom *room = room_create(1, NULL);
+    Connection **conns = (Connection **)malloc(sizeof(Connection *) * players);
+    for (int i = 0; i < players; i++) {
+        // Osobny deskryptor na gracza - rejestr pokoju indeksuje graczy po fd
+        conns[i] = conn_create(dup(devnull), -1);
+        Player *p = room_add_player(room, conns[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "gracz%d", i);
+        room_handle_message(room, p, name);
+    }
+    // Koniec oczekiwania w lobby - start pierwszej rundy
+    room_on_timer(room);
+    conn_flush_all(NULL, NULL);
+
+    printf("%d graczy, %d rund na grę\n", players, g_max_rounds);
+    for (int game = 1; game <= 3; game++) {
+        unsigned long calls = play_game(room, players);
+        printf("gra %d: %8lu alokacji (%.1f na rundę)%s\n", game, calls, (double)calls / g_max_rounds,
+               game == 1 ? " - rozgrzewka" : "");
+    }
+
+    room_destroy(room);
+    for (int i = 0; i < players; i++) {
+        close(conns[i]->fd);
+        conn_free(conns[i]);
+    }
+    free(conns);
+    close(devnull);
+    free_resources();
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Benchmark: liniowe przeszukiwanie answersDB (stare is_in_database) vs indeks haszujący obrazu bazy (bank_find_answer).
+// Kompilacja: g++ -O2 -o bench_answers bench/bench_answers.cpp bank_image.cpp answer_index.cpp fuzzy_match.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+
+#include "../bank_image.h"
+
+// Kopia dotychczasowego porównania z serwera (punkt odniesienia)
+static int strcase_compare(const char *a, const char *b) {
+    while (*a && *b) {
+        char ca = tolower((unsigned char)*a);
+        char cb = tolower((unsigned char)*b);
+        if (ca != cb) {
+            return (int)(unsigned char)ca - (int)(unsigned char)cb;
+        }
+        a++;
+        b++;
+    }
+    return (int)(unsigned char)tolower((unsigned char)*a)
+         - (int)(unsigned char)tolower((unsigned char)*b);
+}
+
+static int linear_scan(char **answers, int count, const char *response) {
+    for (int i = 0; i < count; i++) {
+        if (strcase_compare(answers[i], response) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Syntetyczna baza: "Miasto-<n>" - podobne prefiksy, jak w prawdziwych pytaniach
+static char **make_bank(int count) {
+    char **answers = (char **)malloc(sizeof(char *) * count);
+    char buf[64];
+    for (int i = 0; i < count; i++) {
+        snprintf(buf, sizeof(buf), "Miasto-%d", i * 7919 % 1000003);
+        answers[i] = strdup(buf);
+    }
+    return answers;
+}
+
+// Obraz bazy z jednym pytaniem i podanymi odpowiedziami (jak z sekcji config.ini)
+static int build_bank(QuestionBank *bank, char **answers, int count) {
+    BankBuilder b;
+    bank_builder_init(&b);
+    bank_builder_add_question(&b, "Pytanie testowe");
+    for (int i = 0; i < count; i++) bank_builder_add_answer(&b, answers[i]);
+    char *image = NULL;
+    size_t size = 0;
+    int rc = bank_builder_finish(&b, &image, &size);
+    bank_builder_free(&b);
+    if (rc == 0) rc = bank_image_from_memory(bank, image, size);
+    return rc;
+}
+
+static void run(int bankSize, int queries) {
+    char **answers = make_bank(bankSize);
+    QuestionBank bank;
+    if (build_bank(&bank, answers, bankSize) != 0) {
+        fprintf(stderr, "Błąd budowy indeksu\n");
+        exit(1);
+    }
+
+    // Zapytania: połowa trafień (wielkimi literami), połowa pudeł
+    char **q = (char **)malloc(sizeof(char *) * queries);
+    for (int i = 0; i < queries; i++) {
+        char buf[64];
+        if (i % 2 == 0) {
+            snprintf(buf, sizeof(buf), "MIASTO-%d", (i / 2 % bankSize) * 7919 % 1000003);
+        } else {
+            snprintf(buf, sizeof(buf), "Wies-%d", i);
+        }
+        q[i] = strdup(buf);
+    }
+
+    long hitsLinear = 0, hitsIndex = 0;
+    double t0 = now_sec();
+    for (int i = 0; i < queries; i++) hitsLinear += linear_scan(answers, bankSize, q[i]) >= 0;
+    double t1 = now_sec();
+    for (int i = 0; i < queries; i++) hitsIndex += bank_find_answer(&bank, 0, q[i]) >= 0;
+    double t2 = now_sec();
+
+    double linNs = (t1 - t0) * 1e9 / queries;
+    double idxNs = (t2 - t1) * 1e9 / queries;
+    printf("%8d odpowiedzi | skan: %10.1f ns/zapytanie | indeks: %7.1f ns/zapytanie | x%.1f | trafienia %ld/%ld\n",
+           bankSize, linNs, idxNs, linNs / idxNs, hitsLinear, hitsIndex);
+
+    for (int i = 0; i < queries; i++) free(q[i]);
+    free(q);
+    bank_image_close(&bank);
+    for (int i = 0; i < bankSize; i++) free(answers[i]);
+    free(answers);
+}
+
+int main() {
+    // Kontrola poprawności składania wielkości liter poza ASCII
+    char *polish[] = {(char *)"Białoruś", (char *)"Łotwa"};
+    QuestionBank bank;
+    if (build_bank(&bank, polish, 2) != 0) return 1;
+    printf("BIAŁORUŚ -> %d, ŁOTWA -> %d, Litwa -> %d\n",
+           bank_find_answer(&bank, 0, "BIAŁORUŚ"), bank_find_answer(&bank, 0, " ŁOTWA\r"),
+           bank_find_answer(&bank, 0, "Litwa"));
+    bank_image_close(&bank);
+
+    int sizes[] = {50, 500, 5000, 50000};
+    for (int i = 0; i < 4; i++) {
+        int queries = sizes[i] >= 5000 ? 20000 : 200000;
+        run(sizes[i], queries);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Benchmark rozsyłania rankingu na koniec rundy: dawne "linia po linii, send() do każdego gracza"
+// vs ranking formatowany raz do współdzielonej ramki i jeden writev() na połączenie.
+// Połączenia piszą do /dev/null, więc mierzymy koszt po stronie serwera (formatowanie + wywołania systemowe).
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -pthread -o bench_broadcast bench/bench_broadcast.cpp game_room.cpp
+//       question_bank.cpp answer_index.cpp connection.cpp frame.cpp timer_wheel.cpp player_registry.cpp
+//       leaderboard.cpp bank_image.cpp fuzzy_match.cpp arena.cpp metrics.cpp protocol.cpp session.cpp profile_log.cpp capture.cpp uring.cpp
+//       join_queue.cpp logger.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../game_room.h"
+#include "../connection.h"
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Dawny send_sorted_ranking(): snprintf na linię i osobny zapis do każdego gracza.
+// Przy dużych pokojach liczymy tylko część linii i ekstrapolujemy.
+static void run_old(int devnull, int players, double *seconds, double *syscalls) {
+    int lines = players + 1;
+    int sampled = lines > 500 ? 500 : lines;
+    char msg[BUFFER_SIZE];
+    double t0 = now_sec();
+    for (int j = 0; j < sampled; j++) {
+        snprintf(msg, BUFFER_SIZE, "%d. gracz%d, Punkty za pytanie: %d, Łącznie: %d, Odpowiedź: %s\n",
+                 j + 1, j, 15, 100 - j % 100, "Polska");
+        size_t len = strlen(msg);
+        for (int p = 0; p < players; p++) {
+            if (write(devnull, msg, len) < 0) perror("write");
+        }
+    }
+    double t = now_sec() - t0;
+    *seconds = t * lines / sampled;
+    *syscalls = (double)lines * players;
+}
+
+// Obecna ścieżka: end_round() przez zegar pokoju i zbiorcza wysyłka na końcu iteracji
+static void run_new(int devnull, int players, double *seconds, double *syscalls) {
+    GameRoom *room = room_create(1, NULL);
+    Connection **conns = (Connection **)malloc(sizeof(Connection *) * players);
+    for (int i = 0; i < players; i++) {
+        conns[i] = conn_create(devnull, -1);
+        Player *p = room_add_player(room, conns[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "gracz%d", i);
+        registry_set_name(&room->players, p, name);
+        p->got_name = 1;
+        p->in_game = 1;
+        p->answered = 1;
+        p->response = arena_strdup(&room->roundArena, i % 3 ? "Polska" : "Niemcy");
+        p->answerTime = (i % 30) / 10.0;
+    }
+    room->round_in_progress = 1;
+    room->in_game_count = players;
+    room->answered_count = players;
+    room->current_round = 0;
+    room->round_start_ns = monotonic_ns() - (uint64_t)(g_time_limit + 1) * 1000000000ull;
+
+    unsigned long before = t_write_calls;
+    double t0 = now_sec();
+    room_on_timer(room);
+    conn_flush_all(NULL, NULL);
+    *seconds = now_sec() - t0;
+    *syscalls = (double)(t_write_calls - before);
+
+    room_destroy(room);
+    for (int i = 0; i < players; i++) conn_free(conns[i]);
+    free(conns);
+}
+
+int main() {
+    g_time_limit = 30;
+    g_max_rounds = 10;
+    if (load_answers_from_config("config.ini") != 0) {
+        fprintf(stderr, "Uruchom w katalogu z config.ini\n");
+        return 1;
+    }
+    g_output_high_water = (size_t)1 << 34;
+
+    int devnull = open("/dev/null", O_WRONLY);
+    // Logi DEBUG z pokoju nie są tu istotne
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+
+    int sizes[] = {1000, 10000};
+    for (int i = 0; i < 2; i++) {
+        double oldT, oldS, newT, newS;
+        run_old(devnull, sizes[i], &oldT, &oldS);
+        run_new(devnull, sizes[i], &newT, &newS);
+        printf("%6d graczy | dawniej: %12.0f zapisów, %8.3f s%s | teraz: %6.0f zapisów, %8.3f s | x%.0f\n",
+               sizes[i], oldS, oldT, sizes[i] + 1 > 500 ? " (ekstrapolacja)" : "", newS, newT, oldT / newT);
+    }
+
+    close(devnull);
+    free_resources();
+    return 0;
+}
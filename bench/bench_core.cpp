@@ -0,0 +1,341 @@
+// Zestaw mikrobenchmarków podstawowych funkcji gry na syntetycznych bazach i pokojach od 10 do 100k graczy:
+// porównanie odpowiedzi (strcase_compare), wyszukiwanie odpowiedzi w bazie (dawne is_in_database),
+// dopasowanie przybliżone (literówki),
+// end_round() (punkty + ranking), przygotowanie rankingu i rozesłanie kolejek.
+//
+// Wyniki (ns na operację) można zapisać jako punkt odniesienia i porównywać z nim kolejne przebiegi:
+//   ./bench_core --save bench/baseline.txt
+//   ./bench_core --baseline bench/baseline.txt [--tolerance 2.0]
+// Przy porównaniu wynik gorszy niż punkt odniesienia * tolerancja to regresja (kod wyjścia 1).
+// W CMake: cmake --build <katalog> --target bench
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../game_room.h"
+#include "../connection.h"
+#include "../metrics.h"
+
+#define MAX_RESULTS 64
+#define BANK_ANSWERS 1000
+
+typedef struct Result {
+    char name[48];
+    double ns;
+} Result;
+
+static Result results[MAX_RESULTS];
+static int resultCount = 0;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double ns) {
+    if (resultCount == MAX_RESULTS) return;
+    snprintf(results[resultCount].name, sizeof(results[resultCount].name), "%s", name);
+    results[resultCount].ns = ns;
+    resultCount++;
+    printf("%-28s %14.1f ns\n", name, ns);
+}
+
+// Każdy pomiar powtarzamy i bierzemy najlepszy wynik - mniej szumu od innych procesów
+#define REPEATS 5
+
+// Zapobiega wyrzuceniu przez kompilator obliczeń, których wynik nie jest używany
+static volatile long sink;
+
+static void bench_strcase() {
+    static const char *pairs[][2] = {
+        {"Warszawa", "WARSZAWA"}, {"Polska", "Portugalia"}, {"Bośnia i Hercegowina", "bośnia i hercegowina"},
+        {"Niemcy", "Niemcy "}, {"Francja", "francja"}, {"Albania", "Andora"},
+    };
+    const int pairCount = sizeof(pairs) / sizeof(pairs[0]);
+    const int iterations = 1000000;
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        long acc = 0;
+        double t0 = now_sec();
+        for (int i = 0; i < iterations; i++) {
+            acc += strcase_compare(pairs[i % pairCount][0], pairs[i % pairCount][1]);
+        }
+        double t = now_sec() - t0;
+        sink = acc;
+        if (r == 0 || t < best) best = t;
+    }
+    report("strcase_compare", best * 1e9 / iterations);
+}
+
+// Wyszukiwanie odpowiedzi w obrazie bazy: połowa trafień (inną wielkością liter), połowa pudeł
+static void bench_find_answer(int answers) {
+    BankBuilder b;
+    bank_builder_init(&b);
+    char buf[64];
+    bank_builder_add_question(&b, "Pytanie testowe");
+    for (int i = 0; i < answers; i++) {
+        snprintf(buf, sizeof(buf), "Miasto-%d", i * 7919 % 1000003);
+        bank_builder_add_answer(&b, buf);
+    }
+    char *image = NULL;
+    size_t size = 0;
+    QuestionBank bank;
+    if (bank_builder_finish(&b, &image, &size) != 0 || bank_image_from_memory(&bank, image, size) != 0) {
+        fprintf(stderr, "Błąd budowy bazy\n");
+        exit(1);
+    }
+    bank_builder_free(&b);
+
+    const int queryCount = 4096;
+    char (*queries)[64] = (char (*)[64])malloc(sizeof(*queries) * queryCount);
+    for (int i = 0; i < queryCount; i++) {
+        if (i % 2) snprintf(queries[i], 64, "MIASTO-%d", (i % answers) * 7919 % 1000003);
+        else snprintf(queries[i], 64, "Wioska-%d", i);
+    }
+
+    const int iterations = 500000;
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        long acc = 0;
+        double t0 = now_sec();
+        for (int i = 0; i < iterations; i++) acc += bank_find_answer(&bank, 0, queries[i & (queryCount - 1)]);
+        double t = now_sec() - t0;
+        sink = acc;
+        if (r == 0 || t < best) best = t;
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "find_answer/%d", answers);
+    report(name, best * 1e9 / iterations);
+    free(queries);
+    bank_image_close(&bank);
+}
+
+// Dopasowanie przybliżone odpowiedzi spoza bazy: połowa z literówką, połowa bez żadnego dopasowania
+static void bench_match_fuzzy(int answers) {
+    BankBuilder b;
+    bank_builder_init(&b);
+    char buf[64];
+    bank_builder_add_question(&b, "Pytanie testowe");
+    bank_builder_set_max_edits(&b, 2);
+    for (int i = 0; i < answers; i++) {
+        snprintf(buf, sizeof(buf), "Miasto-%d", i * 7919 % 1000003);
+        bank_builder_add_answer(&b, buf);
+    }
+    char *image = NULL;
+    size_t size = 0;
+    QuestionBank bank;
+    if (bank_builder_finish(&b, &image, &size) != 0 || bank_image_from_memory(&bank, image, size) != 0) {
+        fprintf(stderr, "Błąd budowy bazy\n");
+        exit(1);
+    }
+    bank_builder_free(&b);
+
+    const int queryCount = 1024;
+    char (*queries)[64] = (char (*)[64])malloc(sizeof(*queries) * queryCount);
+    for (int i = 0; i < queryCount; i++) {
+        if (i % 2) snprintf(queries[i], 64, "miasot-%d", (i % answers) * 7919 % 1000003);
+        else snprintf(queries[i], 64, "Wioska-%d", i);
+    }
+
+    const int iterations = 20000;
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        long acc = 0;
+        double t0 = now_sec();
+        for (int i = 0; i < iterations; i++) acc += bank_match_answer(&bank, 0, queries[i & (queryCount - 1)], 0);
+        double t = now_sec() - t0;
+        sink = acc;
+        if (r == 0 || t < best) best = t;
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "match_fuzzy/%d", answers);
+    report(name, best * 1e9 / iterations);
+    free(queries);
+    bank_image_close(&bank);
+}
+
+// end_round() w pokoju z 'players' graczami, z których wszyscy odpowiedzieli. Osobno: ranking
+// (czołówka i miejsca graczy, czas z histogramu metryk) i rozesłanie kolejek do /dev/null.
+static void bench_end_round(int devnull, int players) {
+    GameRoom *room = room_create(1, NULL);
+    Connection **conns = (Connection **)malloc(sizeof(Connection *) * players);
+    for (int i = 0; i < players; i++) {
+        conns[i] = conn_create(devnull, -1);
+        Player *p = room_add_player(room, conns[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "gracz%d", i);
+        registry_set_name(&room->players, p, name);
+        p->got_name = 1;
+    }
+
+    int iterations = 100000 / players;
+    if (iterations < REPEATS) iterations = REPEATS;
+
+    Metrics *m = (Metrics *)calloc(1, sizeof(Metrics));
+    Metrics *saved = t_metrics;
+    t_metrics = m;
+    double roundTime = 0, rankingTime = 0, flushTime = 0;   // najlepsza iteracja
+    for (int it = 0; it < iterations; it++) {
+        // Stan jak po odpowiedziach wszystkich graczy (poza pomiarem)
+        for (int i = 0; i < players; i++) {
+            Player *p = &room->players.items[i];
+            char answer[32];
+            if (i % 3 == 0) snprintf(answer, sizeof(answer), "Miasto-1");
+            else if (i % 3 == 1) snprintf(answer, sizeof(answer), "miasto-%d", (i * 31 + it) % BANK_ANSWERS);
+            else snprintf(answer, sizeof(answer), "Atlantyda-%d", i);
+            p->in_game = 1;
+            p->answered = 1;
+            p->response = arena_strdup(&room->roundArena, answer);
+            p->answerTime = (i % 30) / 10.0;
+        }
+        room->round_in_progress = 1;
+        room->in_game_count = players;
+        room->answered_count = players;
+        room->current_round = 0;
+        room->round_start_ns = monotonic_ns() - (uint64_t)(g_time_limit + 1) * 1000000000ull;
+
+        uint64_t rankingBefore = m->ranking.sum;
+        double t0 = now_sec();
+        room_on_timer(room);
+        double t1 = now_sec();
+        conn_flush_all(NULL, NULL);
+        double t2 = now_sec();
+        double ranking = (double)(m->ranking.sum - rankingBefore) / 1e9;
+        if (it == 0 || t1 - t0 < roundTime) roundTime = t1 - t0;
+        if (it == 0 || ranking < rankingTime) rankingTime = ranking;
+        if (it == 0 || t2 - t1 < flushTime) flushTime = t2 - t1;
+    }
+    t_metrics = saved;
+
+    char name[48];
+    snprintf(name, sizeof(name), "end_round/%d", players);
+    report(name, roundTime * 1e9);
+    snprintf(name, sizeof(name), "ranking_send/%d", players);
+    report(name, rankingTime * 1e9);
+    snprintf(name, sizeof(name), "flush/%d", players);
+    report(name, flushTime * 1e9);
+
+    free(m);
+    room_destroy(room);
+    for (int i = 0; i < players; i++) conn_free(conns[i]);
+    free(conns);
+}
+
+// Syntetyczna baza dla pokoju: jedno pytanie z BANK_ANSWERS odpowiedziami, zapisana do pliku tymczasowego
+static int load_synthetic_bank() {
+    char path[] = "/tmp/bench_core_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) return -1;
+    FILE *fp = fdopen(fd, "w");
+    if (!fp) {
+        close(fd);
+        return -1;
+    }
+    fprintf(fp, "TIME_LIMIT=30\nMAX_ROUNDS=1000000000\nRANKING_TOP_K=10\n[QUESTION]\nPytanie testowe\n[ANSWER]\n");
+    for (int i = 0; i < BANK_ANSWERS; i++) fprintf(fp, "Miasto-%d\n", i);
+    fclose(fp);
+
+    int rc = load_config(path, &g_time_limit, &g_max_rounds);
+    if (rc == 0) rc = load_answers_from_config(path);
+    unlink(path);
+    return rc;
+}
+
+static int load_baseline(const char *path, Result *base, int *count) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    *count = 0;
+    char line[128];
+    while (*count < MAX_RESULTS && fgets(line, sizeof(line), fp)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%47s %lf", base[*count].name, &base[*count].ns) == 2) (*count)++;
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Porównanie z punktem odniesienia; zwraca liczbę regresji
+static int compare_baseline(const Result *base, int baseCount, double tolerance) {
+    int regressions = 0;
+    printf("\nPorównanie z punktem odniesienia (tolerancja x%.2f):\n", tolerance);
+    for (int i = 0; i < resultCount; i++) {
+        for (int j = 0; j < baseCount; j++) {
+            if (strcmp(results[i].name, base[j].name) != 0 || base[j].ns <= 0) continue;
+            double ratio = results[i].ns / base[j].ns;
+            int bad = ratio > tolerance;
+            regressions += bad;
+            printf("%-28s x%.2f%s\n", results[i].name, ratio, bad ? "  <-- REGRESJA" : "");
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    const char *baselinePath = NULL;
+    const char *savePath = NULL;
+    double tolerance = 2.0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Użycie: %s [--baseline plik] [--tolerance x] [--save plik]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Punkt odniesienia wczytujemy przed wyciszeniem stderr, żeby widzieć błąd otwarcia pliku
+    Result base[MAX_RESULTS];
+    int baseCount = 0;
+    if (baselinePath && load_baseline(baselinePath, base, &baseCount) != 0) return 1;
+
+    if (load_synthetic_bank() != 0) {
+        fprintf(stderr, "Nie udało się przygotować bazy testowej\n");
+        return 1;
+    }
+    g_output_high_water = (size_t)1 << 34;
+    int devnull = open("/dev/null", O_WRONLY);
+    // Logi DEBUG z pokoju nie są tu istotne
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+
+    bench_strcase();
+    int bankSizes[] = {10, 1000, 100000};
+    for (int i = 0; i < 3; i++) bench_find_answer(bankSizes[i]);
+    for (int i = 0; i < 2; i++) bench_match_fuzzy(bankSizes[i]);
+    int playerCounts[] = {10, 100, 1000, 10000, 100000};
+    for (int i = 0; i < 5; i++) bench_end_round(devnull, playerCounts[i]);
+
+    close(devnull);
+    free_resources();
+
+    if (savePath) {
+        FILE *fp = fopen(savePath, "w");
+        if (!fp) {
+            perror(savePath);
+            return 1;
+        }
+        fprintf(fp, "# bench_core: ns na operację (./bench_core --save %s)\n", savePath);
+        for (int i = 0; i < resultCount; i++) fprintf(fp, "%s %.1f\n", results[i].name, results[i].ns);
+        fclose(fp);
+    }
+    if (baselinePath) {
+        int regressions = compare_baseline(base, baseCount, tolerance);
+        if (regressions > 0) {
+            printf("Regresje: %d\n", regressions);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+// Dopasowanie przybliżone odpowiedzi (literówki, brak polskich znaków):
+// 1) poprawność jądra bitowego (Myers/Hyyrö) względem klasycznego programowania dynamicznego,
+// 2) koszt jednego zapytania, które nie trafiło dokładnie: bank_match_answer() (filtr długości i zbioru
+//    znaków + jądro bitowe) vs Levenshtein DP po wszystkich odpowiedziach vs jądro bez filtrów,
+// 3) punktacja końca rundy: 10k graczy z literówkami na bazie z tysiącami odpowiedzi.
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -o bench_fuzzy bench/bench_fuzzy.cpp bank_image.cpp answer_index.cpp fuzzy_match.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../bank_image.h"
+#include "../answer_index.h"
+#include "../fuzzy_match.h"
+
+#define MAX_EDITS 2
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static volatile long sink;
+
+static uint32_t rng_state = 12345;
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 8) % n;
+}
+
+// Klasyczny Levenshtein po bajtach (punkt odniesienia; klucze w teście są w ASCII)
+static int levenshtein(const char *a, size_t n, const char *b, size_t m) {
+    int row[256];
+    for (size_t j = 0; j <= m; j++) row[j] = (int)j;
+    for (size_t i = 1; i <= n; i++) {
+        int diag = row[0];
+        row[0] = (int)i;
+        for (size_t j = 1; j <= m; j++) {
+            int up = row[j];
+            int best = diag + (a[i - 1] != b[j - 1]);
+            if (up + 1 < best) best = up + 1;
+            if (row[j - 1] + 1 < best) best = row[j - 1] + 1;
+            row[j] = best;
+            diag = up;
+        }
+    }
+    return row[m];
+}
+
+// Nazwa z sylab, czasem z polskimi znakami (jak nazwy miast i państw w bazie)
+static void make_name(char *out, size_t cap) {
+    static const char *syl[] = {"ka", "wa", "ro", "mi", "sta", "bel", "no", "gra", "dzie", "ło", "rz", "ś", "ą",
+                                "po", "lan", "ty", "ce", "wę", "ni", "ber", "ó", "do", "sk", "ża"};
+    size_t len = 0;
+    int parts = 2 + (int)rnd(4);
+    for (int i = 0; i < parts; i++) {
+        const char *s = syl[rnd(sizeof(syl) / sizeof(syl[0]))];
+        size_t n = strlen(s);
+        if (len + n + 1 >= cap) break;
+        memcpy(out + len, s, n);
+        len += n;
+    }
+    out[len] = '\0';
+    if (out[0] >= 'a' && out[0] <= 'z') out[0] -= 0x20;
+}
+
+// Jedna losowa edycja (zamiana, usunięcie, wstawienie) w napisie ASCII
+static void add_typo(char *s) {
+    size_t len = strlen(s);
+    if (len < 2) return;
+    size_t pos = rnd((uint32_t)len);
+    switch (rnd(3)) {
+    case 0: s[pos] = (char)('a' + rnd(26)); break;
+    case 1: memmove(s + pos, s + pos + 1, len - pos); break;
+    default:
+        memmove(s + pos + 1, s + pos, len - pos + 1);
+        s[pos] = (char)('a' + rnd(26));
+        break;
+    }
+}
+
+static void check_kernel() {
+    int mismatches = 0;
+    const int pairs = 200000;
+    for (int i = 0; i < pairs; i++) {
+        char a[80], b[80];
+        size_t n = 1 + rnd(FUZZY_MAX_PATTERN), m = rnd(70);
+        for (size_t k = 0; k < n; k++) a[k] = (char)('a' + rnd(4));
+        for (size_t k = 0; k < m; k++) b[k] = (char)('a' + rnd(4));
+        a[n] = b[m] = '\0';
+        int limit = (int)rnd(8);
+        int expect = levenshtein(a, n, b, m);
+        if (expect > limit) expect = limit + 1;
+        FuzzyPattern pat;
+        fuzzy_pattern_init(&pat, a, n);
+        if (fuzzy_distance(&pat, b, m, limit) != expect) mismatches++;
+    }
+    printf("Jądro bitowe vs DP: %d par, niezgodności: %d\n", pairs, mismatches);
+}
+
+static int build_bank(QuestionBank *bank, char **answers, int count, int maxEdits) {
+    BankBuilder b;
+    bank_builder_init(&b);
+    bank_builder_add_question(&b, "Pytanie testowe");
+    bank_builder_set_max_edits(&b, (uint32_t)maxEdits);
+    for (int i = 0; i < count; i++) bank_builder_add_answer(&b, answers[i]);
+    char *image = NULL;
+    size_t size = 0;
+    int rc = bank_builder_finish(&b, &image, &size);
+    bank_builder_free(&b);
+    if (rc == 0) rc = bank_image_from_memory(bank, image, size);
+    return rc;
+}
+
+static void examples() {
+    char *answers[] = {(char *)"Białoruś", (char *)"Luksemburg", (char *)"Łotwa", (char *)"Litwa", (char *)"Malta"};
+    QuestionBank bank;
+    if (build_bank(&bank, answers, 5, MAX_EDITS) != 0) exit(1);
+    const char *queries[] = {"Bialorus", "Luksemburgg", "lotwa", "Litwa", "Lotwa ", "Mlta", "Włochy"};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        int exact = bank_find_answer(&bank, 0, queries[i]);
+        int id = bank_match_answer(&bank, 0, queries[i], 0);
+        printf("%-12s -> dokładnie %2d, przybliżone %2d (%s)\n", queries[i], exact, id,
+               id >= 0 ? bank_answer_text(&bank, 0, id) : "-");
+    }
+    bank_image_close(&bank);
+}
+
+static void run(int bankSize, int queries) {
+    char **answers = (char **)malloc(sizeof(char *) * bankSize);
+    char **folded = (char **)malloc(sizeof(char *) * bankSize);
+    size_t *foldedLen = (size_t *)malloc(sizeof(size_t) * bankSize);
+    for (int i = 0; i < bankSize; i++) {
+        char buf[64];
+        make_name(buf, sizeof(buf));
+        answers[i] = strdup(buf);
+        folded[i] = (char *)malloc(sizeof(buf));
+        foldedLen[i] = fold_answer(buf, folded[i], sizeof(buf));
+    }
+    QuestionBank bank;
+    if (build_bank(&bank, answers, bankSize, MAX_EDITS) != 0) {
+        fprintf(stderr, "Błąd budowy bazy\n");
+        exit(1);
+    }
+
+    // Zapytania, które nie trafiają dokładnie: odpowiedź bez polskich znaków z jedną literówką
+    // albo słowo spoza bazy
+    char **q = (char **)malloc(sizeof(char *) * queries);
+    for (int i = 0; i < queries; i++) {
+        char buf[80];
+        if (i % 2 == 0) {
+            snprintf(buf, sizeof(buf), "%s", folded[rnd((uint32_t)bankSize)]);
+            add_typo(buf);
+        } else {
+            make_name(buf, sizeof(buf));
+            snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), "x%d", i);
+        }
+        q[i] = strdup(buf);
+    }
+
+    long hitsIndex = 0, hitsDp = 0, hitsKernel = 0;
+    double t0 = now_sec();
+    for (int i = 0; i < queries; i++) hitsIndex += bank_match_answer(&bank, 0, q[i], 0) >= 0;
+    double t1 = now_sec();
+    for (int i = 0; i < queries; i++) {
+        char key[128];
+        size_t len = fold_answer(q[i], key, sizeof(key));
+        int limit = MAX_EDITS;
+        if (limit > (int)len / FUZZY_CHARS_PER_EDIT) limit = (int)len / FUZZY_CHARS_PER_EDIT;
+        int found = -1;
+        for (int k = 0; k < bankSize && found < 0; k++) {
+            if (levenshtein(key, len, folded[k], foldedLen[k]) <= limit) found = k;
+        }
+        hitsDp += found >= 0;
+    }
+    double t2 = now_sec();
+    for (int i = 0; i < queries; i++) {
+        char key[128];
+        size_t len = fold_answer(q[i], key, sizeof(key));
+        FuzzyPattern pat;
+        if (fuzzy_pattern_init(&pat, key, len) != 0) continue;
+        int limit = MAX_EDITS;
+        if (limit > pat.len / FUZZY_CHARS_PER_EDIT) limit = pat.len / FUZZY_CHARS_PER_EDIT;
+        int found = -1;
+        for (int k = 0; k < bankSize && found < 0; k++) {
+            if (fuzzy_distance(&pat, folded[k], foldedLen[k], limit) <= limit) found = k;
+        }
+        hitsKernel += found >= 0;
+    }
+    double t3 = now_sec();
+
+    double idxNs = (t1 - t0) * 1e9 / queries;
+    double dpNs = (t2 - t1) * 1e9 / queries;
+    double kerNs = (t3 - t2) * 1e9 / queries;
+    printf("%6d odpowiedzi | indeks: %9.0f ns | DP: %11.0f ns (x%.0f) | jądro bez filtrów: %9.0f ns (x%.1f) | "
+           "trafienia %ld/%ld/%ld z %d\n", bankSize, idxNs, dpNs, dpNs / idxNs, kerNs, kerNs / idxNs,
+           hitsIndex, hitsDp, hitsKernel, queries);
+
+    // Koniec rundy: 10k graczy, połowa z literówkami (jak end_round() - najpierw indeks dokładny)
+    if (bankSize >= 1000) {
+        const int players = 10000;
+        double r0 = now_sec();
+        long acc = 0;
+        for (int i = 0; i < players; i++) acc += bank_match_answer(&bank, 0, q[i % queries], 0);
+        double r1 = now_sec();
+        sink = acc;
+        printf("       koniec rundy: %d graczy z chybionymi odpowiedziami -> %.2f ms\n", players, (r1 - r0) * 1e3);
+    }
+
+    for (int i = 0; i < queries; i++) free(q[i]);
+    free(q);
+    bank_image_close(&bank);
+    for (int i = 0; i < bankSize; i++) {
+        free(answers[i]);
+        free(folded[i]);
+    }
+    free(answers);
+    free(folded);
+    free(foldedLen);
+}
+
+int main() {
+    check_kernel();
+    examples();
+    int sizes[] = {100, 1000, 10000};
+    for (int i = 0; i < 3; i++) run(sizes[i], sizes[i] >= 10000 ? 2000 : 20000);
+    return 0;
+}
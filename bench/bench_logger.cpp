@@ -0,0 +1,102 @@
+// Dziennik zdarzeń (logger.h) a synchroniczny fprintf(stderr) na ścieżce pętli zdarzeń:
+// 1) koszt jednego wpisu "Gracz ... odpowiedział: ..." (percentyle pojedynczych wywołań),
+// 2) ile write() robi wątek dziennika na te same wpisy,
+// 3) zalew wpisów szybszy niż wątek dziennika - wpisy przepadają (liczone), wywołanie nie czeka.
+// stderr trafia do pliku (domyślnie /tmp/bench_logger.log, np. na dysku albo tmpfs).
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -o bench_logger bench/bench_logger.cpp logger.cpp metrics.cpp timer_wheel.cpp frame.cpp -lpthread
+// Użycie: ./bench_logger [wpisy] [plik]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../logger.h"
+
+#define BURST 2000   // wpisów między przerwami (połowa pierścienia - nic nie przepada)
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *label, double *lat, int n, double total) {
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("%-22s %8.0f ns/wpis | p50 %6.0f ns  p99 %7.0f ns  p99.9 %8.0f ns  max %9.0f ns\n", label, total / n,
+           lat[n / 2], lat[(int)(n * 0.99)], lat[(int)(n * 0.999)], lat[n - 1]);
+}
+
+int main(int argc, char **argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 200000;
+    const char *path = argc > 2 ? argv[2] : "/tmp/bench_logger.log";
+    if (n < BURST) n = BURST;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+    // Wyniki na stdout, wpisy (obu rodzajów) do pliku
+    fflush(stderr);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+    double *lat = (double *)malloc(n * sizeof(double));
+    if (!lat) return 1;
+    const char *name = "gracz_4711";
+    const char *answer = "Bośnia i Hercegowina";
+
+    printf("%d wpisów, stderr -> %s\n", n, path);
+
+    // 1) Synchronicznie: format i write() w wątku pętli zdarzeń (jak dotąd)
+    double total = 0;
+    for (int i = 0; i < n; i++) {
+        double t0 = now_ns();
+        fprintf(stderr, "DEBUG: Gracz %s odpowiedział: %s (%d)\n", name, answer, i);
+        lat[i] = now_ns() - t0;
+        total += lat[i];
+    }
+    report("fprintf(stderr)", lat, n, total);
+
+    // 2) Dziennik: tylko rekord w pierścieniu; paczkami z przerwą, żeby wątek dziennika nadążał
+    if (logger_start() != 0) return 1;
+    LoggerCounters before, after;
+    logger_counters(&before);
+    total = 0;
+    for (int i = 0; i < n; i++) {
+        double t0 = now_ns();
+        LOG_DEBUG("Gracz %s odpowiedział: %s (%d)", name, answer, i);
+        lat[i] = now_ns() - t0;
+        total += lat[i];
+        if ((i + 1) % BURST == 0) usleep(2 * LOG_FLUSH_MS * 1000);
+    }
+    report("LOG_DEBUG", lat, n, total);
+    do {
+        usleep(1000);
+        logger_counters(&after);
+    } while (after.written + after.dropped < before.written + before.dropped + n);
+    printf("wątek dziennika: %llu wpisów w %llu write() (%.0f wpisów na write), pominięte: %llu\n",
+           (unsigned long long)(after.written - before.written), (unsigned long long)(after.writes - before.writes),
+           (double)(after.written - before.written) / (double)(after.writes - before.writes + (after.writes == before.writes)),
+           (unsigned long long)(after.dropped - before.dropped));
+
+    // 3) Zalew bez przerw: pierścień się zapełnia, nadmiar przepada zamiast blokować pętlę
+    before = after;
+    double t0 = now_ns();
+    for (int i = 0; i < n * 5; i++) LOG_DEBUG("Gracz %s odpowiedział: %s (%d)", name, answer, i);
+    double elapsed = now_ns() - t0;
+    logger_stop();
+    logger_counters(&after);
+    printf("zalew: %d wpisów, %.0f ns/wpis, wypisane %llu, pominięte %llu\n", n * 5, elapsed / (n * 5),
+           (unsigned long long)(after.written - before.written), (unsigned long long)(after.dropped - before.dropped));
+
+    free(lat);
+    return 0;
+}
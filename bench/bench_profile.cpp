@@ -0,0 +1,128 @@
+// Dziennik profili graczy (profile_log.h):
+// 1) koszt profile_record_game() po stronie pętli zdarzeń (tylko dopisanie do bufora w pamięci),
+// 2) przepustowość zapisu z group commit vs write()+fdatasync() po każdym rekordzie,
+// 3) odtworzenie dziennika po restarcie i kompakcja.
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -o bench_profile bench/bench_profile.cpp profile_log.cpp answer_index.cpp -lpthread
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../profile_log.h"
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char dir[] = "/tmp/bench_profileXXXXXX";
+
+static void log_path(char *out, size_t cap, const char *name) {
+    snprintf(out, cap, "%s/%s", dir, name);
+}
+
+// Czeka, aż wątek zapisu zatwierdzi 'records' rekordów
+static void wait_records(uint64_t records) {
+    ProfileLogCounters c;
+    do {
+        usleep(200);
+        profile_log_counters(&c);
+    } while (c.records + c.dropped < records);
+}
+
+static off_t file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+// Wyniki gier 'players' graczy, 'games' gier każdy (jak koniec gry w wielu pokojach naraz)
+static void group_commit(int players, int games) {
+    char path[256];
+    log_path(path, sizeof(path), "profiles.log");
+    unlink(path);
+    if (profile_log_open(path) != 0) exit(1);
+
+    ProfileLogCounters before;
+    profile_log_counters(&before);
+    uint64_t total = (uint64_t)players * games;
+    double enqueue = 0;
+    double t0 = now_sec();
+    for (int g = 0; g < games; g++) {
+        double e0 = now_sec();
+        for (int i = 0; i < players; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "gracz%d", i);
+            profile_record_game(name, i % 11, (i * 7 + g) % 200);
+        }
+        enqueue += now_sec() - e0;
+    }
+    wait_records(before.records + before.dropped + total);
+    double t1 = now_sec();
+
+    ProfileLogCounters after;
+    profile_log_counters(&after);
+    ProfileStats st;
+    int found = profile_lookup("gracz7", &st) == 0;
+    printf("group commit: %llu rekordów, %llu x fdatasync, %.0f rekordów/s | pętla zdarzeń: %.0f ns/rekord | "
+           "kompakcje %llu, plik %lld B | gracz7: gry %u, poprawne %u, najlepszy %u%s\n",
+           (unsigned long long)total, (unsigned long long)(after.commits - before.commits), total / (t1 - t0),
+           enqueue * 1e9 / total, (unsigned long long)(after.compactions - before.compactions),
+           (long long)file_size(path), found ? st.games : 0, found ? st.correct : 0, found ? st.bestScore : 0,
+           after.dropped != before.dropped ? " (odrzucone rekordy!)" : "");
+    profile_log_close();
+
+    // Restart: odtworzenie dziennika (po kompakcji jeden rekord na gracza)
+    double r0 = now_sec();
+    if (profile_log_open(path) != 0) exit(1);
+    double r1 = now_sec();
+    ProfileStats again;
+    int same = profile_lookup("gracz7", &again) == 0 && found && again.games == st.games && again.points == st.points;
+    printf("odtworzenie po restarcie: %.2f ms, profil gracz7 %s\n", (r1 - r0) * 1e3, same ? "zgodny" : "NIEZGODNY");
+    profile_log_close();
+}
+
+// Punkt odniesienia: każdy rekord osobno zapisany i zatwierdzony na dysku
+static void fsync_per_record(int records) {
+    char path[256];
+    log_path(path, sizeof(path), "naive.log");
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        perror(path);
+        exit(1);
+    }
+    char rec[64];
+    memset(rec, 'x', sizeof(rec));
+    double t0 = now_sec();
+    for (int i = 0; i < records; i++) {
+        if (write(fd, rec, 40) != 40 || fdatasync(fd) != 0) {
+            perror("write");
+            break;
+        }
+    }
+    double t1 = now_sec();
+    close(fd);
+    unlink(path);
+    printf("fdatasync po każdym rekordzie: %d rekordów, %.0f rekordów/s\n", records, records / (t1 - t0));
+}
+
+int main() {
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    fsync_per_record(2000);
+    group_commit(1000, 20);
+    group_commit(10000, 50);
+
+    char path[256];
+    log_path(path, sizeof(path), "profiles.log");
+    unlink(path);
+    rmdir(dir);
+    return 0;
+}
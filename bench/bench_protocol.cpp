@@ -0,0 +1,189 @@
+// Protokół tekstowy vs BIN1 na koniec rundy: bajty wysłane na gracza, czas serwera (end_round() ze startem
+// kolejnej rundy + wysyłka) i czas klienta na rozbiór tego, co dostał jeden gracz.
+// Połączenia piszą do /dev/null, a jeden gracz do potoku, z którego czytamy jego strumień.
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -pthread -o bench_protocol bench/bench_protocol.cpp game_room.cpp
+//       question_bank.cpp answer_index.cpp connection.cpp frame.cpp timer_wheel.cpp player_registry.cpp
+//       leaderboard.cpp bank_image.cpp fuzzy_match.cpp arena.cpp metrics.cpp protocol.cpp session.cpp profile_log.cpp capture.cpp uring.cpp
+//       join_queue.cpp logger.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../game_room.h"
+#include "../connection.h"
+#include "../metrics.h"
+#include "../protocol.h"
+
+#define ROUNDS 20
+#define PARSE_REPEATS 20000
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static volatile long sink;
+
+// Klient tekstowy jak klient.py: linie rozpoznawane po początku, liczby przez sscanf
+static long parse_text(const char *data, size_t len) {
+    long acc = 0;
+    const char *p = data, *end = data + len;
+    while (p < end) {
+        const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+        if (!nl) break;
+        char line[BUFFER_SIZE];
+        size_t n = (size_t)(nl - p) < sizeof(line) - 1 ? (size_t)(nl - p) : sizeof(line) - 1;
+        memcpy(line, p, n);
+        line[n] = '\0';
+        int a, b, c, d;
+        if (strncmp(line, "Pytanie:", 8) == 0) {
+            acc += (long)strlen(line + 8);
+        } else if (strncmp(line, "TIME_LEFT=", 10) == 0) {
+            acc += atoi(line + 10);
+        } else if (strncmp(line, "IN_GAME=", 8) == 0) {
+            acc += atoi(line + 8);
+        } else if (sscanf(line, "Twoje miejsce: %d/%d, Punkty za pytanie: %d, Łącznie: %d", &a, &b, &c, &d) == 4) {
+            acc += a + b + c + d;
+        } else if (sscanf(line, "%d. ", &a) == 1) {
+            const char *pts = strstr(line, "Punkty za pytanie: ");
+            const char *tot = strstr(line, "Łącznie: ");
+            if (pts && tot) acc += a + atoi(pts + 19) + atoi(tot + 10);
+        }
+        p = nl + 1;
+    }
+    return acc;
+}
+
+static unsigned get_u16(const unsigned char *p) {
+    return (unsigned)p[0] << 8 | p[1];
+}
+
+static unsigned get_u32(const unsigned char *p) {
+    return (unsigned)p[0] << 24 | (unsigned)p[1] << 16 | (unsigned)p[2] << 8 | p[3];
+}
+
+// Klient BIN1: nagłówek, kod i pola na stałych pozycjach
+static long parse_bin(const unsigned char *data, size_t len) {
+    long acc = 0;
+    size_t off = 0;
+    while (off + BIN_HEADER_SIZE <= len) {
+        unsigned n = get_u16(data + off);
+        int op = data[off + 2];
+        const unsigned char *pl = data + off + BIN_HEADER_SIZE;
+        if (off + BIN_HEADER_SIZE + n > len) break;
+        switch (op) {
+        case OP_QUESTION: acc += get_u16(pl) + get_u16(pl + 2); break;
+        case OP_TIME_LEFT: acc += get_u16(pl); break;
+        case OP_IN_GAME: acc += pl[0]; break;
+        case OP_ROUND_END: acc += get_u16(pl + 2); break;
+        case OP_RANK_ENTRY: acc += get_u32(pl) + get_u16(pl + 4) + get_u32(pl + 6) + get_u16(pl + 10); break;
+        case OP_MY_RANK: acc += get_u32(pl) + get_u32(pl + 4) + get_u16(pl + 8) + get_u32(pl + 10); break;
+        default: break;
+        }
+        off += BIN_HEADER_SIZE + n;
+    }
+    return acc;
+}
+
+// ROUNDS rund w pokoju 'players' graczy mówiących protokołem 'proto'
+static void run(int devnull, int players, int proto) {
+    int pipefd[2];
+    if (pipe2(pipefd, O_NONBLOCK) != 0) {
+        perror("pipe2");
+        exit(1);
+    }
+    fcntl(pipefd[1], F_SETPIPE_SZ, 1 << 20);
+
+    GameRoom *room = room_create(1, NULL);
+    Connection **conns = (Connection **)malloc(sizeof(Connection *) * players);
+    for (int i = 0; i < players; i++) {
+        conns[i] = conn_create(i == players / 2 ? pipefd[1] : devnull, -1);
+        conns[i]->proto = proto;
+        Player *p = room_add_player(room, conns[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "gracz%d", i);
+        registry_set_name(&room->players, p, name);
+        p->got_name = 1;
+    }
+
+    Metrics *m = (Metrics *)calloc(1, sizeof(Metrics));
+    Metrics *saved = t_metrics;
+    t_metrics = m;
+    static char stream[1 << 20];
+    size_t streamLen = 0;
+    double serverTime = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < players; i++) {
+            Player *p = &room->players.items[i];
+            p->in_game = 1;
+            p->answered = 1;
+            p->response = arena_strdup(&room->roundArena, i % 3 ? "Polska" : "Niemcy");
+            p->answerTime = (i % 30) / 10.0;
+        }
+        room->round_in_progress = 1;
+        room->in_game_count = players;
+        room->answered_count = players;
+        room->round_start_ns = monotonic_ns() - (uint64_t)(g_time_limit + 1) * 1000000000ull;
+
+        double t0 = now_sec();
+        room_on_timer(room);
+        conn_flush_all(NULL, NULL);
+        serverTime += now_sec() - t0;
+
+        ssize_t n;
+        while (streamLen < sizeof(stream) && (n = read(pipefd[0], stream + streamLen, sizeof(stream) - streamLen)) > 0) {
+            streamLen += (size_t)n;
+        }
+    }
+    uint64_t bytes = m->bytesSent;
+    t_metrics = saved;
+
+    double t0 = now_sec();
+    long acc = 0;
+    for (int k = 0; k < PARSE_REPEATS; k++) {
+        acc += proto == PROTO_BIN1 ? parse_bin((const unsigned char *)stream, streamLen) : parse_text(stream, streamLen);
+    }
+    double parseTime = now_sec() - t0;
+    sink = acc;
+
+    printf("%6d graczy | %-4s | %7.0f B/gracza/rundę | serwer %9.1f us/rundę | klient %7.0f ns/rundę\n",
+           players, proto == PROTO_BIN1 ? "BIN1" : "text", (double)bytes / players / ROUNDS,
+           serverTime * 1e6 / ROUNDS, parseTime * 1e9 / PARSE_REPEATS / ROUNDS);
+
+    free(m);
+    room_destroy(room);
+    for (int i = 0; i < players; i++) conn_free(conns[i]);
+    free(conns);
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+int main() {
+    g_time_limit = 30;
+    g_max_rounds = 1000000;
+    if (load_answers_from_config("config.ini") != 0) {
+        fprintf(stderr, "Uruchom w katalogu z config.ini\n");
+        return 1;
+    }
+    g_output_high_water = (size_t)1 << 34;
+
+    int devnull = open("/dev/null", O_WRONLY);
+    // Logi DEBUG z pokoju nie są tu istotne
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+
+    int sizes[] = {10, 1000, 10000};
+    for (int i = 0; i < 3; i++) {
+        run(devnull, sizes[i], PROTO_TEXT);
+        run(devnull, sizes[i], PROTO_BIN1);
+    }
+
+    close(devnull);
+    free_resources();
+    return 0;
+}
@@ -0,0 +1,168 @@
+// Widzowie: koszt rozesłania rundy do dużej widowni i wpływ na graczy, oraz kolejki widzów, którzy nie nadążają.
+// 1) Pokój ze 100 graczami i 0..100k widzami (wszyscy piszą do /dev/null): end_round() z rozesłaniem
+//    referencji do ramek, wysyłka do graczy (idzie pierwsza) i do widzów.
+// 2) Widzowie na gniazdach, z których nikt nie czyta: kolejka nie rośnie ponad SPECTATOR_HIGH_WATER,
+//    najstarsze wiadomości przepadają, nikt nie jest rozłączany.
+//
+// Kompilacja (z katalogu głównego):
+//   g++ -O2 -pthread -o bench_spectators bench/bench_spectators.cpp game_room.cpp
+//       question_bank.cpp answer_index.cpp connection.cpp frame.cpp timer_wheel.cpp player_registry.cpp
+//       leaderboard.cpp bank_image.cpp fuzzy_match.cpp arena.cpp metrics.cpp protocol.cpp session.cpp profile_log.cpp capture.cpp uring.cpp
+//       join_queue.cpp logger.cpp
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "../game_room.h"
+#include "../connection.h"
+#include "../metrics.h"
+
+#define PLAYERS 100
+#define ROUNDS 10
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static GameRoom *make_room(Connection **players, int fd) {
+    GameRoom *room = room_create(1, NULL);
+    for (int i = 0; i < PLAYERS; i++) {
+        players[i] = conn_create(fd, -1);
+        Player *p = room_add_player(room, players[i]);
+        char name[32];
+        snprintf(name, sizeof(name), "gracz%d", i);
+        registry_set_name(&room->players, p, name);
+        p->got_name = 1;
+    }
+    return room;
+}
+
+// Stan jak po odpowiedziach wszystkich graczy - następny room_on_timer() kończy rundę
+static void prepare_round(GameRoom *room) {
+    for (int i = 0; i < room->players.count; i++) {
+        Player *p = &room->players.items[i];
+        p->in_game = 1;
+        p->answered = 1;
+        p->response = arena_strdup(&room->roundArena, i % 3 ? "Polska" : "Niemcy");
+        p->answerTime = (i % 30) / 10.0;
+    }
+    room->round_in_progress = 1;
+    room->in_game_count = room->players.count;
+    room->answered_count = room->players.count;
+    room->round_start_ns = monotonic_ns() - (uint64_t)(g_time_limit + 1) * 1000000000ull;
+}
+
+static void run_fanout(int devnull, int spectators) {
+    Connection *players[PLAYERS];
+    GameRoom *room = make_room(players, devnull);
+    Connection **viewers = (Connection **)malloc(sizeof(Connection *) * (spectators + 1));
+    for (int i = 0; i < spectators; i++) {
+        viewers[i] = conn_create(devnull, -1);
+        room_add_spectator(room, viewers[i]);
+    }
+    conn_flush_all(NULL, NULL);
+
+    double roundTime = 0, playerFlush = 0, viewerFlush = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        prepare_round(room);
+        double t0 = now_sec();
+        room_on_timer(room);
+        double t1 = now_sec();
+        // Kolejność jak w conn_flush_all(): gracze, potem widzowie
+        for (int i = 0; i < PLAYERS; i++) conn_flush(players[i]);
+        double t2 = now_sec();
+        conn_flush_all(NULL, NULL);
+        double t3 = now_sec();
+        roundTime += t1 - t0;
+        playerFlush += t2 - t1;
+        viewerFlush += t3 - t2;
+    }
+    printf("%7d widzów | end_round %9.1f us | gracze wysłani po %9.1f us | widzowie +%10.1f us\n", spectators,
+           roundTime * 1e6 / ROUNDS, (roundTime + playerFlush) * 1e6 / ROUNDS, viewerFlush * 1e6 / ROUNDS);
+
+    room_destroy(room);
+    for (int i = 0; i < PLAYERS; i++) conn_free(players[i]);
+    for (int i = 0; i < spectators; i++) conn_free(viewers[i]);
+    free(viewers);
+}
+
+static void run_lagging(int devnull, int spectators, int rounds) {
+    int epfd = epoll_create1(0);
+    Connection *players[PLAYERS];
+    GameRoom *room = make_room(players, devnull);
+    Connection **viewers = (Connection **)malloc(sizeof(Connection *) * spectators);
+    int *peers = (int *)malloc(sizeof(int) * spectators);
+    for (int i = 0; i < spectators; i++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) != 0) {
+            perror("socketpair");
+            exit(1);
+        }
+        int small = 4096;
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        peers[i] = sv[1];
+        viewers[i] = conn_create(sv[0], -1);
+        conn_attach(viewers[i], epfd);
+        room_add_spectator(room, viewers[i]);
+    }
+
+    Metrics *m = (Metrics *)calloc(1, sizeof(Metrics));
+    Metrics *saved = t_metrics;
+    t_metrics = m;
+    size_t maxPending = 0;
+    for (int r = 0; r < rounds; r++) {
+        prepare_round(room);
+        room_on_timer(room);
+        conn_flush_all(NULL, NULL);
+        for (int i = 0; i < spectators; i++) {
+            if (viewers[i]->pending > maxPending) maxPending = viewers[i]->pending;
+        }
+    }
+    t_metrics = saved;
+
+    int dead = 0;
+    for (int i = 0; i < spectators; i++) dead += viewers[i]->dead;
+    printf("%d nieczytających widzów, %d rund: najdłuższa kolejka %zu B (limit %zu B), pominięte wiadomości: %llu, "
+           "rozłączeni: %d\n", spectators, rounds, maxPending, g_spectator_high_water,
+           (unsigned long long)m->spectatorSkips, dead);
+
+    free(m);
+    room_destroy(room);
+    for (int i = 0; i < PLAYERS; i++) conn_free(players[i]);
+    for (int i = 0; i < spectators; i++) {
+        close(viewers[i]->fd);
+        close(peers[i]);
+        conn_free(viewers[i]);
+    }
+    free(viewers);
+    free(peers);
+    close(epfd);
+}
+
+int main() {
+    g_time_limit = 30;
+    g_max_rounds = 1000000;
+    if (load_answers_from_config("config.ini") != 0) {
+        fprintf(stderr, "Uruchom w katalogu z config.ini\n");
+        return 1;
+    }
+
+    int devnull = open("/dev/null", O_WRONLY);
+    // Logi DEBUG z pokoju nie są tu istotne
+    if (!freopen("/dev/null", "w", stderr)) return 1;
+
+    int counts[] = {0, 1000, 10000, 100000};
+    for (int i = 0; i < 4; i++) run_fanout(devnull, counts[i]);
+    run_lagging(devnull, 100, 500);
+
+    close(devnull);
+    free_resources();
+    return 0;
+}
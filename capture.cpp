@@ -0,0 +1,229 @@
+#include "capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "timer_wheel.h"
+
+typedef struct CaptureHeader {
+    char magic[8];
+    uint32_t workers;
+    uint32_t reserved;
+} CaptureHeader;
+
+typedef struct CaptureRecord {
+    uint64_t ns;
+    uint32_t conn;
+    uint16_t len;
+    uint8_t type;
+    uint8_t worker;
+} CaptureRecord;
+
+// Najdłuższy fragment danych w jednym rekordzie (dłuższe paczki dzielimy)
+#define CAPTURE_CHUNK_MAX (CAPTURE_BUFFER_SIZE - sizeof(CaptureRecord))
+
+int g_capture_fd = -1;
+static uint32_t nextConn = 0;
+
+// Odtwarzanie: token sesji każdego połączenia z zapisu (indeks = numer połączenia; zera = brak)
+static uint64_t (*replayTokens)[2] = NULL;
+static uint32_t replayTokenCount = 0;
+
+static __thread char *t_buffer = NULL;
+static __thread size_t t_used = 0;
+
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int capture_open(const char *path, int workers) {
+    if (workers > 255) {
+        fprintf(stderr, "Zapis zdarzeń obsługuje najwyżej 255 wątków (jest %d)\n", workers);
+        return -1;
+    }
+    // O_APPEND: bufor każdego wątku trafia do pliku w całości, bez przeplotu z innymi
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    CaptureHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CAPTURE_MAGIC, sizeof(h.magic));
+    h.workers = (uint32_t)workers;
+    if (write_all(fd, (const char *)&h, sizeof(h)) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    g_capture_fd = fd;
+    return 0;
+}
+
+void capture_close() {
+    if (g_capture_fd < 0) return;
+    close(g_capture_fd);
+    g_capture_fd = -1;
+}
+
+uint32_t capture_next_conn() {
+    return __atomic_add_fetch(&nextConn, 1, __ATOMIC_RELAXED);
+}
+
+void capture_flush() {
+    if (t_used == 0) return;
+    // Błąd zapisu gubi tylko ten bufor - gra toczy się dalej
+    if (write_all(g_capture_fd, t_buffer, t_used) != 0) perror("zapis zdarzeń");
+    t_used = 0;
+}
+
+void capture_event(int type, int worker, uint32_t conn, const char *data, size_t len) {
+    if (!t_buffer) {
+        t_buffer = (char *)malloc(CAPTURE_BUFFER_SIZE);
+        if (!t_buffer) return;
+    }
+    uint64_t ns = monotonic_ns();
+    do {
+        size_t chunk = len < CAPTURE_CHUNK_MAX ? len : CAPTURE_CHUNK_MAX;
+        if (t_used + sizeof(CaptureRecord) + chunk > CAPTURE_BUFFER_SIZE) capture_flush();
+
+        CaptureRecord r;
+        r.ns = ns;
+        r.conn = conn;
+        r.len = (uint16_t)chunk;
+        r.type = (uint8_t)type;
+        r.worker = (uint8_t)worker;
+        memcpy(t_buffer + t_used, &r, sizeof(r));
+        if (chunk > 0) memcpy(t_buffer + t_used + sizeof(r), data, chunk);
+        t_used += sizeof(r) + chunk;
+        data += chunk;
+        len -= chunk;
+    } while (len > 0);
+}
+
+static int compare_events(const void *a, const void *b) {
+    const CaptureEvent *x = (const CaptureEvent *)a;
+    const CaptureEvent *y = (const CaptureEvent *)b;
+    if (x->ns != y->ns) return x->ns < y->ns ? -1 : 1;
+    return x->seq < y->seq ? -1 : (x->seq > y->seq ? 1 : 0);
+}
+
+int capture_load(const char *path, CaptureLog *log) {
+    memset(log, 0, sizeof(*log));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    log->raw = (char *)malloc(size ? size : 1);
+    if (!log->raw) {
+        fprintf(stderr, "Brak pamięci na zapis zdarzeń (%zu B)\n", size);
+        close(fd);
+        return -1;
+    }
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = read(fd, log->raw + got, size - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+
+    CaptureHeader h;
+    memset(&h, 0, sizeof(h));
+    if (got >= sizeof(h)) memcpy(&h, log->raw, sizeof(h));
+    if (memcmp(h.magic, CAPTURE_MAGIC, sizeof(h.magic)) != 0 || h.workers == 0) {
+        fprintf(stderr, "%s: to nie jest zapis zdarzeń serwera\n", path);
+        capture_log_free(log);
+        return -1;
+    }
+    log->workers = (int)h.workers;
+
+    // Pierwszy przebieg: liczba rekordów (do pierwszego urwanego)
+    size_t count = 0, off = sizeof(h);
+    while (off + sizeof(CaptureRecord) <= got) {
+        CaptureRecord r;
+        memcpy(&r, log->raw + off, sizeof(r));
+        if (off + sizeof(r) + r.len > got) break;
+        off += sizeof(r) + r.len;
+        count++;
+    }
+    if (off != got) fprintf(stderr, "%s: pominięto urwany koniec zapisu (%zu B)\n", path, got - off);
+
+    log->events = (CaptureEvent *)malloc((count ? count : 1) * sizeof(CaptureEvent));
+    if (!log->events) {
+        fprintf(stderr, "Brak pamięci na %zu zdarzeń\n", count);
+        capture_log_free(log);
+        return -1;
+    }
+    off = sizeof(h);
+    for (size_t i = 0; i < count; i++) {
+        CaptureRecord r;
+        memcpy(&r, log->raw + off, sizeof(r));
+        CaptureEvent *e = &log->events[i];
+        e->ns = r.ns;
+        e->conn = r.conn;
+        e->len = r.len;
+        e->type = r.type;
+        e->worker = r.worker < h.workers ? r.worker : 0;
+        e->data = log->raw + off + sizeof(r);
+        e->seq = i;
+        if (r.conn > log->maxConn) log->maxConn = r.conn;
+        off += sizeof(r) + r.len;
+    }
+    log->count = count;
+    qsort(log->events, count, sizeof(CaptureEvent), compare_events);
+    return 0;
+}
+
+void capture_log_free(CaptureLog *log) {
+    free(log->raw);
+    free(log->events);
+    memset(log, 0, sizeof(*log));
+}
+
+int capture_replay_tokens(const CaptureLog *log) {
+    free(replayTokens);
+    replayTokens = NULL;
+    replayTokenCount = 0;
+    if (!log) return 0;
+    replayTokens = (uint64_t (*)[2])calloc((size_t)log->maxConn + 1, sizeof(*replayTokens));
+    if (!replayTokens) return -1;
+    replayTokenCount = log->maxConn + 1;
+    for (size_t i = 0; i < log->count; i++) {
+        const CaptureEvent *e = &log->events[i];
+        if (e->type == CAPTURE_TOKEN && e->len == sizeof(replayTokens[0])) {
+            memcpy(replayTokens[e->conn], e->data, e->len);
+        }
+    }
+    return 0;
+}
+
+int capture_replay_token(uint32_t conn, uint64_t token[2]) {
+    if (conn >= replayTokenCount || (replayTokens[conn][0] | replayTokens[conn][1]) == 0) return -1;
+    token[0] = replayTokens[conn][0];
+    token[1] = replayTokens[conn][1];
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Zapis zdarzeń wejściowych serwera (CAPTURE_FILE) do odtworzenia przez quiz-server --replay.
+// Plik: nagłówek [CAPTURE_MAGIC][u32 liczba wątków][u32 0], potem rekordy
+//   [u64 czas ns (zegar monotoniczny)][u32 numer połączenia][u16 długość danych][u8 typ][u8 wątek][dane]
+// (liczby w porządku bajtów maszyny). Każdy wątek reaktora zbiera rekordy we własnym buforze
+// i dopisuje je do pliku na końcu iteracji pętli, więc rekordy różnych wątków są w pliku
+// przemieszane - przy wczytaniu sortujemy je po czasie.
+#define CAPTURE_MAGIC "QUIZCAP1"
+
+#define CAPTURE_ACCEPT 1        // nowe połączenie gracza
+#define CAPTURE_DATA   2        // bajty odczytane z gniazda (jeden conn_read())
+#define CAPTURE_CLOSE  3        // klient się rozłączył
+#define CAPTURE_TOKEN  4        // wylosowany token sesji połączenia (16 B) - przy odtwarzaniu ten sam
+
+// Bufor wątku zapisywany do pliku, gdy przekroczy tyle bajtów (i na końcu każdej iteracji)
+#define CAPTURE_BUFFER_SIZE (64u << 10)
+
+// Deskryptor pliku zapisu (-1 = zapis wyłączony)
+extern int g_capture_fd;
+
+// Tworzy plik zapisu (nadpisuje istniejący). Zwraca 0 albo -1 (komunikat na stderr).
+int capture_open(const char *path, int workers);
+// Zamyka plik (bufory wątków muszą być już opróżnione przez capture_flush())
+void capture_close();
+
+// Kolejny numer połączenia w zapisie (od 1, wspólny dla wszystkich wątków)
+uint32_t capture_next_conn();
+// Dopisuje zdarzenie do bufora bieżącego wątku
+void capture_event(int type, int worker, uint32_t conn, const char *data, size_t len);
+// Zapisuje bufor bieżącego wątku do pliku
+void capture_flush();
+
+typedef struct CaptureEvent {
+    uint64_t ns;
+    uint32_t conn;
+    uint32_t len;
+    int type;
+    int worker;
+    const char *data;           // wskazuje do CaptureLog.raw
+    size_t seq;                 // kolejność w pliku (sortowanie stabilne)
+} CaptureEvent;
+
+typedef struct CaptureLog {
+    char *raw;                  // cały plik
+    CaptureEvent *events;       // posortowane po czasie
+    size_t count;
+    int workers;
+    uint32_t maxConn;           // największy numer połączenia
+} CaptureLog;
+
+// Wczytuje zapis (urwany ostatni rekord jest pomijany). Zwraca 0 albo -1 (komunikat na stderr).
+int capture_load(const char *path, CaptureLog *log);
+void capture_log_free(CaptureLog *log);
+
+// Odtwarzanie: tokeny sesji z zapisu (rekordy CAPTURE_TOKEN), żeby RESUME= z zapisu pasowały.
+// Zwraca 0 albo -1 przy braku pamięci; NULL zwalnia tablicę.
+int capture_replay_tokens(const CaptureLog *log);
+// Token z zapisu dla połączenia 'conn' (0) albo -1, gdy go nie ma (poza odtwarzaniem zawsze -1)
+int capture_replay_token(uint32_t conn, uint64_t token[2]);
+
+#endif
@@ -0,0 +1,662 @@
+#include "connection.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "metrics.h"
+#include "uring.h"
+
+// Ile fragmentów kolejki oddajemy jądru w jednym writev()
+#define MAX_IOV 64
+
+// Rozmiar prywatnej ramki na drobne wiadomości jednego połączenia
+#define PRIVATE_FRAME_SIZE 512
+
+// io_uring: ile połączeń wysyłamy jedną paczką zgłoszeń i ile fragmentów kolejki w jednym sendmsg()
+#define SEND_BATCH 256
+#define SEND_IOV 16
+
+size_t g_output_high_water = 256 * 1024;
+int g_slow_client_drop = 0;
+size_t g_spectator_high_water = 64 * 1024;
+
+int g_io_uring = 0;
+
+__thread unsigned long t_write_calls = 0;
+
+// Pierścienie io_uring bieżącego wątku (NULL = epoll) i numer kolejnego uzbrojenia połączenia
+static __thread Uring *t_ring = NULL;
+static __thread Uring *t_sendRing = NULL;
+static __thread unsigned t_ioGen = 0;
+
+// Zgłoszenie wysyłki z paczki: iovec i msghdr muszą przetrwać do zakończenia
+typedef struct SendSlot {
+    Connection *conn;
+    struct msghdr msg;
+    struct iovec iov[SEND_IOV];
+    size_t bytes;
+} SendSlot;
+static __thread SendSlot *t_sendSlots = NULL;
+
+// Połączenia z niewysłanymi danymi z bieżącej iteracji (każdy wątek ma własną listę).
+// Widzowie mają osobną listę wysyłaną po graczach, żeby duża widownia nie opóźniała graczy.
+static __thread Connection *t_dirtyHead = NULL;
+static __thread Connection *t_spectatorDirtyHead = NULL;
+
+static Connection **dirty_list(Connection *c) {
+    return c->spectator ? &t_spectatorDirtyHead : &t_dirtyHead;
+}
+
+static void mark_dirty(Connection *c) {
+    if (c->dirty) return;
+    Connection **head = dirty_list(c);
+    c->dirty = 1;
+    c->dirtyPrev = NULL;
+    c->dirtyNext = *head;
+    if (*head) (*head)->dirtyPrev = c;
+    *head = c;
+}
+
+static void unmark_dirty(Connection *c) {
+    if (!c->dirty) return;
+    if (c->dirtyPrev) c->dirtyPrev->dirtyNext = c->dirtyNext;
+    else *dirty_list(c) = c->dirtyNext;
+    if (c->dirtyNext) c->dirtyNext->dirtyPrev = c->dirtyPrev;
+    c->dirty = 0;
+    c->dirtyPrev = c->dirtyNext = NULL;
+}
+
+static void set_want_write(Connection *c, int on) {
+    if (c->wantWrite == on) return;
+    if (t_ring) {
+        // Jednorazowe czekanie na miejsce w gnieździe; wyłączenie tylko zapominamy (zakończenie bez kolejki nic nie robi)
+        if (on) {
+            struct io_uring_sqe *sqe = uring_sqe(t_ring);
+            if (!sqe) {
+                c->dead = 1;
+                return;
+            }
+            uring_prep_poll(sqe, c->fd, POLLOUT, 0, io_tag(IO_TAG_WRITABLE, c->ioGen, c->fd));
+        }
+        c->wantWrite = on;
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (on ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.fd = c->fd;
+    if (epoll_ctl(c->epfd, EPOLL_CTL_MOD, c->fd, &ev) == -1) {
+        perror("epoll_ctl");
+        c->dead = 1;
+        return;
+    }
+    c->wantWrite = on;
+}
+
+Connection *conn_create(int fd, int epfd) {
+    Connection *c = (Connection *)calloc(1, sizeof(Connection));
+    if (!c) return NULL;
+    c->fd = fd;
+    c->epfd = epfd;
+    return c;
+}
+
+// Zdejmuje z kolejki pierwszy fragment i zwalnia referencję do ramki
+static void pop_chunk(Connection *c) {
+    OutChunk *ch = &c->chunks[c->chunkHead];
+    if (ch->frame == c->tail) c->tail = NULL;
+    frame_unref(ch->frame);
+    ch->frame = NULL;
+    c->chunkHead = (c->chunkHead + 1) & (c->chunkCap - 1);
+    c->chunkCount--;
+}
+
+static int push_chunk(Connection *c, Frame *f) {
+    if (c->chunkCount == c->chunkCap) {
+        int newCap = c->chunkCap ? c->chunkCap * 2 : 8;
+        OutChunk *tmp = (OutChunk *)malloc(newCap * sizeof(OutChunk));
+        if (!tmp) return -1;
+        // Rozwijamy bufor cykliczny od początku
+        for (int i = 0; i < c->chunkCount; i++) {
+            tmp[i] = c->chunks[(c->chunkHead + i) & (c->chunkCap - 1)];
+        }
+        free(c->chunks);
+        c->chunks = tmp;
+        c->chunkHead = 0;
+        c->chunkCap = newCap;
+    }
+    OutChunk *ch = &c->chunks[(c->chunkHead + c->chunkCount) & (c->chunkCap - 1)];
+    ch->frame = f;
+    ch->off = 0;
+    c->chunkCount++;
+    return 0;
+}
+
+void conn_free(Connection *c) {
+    if (!c) return;
+    unmark_dirty(c);
+    while (c->chunkCount > 0) pop_chunk(c);
+    free(c->chunks);
+    free(c->in);
+    free(c);
+}
+
+int conn_read(Connection *c) {
+    if (!c->in) {
+        c->in = (char *)malloc(IN_BUFFER_SIZE);
+        if (!c->in) return CONN_READ_CLOSED;
+    }
+    // Niepełną linię przesuwamy na początek, by zrobić miejsce na nowe dane
+    if (c->inStart > 0) {
+        memmove(c->in, c->in + c->inStart, c->inEnd - c->inStart);
+        c->inEnd -= c->inStart;
+        c->inStart = 0;
+    }
+
+    // Miejsce na '\0' zostawiamy zawsze na końcu bufora
+    while (c->inEnd < IN_BUFFER_SIZE - 1) {
+        ssize_t n = recv(c->fd, c->in + c->inEnd, IN_BUFFER_SIZE - 1 - c->inEnd, 0);
+        if (n > 0) {
+            c->inEnd += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return CONN_READ_AGAIN;
+        return CONN_READ_CLOSED;
+    }
+    return CONN_READ_FULL;
+}
+
+size_t conn_feed(Connection *c, const char *data, size_t len) {
+    if (!c->in) {
+        c->in = (char *)malloc(IN_BUFFER_SIZE);
+        if (!c->in) return 0;
+    }
+    if (c->inStart > 0) {
+        memmove(c->in, c->in + c->inStart, c->inEnd - c->inStart);
+        c->inEnd -= c->inStart;
+        c->inStart = 0;
+    }
+    size_t room = IN_BUFFER_SIZE - 1 - c->inEnd;
+    if (len > room) len = room;
+    memcpy(c->in + c->inEnd, data, len);
+    c->inEnd += len;
+    return len;
+}
+
+char *conn_next_line(Connection *c) {
+    while (c->inStart < c->inEnd) {
+        char *start = c->in + c->inStart;
+        size_t avail = c->inEnd - c->inStart;
+        char *nl = (char *)memchr(start, '\n', avail);
+
+        if (!nl) {
+            // Linia jeszcze niepełna; jeśli już przekracza limit - odrzucamy ją
+            if (avail > MAX_LINE_LENGTH) {
+                if (!c->inDiscard) {
+                    LOG_INFO("Za długa linia od fd=%d - pomijam", c->fd);
+                    conn_send_text(c, "ERROR=Za długa wiadomość\n");
+                }
+                c->inDiscard = 1;
+                c->inStart = c->inEnd = 0;
+            }
+            return NULL;
+        }
+
+        c->inStart += (size_t)(nl - start) + 1;
+        if (c->inDiscard) {
+            // Koniec odrzucanej linii
+            c->inDiscard = 0;
+            continue;
+        }
+        if ((size_t)(nl - start) > MAX_LINE_LENGTH) {
+            conn_send_text(c, "ERROR=Za długa wiadomość\n");
+            continue;
+        }
+        *nl = '\0';
+        if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+        return start;
+    }
+    return NULL;
+}
+
+// Widz, który nie nadąża, nie jest rozłączany: pomijamy jego najstarsze niewysłane wiadomości
+// (zawsze całe fragmenty kolejki, a każdy zawiera pełne wiadomości), aż zmieści się nowa.
+// Częściowo wysłanego pierwszego fragmentu nie przerywamy - wypada ten za nim.
+static void skip_stale(Connection *c, size_t len) {
+    int mask = c->chunkCap - 1;
+    while (c->pending + len > g_spectator_high_water && c->chunkCount > 0) {
+        OutChunk *first = &c->chunks[c->chunkHead];
+        int victim = first->off > 0;
+        if (victim && c->chunkCount < 2) break;
+        OutChunk *v = &c->chunks[(c->chunkHead + victim) & mask];
+        c->pending -= v->frame->len;
+        if (v->frame == c->tail) c->tail = NULL;
+        frame_unref(v->frame);
+        if (victim) *v = *first;
+        first->frame = NULL;
+        c->chunkHead = (c->chunkHead + 1) & mask;
+        c->chunkCount--;
+        metric_add(&t_metrics->spectatorSkips, 1);
+    }
+}
+
+// Sprawdza limit kolejki przed dopisaniem 'len' bajtów; 0 = można dopisać
+static int check_high_water(Connection *c, size_t len) {
+    if (c->spectator) {
+        skip_stale(c, len);
+        return 0;
+    }
+    if (c->pending + len <= g_output_high_water) return 0;
+    // Wolny klient: nie pozwalamy, by jego kolejka rosła bez końca
+    if (!g_slow_client_drop) {
+        LOG_INFO("Rozłączam wolnego klienta fd=%d (kolejka %zu B)", c->fd, c->pending);
+        c->dead = 1;
+        mark_dirty(c);
+    }
+    return -1;
+}
+
+void conn_send(Connection *c, const char *data, size_t len) {
+    if (!c || c->dead || len == 0) return;
+    if (check_high_water(c, len) != 0) return;
+
+    // Drobne wiadomości sklejamy w prywatnej ramce na końcu kolejki
+    if (c->tail && c->tail->cap - c->tail->len >= len) {
+        memcpy(c->tail->data + c->tail->len, data, len);
+        c->tail->len += len;
+    } else {
+        Frame *f = frame_alloc(len > PRIVATE_FRAME_SIZE ? len : PRIVATE_FRAME_SIZE);
+        if (!f || push_chunk(c, f) != 0) {
+            frame_unref(f);
+            c->dead = 1;
+            mark_dirty(c);
+            return;
+        }
+        memcpy(f->data, data, len);
+        f->len = len;
+        c->tail = f;
+    }
+    c->pending += len;
+
+    // Gdy czekamy na EPOLLOUT, dane wyjdą razem z zaległymi
+    if (!c->wantWrite) mark_dirty(c);
+}
+
+void conn_send_frame(Connection *c, Frame *f) {
+    if (!c || c->dead || !f || f->len == 0) return;
+    if (check_high_water(c, f->len) != 0) return;
+    if (push_chunk(c, frame_ref(f)) != 0) {
+        frame_unref(f);
+        c->dead = 1;
+        mark_dirty(c);
+        return;
+    }
+    // Kolejne prywatne wiadomości muszą trafić za tę ramkę
+    c->tail = NULL;
+    c->pending += f->len;
+    if (!c->wantWrite) mark_dirty(c);
+}
+
+void conn_send_text(Connection *c, const char *message) {
+    conn_send(c, message, strlen(message));
+}
+
+// Kolejka połączenia jako iovec (najwyżej 'max' fragmentów); w 'bytes' łączna długość
+static int fill_iov(Connection *c, struct iovec *iov, int max, size_t *bytes) {
+    int n = 0;
+    *bytes = 0;
+    for (int i = 0; i < c->chunkCount && n < max; i++) {
+        OutChunk *ch = &c->chunks[(c->chunkHead + i) & (c->chunkCap - 1)];
+        iov[n].iov_base = ch->frame->data + ch->off;
+        iov[n].iov_len = ch->frame->len - ch->off;
+        *bytes += iov[n].iov_len;
+        n++;
+    }
+    return n;
+}
+
+// Zdejmuje z kolejki 'written' wysłanych bajtów: całe fragmenty, ostatni może zostać częściowo
+static void consume(Connection *c, size_t written, size_t batch, Metrics *m) {
+    if (m) {
+        metric_add(&m->bytesSent, (uint64_t)written);
+        if (written < batch) metric_add(&m->shortWrites, 1);
+    }
+    c->pending -= written;
+    while (written > 0) {
+        OutChunk *ch = &c->chunks[c->chunkHead];
+        size_t left = ch->frame->len - ch->off;
+        if (written >= left) {
+            written -= left;
+            pop_chunk(c);
+        } else {
+            ch->off += written;
+            written = 0;
+        }
+    }
+}
+
+// Kolejka opróżniona
+static int finish_flush(Connection *c) {
+    set_want_write(c, 0);
+    if (c->closeAfterFlush) c->dead = 1;   // odpowiedź wysłana w całości - można zamknąć
+    return c->dead ? -1 : 0;
+}
+
+int conn_flush(Connection *c) {
+    if (c->dead) return -1;
+    while (c->chunkCount > 0) {
+        struct iovec iov[MAX_IOV];
+        size_t batch;
+        int n = fill_iov(c, iov, MAX_IOV, &batch);
+
+        t_write_calls++;
+        Metrics *m = c->admin ? NULL : t_metrics;   // ruch portu administracyjnego nie wlicza się do metryk
+        if (m) metric_add(&m->writeCalls, 1);
+        ssize_t written = writev(c->fd, iov, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Krótki zapis - reszta po EPOLLOUT
+                if (m) metric_add(&m->shortWrites, 1);
+                set_want_write(c, 1);
+                return c->dead ? -1 : 1;
+            }
+            c->dead = 1;
+            return -1;
+        }
+        consume(c, (size_t)written, batch, m);
+    }
+    return finish_flush(c);
+}
+
+// Grupy z ramkami do rozesłania w bieżącej iteracji
+static __thread Fanout *t_fanoutHead = NULL;
+
+static void set_spectator(Connection *c, int on) {
+    // Połączenie czekające na wysyłkę przechodzi na listę swojej klasy
+    int wasDirty = c->dirty;
+    unmark_dirty(c);
+    c->spectator = on;
+    if (wasDirty) mark_dirty(c);
+}
+
+int fanout_add(Fanout *g, Connection *c) {
+    if (g->count == g->cap) {
+        int newCap = g->cap ? g->cap * 2 : 16;
+        Connection **tmp = (Connection **)realloc(g->members, sizeof(Connection *) * newCap);
+        if (!tmp) return -1;
+        g->members = tmp;
+        g->cap = newCap;
+    }
+    c->spectatorSlot = g->count;
+    g->members[g->count++] = c;
+    set_spectator(c, 1);
+    return 0;
+}
+
+// Ostatni członek zajmuje miejsce usuwanego
+void fanout_remove(Fanout *g, Connection *c) {
+    int slot = c->spectatorSlot;
+    if (slot < 0 || slot >= g->count || g->members[slot] != c) return;
+    Connection *last = g->members[--g->count];
+    g->members[slot] = last;
+    last->spectatorSlot = slot;
+    set_spectator(c, 0);
+}
+
+void fanout_send(Fanout *g, Frame *f, int proto) {
+    if (!f || f->len == 0 || g->count == 0) return;
+    if (g->itemCount == g->itemCap) {
+        int newCap = g->itemCap ? g->itemCap * 2 : 8;
+        FanoutItem *tmp = (FanoutItem *)realloc(g->items, sizeof(FanoutItem) * newCap);
+        if (!tmp) return;
+        g->items = tmp;
+        g->itemCap = newCap;
+    }
+    g->items[g->itemCount].frame = frame_ref(f);
+    g->items[g->itemCount].proto = proto;
+    g->itemCount++;
+    if (!g->queued) {
+        g->queued = 1;
+        g->next = t_fanoutHead;
+        t_fanoutHead = g;
+    }
+}
+
+// Rozsyła odłożone ramki do kolejek członków
+static void fanout_deliver(Fanout *g) {
+    for (int i = 0; i < g->count; i++) {
+        Connection *c = g->members[i];
+        for (int k = 0; k < g->itemCount; k++) {
+            if (g->items[k].proto < 0 || g->items[k].proto == c->proto) conn_send_frame(c, g->items[k].frame);
+        }
+    }
+    for (int k = 0; k < g->itemCount; k++) frame_unref(g->items[k].frame);
+    g->itemCount = 0;
+}
+
+void fanout_free(Fanout *g) {
+    if (g->queued) {
+        Fanout **pp = &t_fanoutHead;
+        while (*pp && *pp != g) pp = &(*pp)->next;
+        if (*pp) *pp = g->next;
+    }
+    for (int k = 0; k < g->itemCount; k++) frame_unref(g->items[k].frame);
+    free(g->items);
+    free(g->members);
+    memset(g, 0, sizeof(*g));
+}
+
+// Wynik jednego sendmsg() z paczki io_uring (odpowiednik jednego obrotu pętli conn_flush())
+static void finish_send(SendSlot *s, int res) {
+    Connection *c = s->conn;
+    Metrics *m = c->admin ? NULL : t_metrics;
+    if (res == -EAGAIN || res == -EWOULDBLOCK) {
+        if (m) metric_add(&m->shortWrites, 1);
+        set_want_write(c, 1);
+    } else if (res < 0) {
+        c->dead = 1;
+    } else {
+        consume(c, (size_t)res, s->bytes, m);
+        if (c->chunkCount == 0) finish_flush(c);
+        else if ((size_t)res < s->bytes) set_want_write(c, 1);   // gniazdo pełne - reszta po POLLOUT
+        else mark_dirty(c);                                      // więcej niż SEND_IOV fragmentów - w następnej paczce
+    }
+}
+
+// io_uring: kolejki do SEND_BATCH połączeń idą jednym io_uring_enter zamiast writev() na każde.
+// Na zakończenie całej paczki czekamy, więc kolejki i iovec nie zmieniają się w trakcie wysyłki;
+// połączenia zamykamy dopiero po niej (zamknięcie może dopisać wiadomości innym połączeniom paczki).
+static void flush_list_uring(Connection **head, void (*drop)(Connection *c, void *arg), void *arg) {
+    while (*head) {
+        int n = 0, sent = 0;
+        while (*head && n < SEND_BATCH) {
+            Connection *c = *head;
+            unmark_dirty(c);
+            SendSlot *s = &t_sendSlots[n++];
+            s->conn = c;
+            s->bytes = 0;
+            if (c->dead || c->chunkCount == 0) continue;
+            struct io_uring_sqe *sqe = uring_sqe(t_sendRing);
+            if (!sqe) {
+                conn_flush(c);
+                continue;
+            }
+            memset(&s->msg, 0, sizeof(s->msg));
+            s->msg.msg_iov = s->iov;
+            s->msg.msg_iovlen = fill_iov(c, s->iov, SEND_IOV, &s->bytes);
+            uring_prep_sendmsg(sqe, c->fd, &s->msg, MSG_DONTWAIT | MSG_NOSIGNAL, (uint64_t)(n - 1));
+            t_write_calls++;
+            if (!c->admin) metric_add(&t_metrics->writeCalls, 1);
+            sent++;
+        }
+
+        int done = 0;
+        while (done < sent) {
+            if (uring_submit(t_sendRing, (unsigned)(sent - done)) != 0 && errno != EINTR) {
+                // Pierścień wysyłki nie działa - niewysłane połączenia tej paczki zamykamy
+                perror("io_uring_enter");
+                for (int i = 0; i < n; i++) {
+                    if (t_sendSlots[i].bytes > 0) t_sendSlots[i].conn->dead = 1;
+                }
+                break;
+            }
+            struct io_uring_cqe *cqe;
+            while (done < sent && (cqe = uring_peek(t_sendRing)) != NULL) {
+                SendSlot *s = &t_sendSlots[cqe->user_data];
+                int res = cqe->res;
+                uring_seen(t_sendRing);
+                finish_send(s, res);
+                s->bytes = 0;
+                done++;
+            }
+        }
+
+        for (int i = 0; i < n; i++) {
+            Connection *c = t_sendSlots[i].conn;
+            if (!c) continue;
+            if (!c->dead && c->chunkCount == 0) finish_flush(c);
+            if (c->dead && drop) drop(c, arg);
+        }
+    }
+}
+
+static void flush_list(Connection **head, void (*drop)(Connection *c, void *arg), void *arg) {
+    if (t_sendRing) {
+        flush_list_uring(head, drop, arg);
+        return;
+    }
+    while (*head) {
+        Connection *c = *head;
+        unmark_dirty(c);
+        if (conn_flush(c) < 0 && drop) {
+            drop(c, arg);
+        }
+    }
+}
+
+void conn_flush_all(void (*drop)(Connection *c, void *arg), void *arg) {
+    flush_list(&t_dirtyHead, drop, arg);
+    while (t_fanoutHead) {
+        Fanout *g = t_fanoutHead;
+        t_fanoutHead = g->next;
+        g->queued = 0;
+        fanout_deliver(g);
+    }
+    flush_list(&t_spectatorDirtyHead, drop, arg);
+}
+
+int conn_on_writable(Connection *c) {
+    // Zgłoszenie POLLOUT w io_uring jest jednorazowe - po krótkim zapisie trzeba je uzbroić od nowa
+    if (t_ring) c->wantWrite = 0;
+    return conn_flush(c);
+}
+
+// io_uring: gotowość do odczytu (lobby) albo odbiór multishot (pokój) z nowym numerem uzbrojenia
+static int arm_input(Connection *c) {
+    struct io_uring_sqe *sqe = uring_sqe(t_ring);
+    if (!sqe) return -1;
+    c->ioGen = ++t_ioGen;
+    c->ioRecv = c->room != NULL;
+    if (c->ioRecv) uring_prep_recv(sqe, c->fd, io_tag(IO_TAG_RECV, c->ioGen, c->fd));
+    else uring_prep_poll(sqe, c->fd, POLLIN, 1, io_tag(IO_TAG_READABLE, c->ioGen, c->fd));
+    return 0;
+}
+
+// io_uring: odwołuje zgłoszenia połączenia z bieżącym numerem uzbrojenia (po user_data, więc
+// działa także wtedy, gdy inny wątek zdąży już zamknąć deskryptor)
+static void cancel_input(Connection *c) {
+    int kind = c->ioRecv ? IO_TAG_RECV : IO_TAG_READABLE;
+    struct io_uring_sqe *sqe = uring_sqe(t_ring);
+    if (sqe) uring_prep_cancel(sqe, io_tag(kind, c->ioGen, c->fd), io_tag(IO_TAG_IGNORE, 0, c->fd));
+    sqe = c->wantWrite ? uring_sqe(t_ring) : NULL;
+    if (sqe) uring_prep_cancel(sqe, io_tag(IO_TAG_WRITABLE, c->ioGen, c->fd), io_tag(IO_TAG_IGNORE, 0, c->fd));
+}
+
+void conn_detach(Connection *c) {
+    unmark_dirty(c);
+    if (t_ring) cancel_input(c);
+    else epoll_ctl(c->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    c->epfd = -1;
+    c->wantWrite = 0;
+}
+
+int conn_attach(Connection *c, int epfd) {
+    c->wantWrite = 0;
+    if (t_ring) {
+        if (arm_input(c) != 0) {
+            LOG_ERROR("io_uring: brak miejsca na zgłoszenie fd=%d", c->fd);
+            return -1;
+        }
+    } else {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = c->fd;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev) == -1) {
+            perror("epoll_ctl");
+            return -1;
+        }
+    }
+    c->epfd = epfd;
+    if (c->chunkCount > 0) mark_dirty(c);
+    return 0;
+}
+
+void conn_use_uring(Uring *ring, Uring *sendRing) {
+    if (sendRing && !t_sendSlots) {
+        t_sendSlots = (SendSlot *)malloc(SEND_BATCH * sizeof(SendSlot));
+        if (!t_sendSlots) sendRing = NULL;   // bez paczek - wysyłka zwykłym writev()
+    }
+    t_ring = ring;
+    t_sendRing = sendRing;
+}
+
+void conn_update_io(Connection *c) {
+    if (!t_ring || !c->room || c->ioRecv || c->dead) return;
+    // Wywoływane po opróżnieniu gniazda przez conn_read() - kolejne dane odbierze już odbiór multishot
+    int wantWrite = c->wantWrite;
+    cancel_input(c);
+    c->wantWrite = 0;
+    if (arm_input(c) != 0) {
+        c->dead = 1;
+        mark_dirty(c);
+        return;
+    }
+    if (wantWrite) set_want_write(c, 1);
+}
+
+void conn_rearm_recv(Connection *c) {
+    struct io_uring_sqe *sqe = uring_sqe(t_ring);
+    if (!sqe) {
+        c->dead = 1;
+        mark_dirty(c);
+        return;
+    }
+    uring_prep_recv(sqe, c->fd, io_tag(IO_TAG_RECV, c->ioGen, c->fd));
+}
+
+void conn_close_fd(int fd) {
+    if (t_ring) {
+        // Odwołanie wszystkich zgłoszeń gniazda (trzymają referencję do pliku), potem zamknięcie;
+        // IOSQE_IO_HARDLINK zachowuje kolejność także wtedy, gdy nie było czego odwoływać
+        struct io_uring_sqe *cancel = uring_sqe(t_ring);
+        if (cancel) {
+            struct io_uring_sqe *sqe = uring_sqe(t_ring);
+            uring_prep_cancel_fd(cancel, fd, io_tag(IO_TAG_IGNORE, 0, fd));
+            if (sqe) {
+                cancel->flags |= IOSQE_IO_HARDLINK;
+                uring_prep_close(sqe, fd, io_tag(IO_TAG_IGNORE, 0, fd));
+                return;
+            }
+        }
+    }
+    close(fd);
+}
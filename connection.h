@@ -0,0 +1,172 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame.h"
+#include "question_bank.h"
+
+struct GameRoom;
+struct Player;
+struct Uring;
+
+// Fragment kolejki wyjściowej: ramka (często współdzielona) i ile z niej już wysłano
+typedef struct OutChunk {
+    Frame *frame;
+    size_t off;
+} OutChunk;
+
+// Bufor wejściowy połączenia: odczyt zbiera wszystkie dostępne bajty naraz,
+// a pełne linie są wycinane w miejscu (bez kopiowania)
+#define IN_BUFFER_SIZE 4096
+#define MAX_LINE_LENGTH (BUFFER_SIZE - 1)
+
+// Wynik conn_read()
+#define CONN_READ_AGAIN   0   // gniazdo opróżnione (EAGAIN)
+#define CONN_READ_FULL    1   // bufor pełny - po przetworzeniu linii czytamy dalej
+#define CONN_READ_CLOSED -1   // klient się rozłączył albo błąd
+
+// Zaplecze wejścia/wyjścia (IO_BACKEND w config.ini): epoll (domyślnie) albo io_uring.
+// Przy io_uring user_data zgłoszeń to [8 bitów rodzaj][24 bity numer uzbrojenia][32 bity deskryptor];
+// numer uzbrojenia (Connection.ioGen) odróżnia zakończenia bieżącego połączenia od spóźnionych
+// zakończeń poprzedniego właściciela deskryptora.
+extern int g_io_uring;
+
+#define IO_TAG_ACCEPT   1     // nowe połączenie gracza (accept multishot)
+#define IO_TAG_ADMIN    2     // nowe połączenie portu administracyjnego
+#define IO_TAG_WAKE     3     // eventfd skrzynki wątku
+#define IO_TAG_TIMER    4     // timerfd koła zegarów
+#define IO_TAG_READABLE 5     // gotowość do odczytu połączenia w lobby (potem zwykły recv())
+#define IO_TAG_RECV     6     // odbiór multishot połączenia w pokoju (dane w buforze pierścienia)
+#define IO_TAG_WRITABLE 7     // miejsce w gnieździe po krótkim zapisie
+#define IO_TAG_IGNORE   8     // odwołania i zamknięcia
+
+static inline uint64_t io_tag(int kind, unsigned gen, int fd) {
+    return ((uint64_t)kind << 56) | ((uint64_t)(gen & 0xFFFFFF) << 32) | (uint32_t)fd;
+}
+static inline int io_tag_kind(uint64_t tag) { return (int)(tag >> 56); }
+static inline unsigned io_tag_gen(uint64_t tag) { return (unsigned)(tag >> 32) & 0xFFFFFF; }
+static inline int io_tag_fd(uint64_t tag) { return (int)(uint32_t)tag; }
+
+// Połączenie klienta wraz z kolejką wyjściową.
+// Kolejka to lista referencji do ramek: rozsyłane wiadomości są współdzielone,
+// a prywatne dopisywane do własnej ramki połączenia. Całość wychodzi na końcu
+// iteracji pętli jednym writev(); resztę, której jądro nie przyjęło, dosyłamy po EPOLLOUT.
+typedef struct Connection {
+    int fd;
+    int epfd;                  // epoll wątku, do którego należy połączenie
+    struct GameRoom *room;     // NULL = połączenie jeszcze w lobby
+    struct Player *player;
+    int proto;                 // PROTO_TEXT albo PROTO_BIN1 (wybierany w lobby linią PROTO=)
+
+    char *in;                  // bufor wejściowy: nieprzetworzone bajty to in[inStart..inEnd)
+    size_t inStart;
+    size_t inEnd;
+    int inDiscard;             // pomijamy resztę za długiej linii (do najbliższego '\n')
+
+    OutChunk *chunks;          // bufor cykliczny fragmentów do wysłania
+    int chunkHead;
+    int chunkCount;
+    int chunkCap;              // potęga dwójki
+    size_t pending;            // ile bajtów czeka łącznie
+    Frame *tail;               // prywatna ramka na końcu kolejki (można do niej dopisywać)
+
+    int wantWrite;             // zarejestrowano EPOLLOUT
+    int dead;                  // do zamknięcia (błąd zapisu / wolny klient)
+    int closeAfterFlush;       // zamknąć po wysłaniu całej kolejki (odpowiedź HTTP portu administracyjnego)
+    int admin;                 // połączenie z portem administracyjnym (/metrics), nie gracz
+    int spectator;             // widz pokoju: kolejka bez rozłączania (najstarsze wiadomości przepadają), wysyłka po graczach
+    int spectatorSlot;         // pozycja w room->spectators
+    unsigned captureId;        // numer połączenia w zapisie zdarzeń (capture.h)
+    unsigned ioGen;            // io_uring: numer uzbrojenia w user_data zgłoszeń
+    int ioRecv;                // io_uring: uzbrojony odbiór multishot (w pokoju), a nie gotowość (lobby)
+    int dirty;                 // jest na liście do wysłania w tej iteracji
+    struct Connection *dirtyPrev;
+    struct Connection *dirtyNext;
+} Connection;
+
+// Grupa odbiorców (widzowie pokoju) z odłożonym rozsyłaniem: wiadomość dla grupy to jedna referencja
+// do ramki dopisana do listy grupy (O(1) niezależnie od liczby członków). Do kolejek członków ramki
+// trafiają dopiero w conn_flush_all(), po wysłaniu danych graczy.
+typedef struct FanoutItem {
+    Frame *frame;
+    int proto;                 // tylko członkowie z tym protokołem (-1 = wszyscy)
+} FanoutItem;
+
+typedef struct Fanout {
+    Connection **members;      // pozycja członka zapisana w conn->spectatorSlot
+    int count;
+    int cap;
+    FanoutItem *items;         // ramki czekające na rozesłanie w tej iteracji
+    int itemCount;
+    int itemCap;
+    int queued;                // jest na liście wątku do rozesłania
+    struct Fanout *next;
+} Fanout;
+
+// Limit bajtów oczekujących w kolejce jednego klienta i reakcja na jego przekroczenie
+extern size_t g_output_high_water;
+extern int g_slow_client_drop;   // 1 = porzucamy nowe wiadomości, 0 = rozłączamy klienta
+// Limit kolejki widza: po jego przekroczeniu pomijane są najstarsze niewysłane wiadomości
+extern size_t g_spectator_high_water;
+
+Connection *conn_create(int fd, int epfd);
+// Zwalnia strukturę (gniazdo zamyka wywołujący)
+void conn_free(Connection *c);
+
+// Wczytuje z gniazda wszystko, co jest dostępne (do zapełnienia bufora). Zwraca CONN_READ_*.
+int conn_read(Connection *c);
+// Dopisuje do bufora wejściowego dane odebrane przez io_uring - tyle, ile się zmieści.
+// Zwraca liczbę przyjętych bajtów (0 = brak pamięci).
+size_t conn_feed(Connection *c, const char *data, size_t len);
+
+// Kolejna pełna linia z bufora (zakończona '\0', bez "\r\n") albo NULL.
+// Wskaźnik jest ważny do następnego conn_read().
+char *conn_next_line(Connection *c);
+
+// Dopisuje wiadomość do kolejki; wysyłka nastąpi w conn_flush_all()
+void conn_send(Connection *c, const char *data, size_t len);
+void conn_send_text(Connection *c, const char *message);
+// Dodaje do kolejki referencję do współdzielonej ramki (bez kopiowania)
+void conn_send_frame(Connection *c, Frame *f);
+
+// Próbuje wysłać kolejkę jednego połączenia. 0 = wszystko wysłane,
+// 1 = reszta czeka na EPOLLOUT, -1 = połączenie do zamknięcia.
+int conn_flush(Connection *c);
+
+// Liczba wywołań writev() (przy io_uring: zgłoszeń sendmsg) od startu (statystyka dla benchmarków)
+extern __thread unsigned long t_write_calls;
+
+// Wysyła kolejki wszystkich połączeń z bieżącej iteracji (lista per wątek): najpierw graczy,
+// potem rozsyła odłożone ramki grup i wysyła kolejki widzów.
+// Dla połączeń do zamknięcia wywołuje 'drop'.
+void conn_flush_all(void (*drop)(Connection *c, void *arg), void *arg);
+
+// Obsługa EPOLLOUT: dosyła zaległe bajty
+int conn_on_writable(Connection *c);
+
+// Dodaje połączenie do grupy i oznacza je jako widza (kolejka bez rozłączania, wysyłka po graczach).
+// 0 albo -1 przy braku pamięci.
+int fanout_add(Fanout *g, Connection *c);
+void fanout_remove(Fanout *g, Connection *c);
+// Odkłada ramkę dla członków z protokołem 'proto' (-1 = wszystkich)
+void fanout_send(Fanout *g, Frame *f, int proto);
+void fanout_free(Fanout *g);
+
+// Przenosi połączenie do epolla innego wątku (przekazanie połączenia)
+void conn_detach(Connection *c);
+int conn_attach(Connection *c, int epfd);
+
+// Bieżący wątek obsługuje gniazda przez io_uring: 'ring' - odbiór i gotowość, 'sendRing' - zbiorcza
+// wysyłka w conn_flush_all() (jedno io_uring_enter na paczkę połączeń). NULL = epoll.
+void conn_use_uring(struct Uring *ring, struct Uring *sendRing);
+// io_uring: połączenie, które weszło do pokoju, przechodzi z gotowości + recv() na odbiór multishot
+// (w lobby zostaje przy gotowości, bo może zostać przekazane innemu wątkowi razem z nieodebranymi danymi)
+void conn_update_io(Connection *c);
+// io_uring: ponownie uzbraja odbiór, który zakończył się bez IORING_CQE_F_MORE
+void conn_rearm_recv(Connection *c);
+// Zamyka gniazdo; przy io_uring odwołanie jego zgłoszeń i zamknięcie idą z kolejną paczką zgłoszeń
+void conn_close_fd(int fd);
+
+#endif
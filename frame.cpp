@@ -0,0 +1,118 @@
+#include "frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+// Lista wolnych ramek z puli (wskaźnik na następną trzymamy w data)
+static __thread Frame *freeFrames = NULL;
+
+static Frame *pool_get() {
+    if (!freeFrames) {
+        size_t stride = sizeof(Frame) + FRAME_POOL_CAP;
+        char *slab = (char *)malloc(stride * FRAME_SLAB_COUNT);
+        if (!slab) return NULL;
+        for (int i = FRAME_SLAB_COUNT - 1; i >= 0; i--) {
+            Frame *f = (Frame *)(slab + stride * i);
+            *(Frame **)f->data = freeFrames;
+            freeFrames = f;
+        }
+    }
+    Frame *f = freeFrames;
+    freeFrames = *(Frame **)f->data;
+    return f;
+}
+
+// Oddaje ramkę do puli albo do free(), zależnie od pochodzenia
+static void frame_release(Frame *f) {
+    if (f->pooled) {
+        *(Frame **)f->data = freeFrames;
+        freeFrames = f;
+    } else {
+        free(f);
+    }
+}
+
+Frame *frame_alloc(size_t cap) {
+    Frame *f;
+    if (cap <= FRAME_POOL_CAP) {
+        f = pool_get();
+        if (!f) return NULL;
+        f->pooled = 1;
+        cap = FRAME_POOL_CAP;
+    } else {
+        f = (Frame *)malloc(sizeof(Frame) + cap);
+        if (!f) return NULL;
+        f->pooled = 0;
+    }
+    f->refs = 1;
+    f->len = 0;
+    f->cap = cap;
+    return f;
+}
+
+Frame *frame_from(const char *data, size_t len) {
+    Frame *f = frame_alloc(len);
+    if (!f) return NULL;
+    memcpy(f->data, data, len);
+    f->len = len;
+    return f;
+}
+
+static Frame *frame_reserve(Frame *f, size_t extra) {
+    if (f->len + extra <= f->cap) return f;
+    size_t newCap = f->cap ? f->cap : 256;
+    while (newCap < f->len + extra) newCap *= 2;
+    if (f->pooled) {
+        // Ramka z puli ma stały rozmiar - przenosimy treść do większej z malloc
+        Frame *g = (Frame *)malloc(sizeof(Frame) + newCap);
+        if (!g) return NULL;
+        memcpy(g, f, sizeof(Frame) + f->len);
+        g->pooled = 0;
+        g->cap = newCap;
+        frame_release(f);
+        return g;
+    }
+    Frame *tmp = (Frame *)realloc(f, sizeof(Frame) + newCap);
+    if (!tmp) return NULL;
+    tmp->cap = newCap;
+    return tmp;
+}
+
+Frame *frame_append(Frame *f, const char *data, size_t len) {
+    Frame *g = frame_reserve(f, len);
+    if (!g) {
+        frame_release(f);
+        return NULL;
+    }
+    memcpy(g->data + g->len, data, len);
+    g->len += len;
+    return g;
+}
+
+Frame *frame_appendf(Frame *f, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(f->data + f->len, f->cap - f->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return f;
+    if ((size_t)n >= f->cap - f->len) {
+        // Za mało miejsca - powiększamy i formatujemy jeszcze raz
+        Frame *g = frame_reserve(f, (size_t)n + 1);
+        if (!g) {
+            frame_release(f);
+            return NULL;
+        }
+        f = g;
+        va_start(ap, fmt);
+        vsnprintf(f->data + f->len, f->cap - f->len, fmt, ap);
+        va_end(ap);
+    }
+    f->len += (size_t)n;
+    return f;
+}
+
+void frame_unref(Frame *f) {
+    if (f && --f->refs == 0) frame_release(f);
+}
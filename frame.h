@@ -0,0 +1,38 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+
+// Bufor z gotową do wysłania wiadomością, współdzielony przez wiele połączeń.
+// Rozsyłana treść (pytanie, ranking) jest formatowana raz, a każde połączenie
+// trzyma tylko referencję. Licznik nie jest atomowy - ramka żyje w jednym wątku reaktora.
+typedef struct Frame {
+    int refs;
+    int pooled;         // 1 = ramka z puli wątku (stała pojemność FRAME_POOL_CAP)
+    size_t len;
+    size_t cap;
+    char data[];
+} Frame;
+
+// Ramki do FRAME_POOL_CAP bajtów pochodzą z puli wątku: przydzielane blokami (slabami)
+// po FRAME_SLAB_COUNT sztuk i po zwolnieniu wracają na listę wolnych zamiast do free().
+// Pula rośnie do szczytowego zapotrzebowania i nie oddaje pamięci.
+#define FRAME_POOL_CAP   1024
+#define FRAME_SLAB_COUNT 64
+
+Frame *frame_alloc(size_t cap);
+Frame *frame_from(const char *data, size_t len);
+
+// Dopisuje bajty (tylko do ramki jeszcze nieudostępnionej). Może przenieść ramkę i zwraca jej nowy adres;
+// przy braku pamięci zwalnia ramkę i zwraca NULL.
+Frame *frame_append(Frame *f, const char *data, size_t len);
+Frame *frame_appendf(Frame *f, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static inline Frame *frame_ref(Frame *f) {
+    f->refs++;
+    return f;
+}
+
+void frame_unref(Frame *f);
+
+#endif
@@ -0,0 +1,110 @@
+#include "fuzzy_match.h"
+
+#include <string.h>
+
+#include "answer_index.h"
+
+static inline uint64_t char_bit(uint32_t c) {
+    return 1ull << ((c * 2654435761u) >> 26);
+}
+
+// Kolejny znak napisu; niepoprawny UTF-8 traktujemy jak pojedynczy bajt (tak jak normalize_answer)
+static inline uint32_t next_char(const unsigned char *s, size_t *i) {
+    if (s[*i] < 0x80) return s[(*i)++];
+    uint32_t cp;
+    int n = utf8_decode(s + *i, &cp);
+    if (n == 0) return s[(*i)++];
+    *i += (size_t)n;
+    return cp;
+}
+
+int fuzzy_pattern_init(FuzzyPattern *p, const char *s, size_t len) {
+    memset(p->ascii, 0, sizeof(p->ascii));
+    p->otherCount = 0;
+    p->len = 0;
+    p->sig = 0;
+    p->bigrams = fuzzy_bigrams(s, len);
+    const unsigned char *u = (const unsigned char *)s;
+    size_t i = 0;
+    while (i < len) {
+        if (p->len == FUZZY_MAX_PATTERN) return -1;
+        uint32_t c = next_char(u, &i);
+        uint64_t bit = 1ull << p->len;
+        p->sig |= char_bit(c);
+        p->len++;
+        if (c < 128) {
+            p->ascii[c] |= bit;
+            continue;
+        }
+        int k = 0;
+        while (k < p->otherCount && p->other[k] != c) k++;
+        if (k == p->otherCount) {
+            p->other[k] = c;
+            p->otherMask[k] = 0;
+            p->otherCount++;
+        }
+        p->otherMask[k] |= bit;
+    }
+    return p->len > 0 ? 0 : -1;
+}
+
+static inline uint64_t peq(const FuzzyPattern *p, uint32_t c) {
+    if (c < 128) return p->ascii[c];
+    for (int k = 0; k < p->otherCount; k++) {
+        if (p->other[k] == c) return p->otherMask[k];
+    }
+    return 0;
+}
+
+int fuzzy_distance(const FuzzyPattern *p, const char *text, size_t len, int maxEdits) {
+    // Pv/Mv: kolumna różnic pionowych +1/-1 (bit i = wiersz i+1). Bity powyżej długości wzorca
+    // nie wpływają na niższe (przeniesienia idą tylko w górę), więc maski nie są potrzebne.
+    uint64_t pv = ~0ull, mv = 0;
+    uint64_t last = 1ull << (p->len - 1);
+    int score = p->len;
+    const unsigned char *u = (const unsigned char *)text;
+    size_t i = 0;
+    while (i < len) {
+        uint64_t eq = peq(p, next_char(u, &i));
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & last) score++;
+        else if (mh & last) score--;
+        // Wiersz zerowy rośnie o 1 w każdej kolumnie (porównujemy całe napisy, nie szukamy podciągu)
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        // Każdy pozostały znak obniża wynik najwyżej o 1 (a znaków jest nie więcej niż bajtów)
+        if (score - (int)(len - i) > maxEdits) return maxEdits + 1;
+    }
+    return score <= maxEdits ? score : maxEdits + 1;
+}
+
+uint64_t fuzzy_signature(const char *s, size_t len, uint32_t *chars) {
+    const unsigned char *u = (const unsigned char *)s;
+    uint64_t sig = 0;
+    uint32_t n = 0;
+    size_t i = 0;
+    while (i < len) {
+        sig |= char_bit(next_char(u, &i));
+        n++;
+    }
+    if (chars) *chars = n;
+    return sig;
+}
+
+uint64_t fuzzy_bigrams(const char *s, size_t len) {
+    const unsigned char *u = (const unsigned char *)s;
+    uint64_t sig = 0;
+    size_t i = 0;
+    uint32_t prev = i < len ? next_char(u, &i) : 0;
+    while (i < len) {
+        uint32_t c = next_char(u, &i);
+        sig |= char_bit(prev * 31 + c);
+        prev = c;
+    }
+    return sig;
+}
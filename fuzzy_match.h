@@ -0,0 +1,44 @@
+#ifndef FUZZY_MATCH_H
+#define FUZZY_MATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Odległość edycyjna (Levenshteina) z limitem, liczona bitowo-równolegle (Myers 1999, wariant Hyyrö
+// dla całych napisów): jedna kolumna macierzy to kilka operacji na słowie 64-bitowym.
+// Wzorcem jest odpowiedź gracza po fold_answer(), porównywana kolejno z kandydatami z bazy.
+#define FUZZY_MAX_PATTERN 64   // dłuższe odpowiedzi (w znakach) porównujemy tylko dokładnie
+
+typedef struct FuzzyPattern {
+    uint64_t ascii[128];                    // maski pozycji znaków ASCII we wzorcu
+    uint32_t other[FUZZY_MAX_PATTERN];      // pozostałe znaki wzorca i ich maski
+    uint64_t otherMask[FUZZY_MAX_PATTERN];
+    int otherCount;
+    int len;                                // długość w znakach
+    uint64_t sig;                           // fuzzy_signature() wzorca
+    uint64_t bigrams;                       // fuzzy_bigrams() wzorca
+} FuzzyPattern;
+
+// Przygotowuje wzorzec z napisu UTF-8 (zakończonego '\0'). Zwraca 0 albo -1, gdy jest pusty lub za długi.
+int fuzzy_pattern_init(FuzzyPattern *p, const char *s, size_t len);
+
+// Odległość wzorca od napisu 'text' (UTF-8, zakończony '\0'), o ile nie przekracza 'maxEdits';
+// w przeciwnym razie maxEdits + 1 (liczenie kończy się wcześniej, gdy wynik nie może już zejść do limitu)
+int fuzzy_distance(const FuzzyPattern *p, const char *text, size_t len, int maxEdits);
+
+// Sygnatura zbioru znaków: bit (hash znaku % 64) dla każdego znaku. Znaki obecne tylko w jednym
+// z napisów wymagają osobnych edycji, więc popcount(a & ~b) > k wyklucza odległość <= k.
+// W 'chars' (jeśli nie NULL) zwraca długość napisu w znakach.
+uint64_t fuzzy_signature(const char *s, size_t len, uint32_t *chars);
+
+// To samo dla par sąsiednich znaków: jedna edycja niszczy najwyżej dwie pary, więc próg to 2 * k
+uint64_t fuzzy_bigrams(const char *s, size_t len);
+
+// Czy sygnatury (znaki i pary znaków) dopuszczają odległość <= maxEdits (filtr przed fuzzy_distance())
+static inline int fuzzy_signature_ok(uint64_t a, uint64_t b, uint64_t pairsA, uint64_t pairsB, int maxEdits) {
+    return __builtin_popcountll(a & ~b) <= maxEdits && __builtin_popcountll(b & ~a) <= maxEdits
+        && __builtin_popcountll(pairsA & ~pairsB) <= 2 * maxEdits
+        && __builtin_popcountll(pairsB & ~pairsA) <= 2 * maxEdits;
+}
+
+#endif
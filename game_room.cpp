@@ -0,0 +1,717 @@
+#include "game_room.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "capture.h"
+#include "connection.h"
+#include "logger.h"
+#include "metrics.h"
+#include "profile_log.h"
+#include "protocol.h"
+
+static void check_round_complete(GameRoom *room);
+
+GameRoom *room_create(int id, TimerWheel *wheel) {
+    GameRoom *room = (GameRoom*) calloc(1, sizeof(GameRoom));
+    if (!room) return NULL;
+    room->id = id;
+    room->wheel = wheel;
+    timer_init(&room->timer, room_on_timer, room);
+    arena_init(&room->roundArena, 0);
+    return room;
+}
+
+// Ustawia zegar pokoju w fazie 'phase' na 'ms' milisekund od 'from_ms' (poprzedni termin przepada)
+static void arm_room_timer(GameRoom *room, int phase, uint64_t from_ms, uint64_t ms) {
+    room->timer_phase = phase;
+    if (room->wheel) timer_schedule(room->wheel, &room->timer, from_ms + ms);
+}
+
+// Sesja, która nie doczeka wznowienia: wynik przerwanej gry trafia do profilu
+static void release_session(Session *s, void *arg) {
+    GameRoom *room = (GameRoom *)arg;
+    if (room->wheel) timer_cancel(room->wheel, &s->timer);
+    if (s->played > 0) profile_record_game(s->name, s->correct, s->score);
+}
+
+// Zwalnia pokój razem z graczami (gniazda zamyka wywołujący)
+void room_destroy(GameRoom *room) {
+    if (room->wheel) timer_cancel(room->wheel, &room->timer);
+    session_table_free(&room->sessions, release_session, room);
+    registry_free(&room->players);
+    free(room->answerTally);
+    free(room->answerEpoch);
+    free(room->topSlots);
+    leaderboard_free(&room->leaderboard);
+    bank_release(room->bank);
+    arena_free(&room->roundArena);
+    fanout_free(&room->spectators);
+    free(room);
+}
+
+// Zmienia flagi gracza, utrzymując liczniki pokoju (grający / grający, którzy odpowiedzieli)
+static void set_player_state(GameRoom *room, Player *p, int in_game, int answered) {
+    room->in_game_count += (in_game == 1) - (p->in_game == 1);
+    room->answered_count += (in_game == 1 && answered == 1) - (p->in_game == 1 && p->answered == 1);
+    p->in_game = in_game;
+    p->answered = answered;
+}
+
+// Dodanie nowego gracza do pokoju
+Player *room_add_player(GameRoom *room, Connection *conn) {
+    Player *p = registry_add(&room->players, conn);
+    if (!p) return NULL;
+    if (leaderboard_add(&room->leaderboard, 0) != 0) {
+        registry_remove(&room->players, conn->fd);
+        return NULL;
+    }
+    p->room = room;
+    room->active_players++;
+    if (conn->proto == PROTO_BIN1) room->binary_players++;
+    return p;
+}
+
+// Pokój bez graczy i bez sesji do wznowienia -> reset stanu
+static void reset_room(GameRoom *room) {
+    room->current_round = 0;
+    room->round_in_progress = 0;
+    room->game++;
+    memset(room->current_question, 0, sizeof(room->current_question));
+    arena_reset(&room->roundArena);
+    // Żaden termin (oczekiwanie, runda, ranking końcowy) nie dotyczy już nowej gry
+    room->timer_phase = ROOM_TIMER_IDLE;
+    if (room->wheel) timer_cancel(room->wheel, &room->timer);
+    LOG_INFO("Wszyscy gracze wyszli z pokoju %d - gra zostaje zresetowana.", room->id);
+}
+
+// Minął czas na wznowienie sesji
+static void session_expired(void *arg) {
+    Session *s = (Session *)arg;
+    GameRoom *room = s->room;
+    if (s->played > 0) profile_record_game(s->name, s->correct, s->score);
+    LOG_INFO("Sesja gracza %s w pokoju %d wygasła.", s->name, room->id);
+    session_remove(&room->sessions, s);
+    metric_add(&t_metrics->sessionsExpired, 1);
+
+    if (room->active_players == 0 && room->sessions.count == 0) {
+        reset_room(room);
+        // Może zwolnić pokój - po tym wywołaniu nie dotykamy już 'room'
+        if (room->on_empty) room->on_empty(room, room->on_empty_arg);
+    }
+}
+
+// Zalogowany gracz, który zerwał połączenie, czeka jako sesja na RESUME=<token>;
+// bez wznawiania (albo bez pamięci na sesję) jego dotychczasowa gra trafia od razu do profilu
+static void park_player(GameRoom *room, const Player *p) {
+    if (!p->got_name || !p->name) return;
+    if (g_resume_grace > 0 && room->wheel && (p->token[0] | p->token[1])) {
+        Session *s = session_add(&room->sessions, p->token, p->name);
+        if (s) {
+            s->score = p->score;
+            s->correct = p->correct;
+            s->played = p->played;
+            s->game = room->game;
+            s->room = room;
+            timer_init(&s->timer, session_expired, s);
+            timer_schedule(room->wheel, &s->timer, monotonic_ms() + (uint64_t)g_resume_grace * 1000ull);
+            metric_add(&t_metrics->sessionsParked, 1);
+            return;
+        }
+        LOG_ERROR("Błąd alokacji sesji gracza %s w pokoju %d", p->name, room->id);
+    }
+    if (p->played > 0) profile_record_game(p->name, p->correct, p->score);
+}
+
+// Usunięcie gracza (rozłączył się itp.)
+void room_remove_player(GameRoom *room, int fd) {
+    Player *p = registry_find(&room->players, fd);
+    if (!p) return;
+    set_player_state(room, p, 0, 0);
+    leaderboard_remove(&room->leaderboard, p->score);
+    if (p->conn && p->conn->proto == PROTO_BIN1) room->binary_players--;
+    park_player(room, p);
+    registry_remove(&room->players, fd);
+    room->active_players--;
+}
+
+// Rozliczenie pokoju po wyjściu gracza (poza blokadą wątku - patrz game_room.h)
+void room_after_leave(GameRoom *room) {
+    // Gra czeka na wznowienie sesji; reset dopiero, gdy nie ma ani graczy, ani sesji
+    if (room->active_players == 0 && room->sessions.count == 0) {
+        reset_room(room);
+    } else if (room->active_players > 0) {
+        // Po wyjściu gracza połowa odpowiedzi może już być zebrana
+        check_round_complete(room);
+    }
+}
+
+// Wyszukiwanie gracza po deskryptorze gniazda
+Player* room_find_player(GameRoom *room, int fd) {
+    return registry_find(&room->players, fd);
+}
+
+// Czy ktoś w pokoju (gracz albo widz) odbiera dany protokół - wariant dla nikogo nie jest kodowany
+static int wants_text(const GameRoom *room) {
+    return room->players.count - room->binary_players + room->spectators.count - room->binary_spectators > 0;
+}
+
+static int wants_bin(const GameRoom *room) {
+    return room->binary_players + room->binary_spectators > 0;
+}
+
+// Rozsyła gotową ramkę do wszystkich graczy i widzów pokoju (każdy dostaje referencję, bez kopiowania)
+void room_broadcast_frame(GameRoom *room, Frame *f) {
+    for (int i = 0; i < room->players.count; i++) {
+        conn_send_frame(room->players.items[i].conn, f);
+    }
+    fanout_send(&room->spectators, f, -1);
+}
+
+// Każdy gracz i widz dostaje wariant we własnym protokole
+void room_broadcast_frames(GameRoom *room, Frame *text, Frame *bin) {
+    for (int i = 0; i < room->players.count; i++) {
+        Connection *c = room->players.items[i].conn;
+        Frame *f = c->proto == PROTO_BIN1 ? bin : text;
+        if (f) conn_send_frame(c, f);
+    }
+    // Widzom ramki trafiają dopiero po wysłaniu danych graczy (conn_flush_all)
+    if (text) fanout_send(&room->spectators, text, PROTO_TEXT);
+    if (bin) fanout_send(&room->spectators, bin, PROTO_BIN1);
+}
+
+// Wysyłanie tekstu do wszystkich w pokoju z protokołem tekstowym
+void room_send_to_all(GameRoom *room, const char *message) {
+    if (!message || !*message || !wants_text(room)) return;
+    Frame *f = frame_from(message, strlen(message));
+    if (!f) return;
+    room_broadcast_frames(room, f, NULL);
+    frame_unref(f);
+}
+
+// Wiadomość do całego pokoju w obu protokołach: 'text' dla klientów tekstowych, ramka 'op' z ładunkiem dla BIN1.
+// Wariant jest kodowany tylko wtedy, gdy w pokoju jest gracz, który go odbierze.
+static void room_send_event(GameRoom *room, const char *text, int op, const char *payload, size_t len) {
+    room_send_to_all(room, text);
+    if (!wants_bin(room)) return;
+    Frame *f = frame_alloc(BIN_HEADER_SIZE + len);
+    if (f) f = bin_append(f, op, payload, len);
+    if (!f) return;
+    room_broadcast_frames(room, NULL, f);
+    frame_unref(f);
+}
+
+static void room_send_event_u16(GameRoom *room, const char *text, int op, unsigned v) {
+    char payload[2];
+    bin_put_u16(payload, v);
+    room_send_event(room, text, op, payload, sizeof(payload));
+}
+
+// Komunikat bez parametrów do jednego gracza: tekst albo pusta ramka BIN1
+static void send_to_player(Connection *c, const char *text, int op) {
+    if (c->proto == PROTO_BIN1) bin_send(c, op, NULL, 0);
+    else conn_send_text(c, text);
+}
+
+// Ładunek OP_QUESTION dla bieżącego pytania: numer rundy i treść (current_question bez "Pytanie: " i '\n')
+static size_t question_payload(const GameRoom *room, char *out) {
+    char text[BUFFER_SIZE];
+    const char *q = room->current_question;
+    if (strncmp(q, "Pytanie: ", 9) == 0) q += 9;
+    snprintf(text, sizeof(text), "%s", q);
+    size_t n = strlen(text);
+    if (n > 0 && text[n - 1] == '\n') text[n - 1] = '\0';
+    char *end = bin_put_str(bin_put_u16(out, (unsigned)room->current_round + 1), text);
+    return (size_t)(end - out);
+}
+
+// Wstawia gracza do listy K najlepszych (malejąco wg wyniku, remisy w kolejności tablicy graczy)
+static void offer_top(GameRoom *room, int *n, int k, int slot) {
+    const Player *items = room->players.items;
+    int score = items[slot].score;
+    int pos = *n;
+    if (pos == k) {
+        if (k == 0 || items[room->topSlots[k - 1]].score >= score) return;
+        pos = k - 1;
+    } else {
+        (*n)++;
+    }
+    while (pos > 0 && items[room->topSlots[pos - 1]].score < score) {
+        room->topSlots[pos] = room->topSlots[pos - 1];
+        pos--;
+    }
+    room->topSlots[pos] = slot;
+}
+
+// Dopisuje do ramki K najlepszych graczy (formatowane raz dla całego pokoju)
+static Frame *append_top_ranking(GameRoom *room, Frame *frame, int n) {
+    frame = frame_appendf(frame, "Runda %d zakończona, wyniki:\n", room->current_round + 1);
+
+    for(int j=0; frame && j<n; j++){
+        const Player *pl = &room->players.items[room->topSlots[j]];
+        // Odpowiedź gracza, lastPoints, sumaryczny score itd.
+        frame = frame_appendf(frame,
+                "%d. %s, Punkty za pytanie: %d, Łącznie: %d, Odpowiedź: %.1000s\n",
+                leaderboard_rank(&room->leaderboard, pl->score),
+                (pl->name ? pl->name : "???"),
+                pl->lastPoints,
+                pl->score,
+                (pl->response ? pl->response : "brak"));
+    }
+    return frame;
+}
+
+// Dołączający w trakcie rundy (gracz albo widz) dostaje pytanie i pozostały czas, ale IN_GAME=0
+static void send_round_state(GameRoom *room, Connection *conn) {
+    if (!room->round_in_progress || room->current_question[0] == '\0') return;
+    double elapsed = (double)(monotonic_ns() - room->round_start_ns) / 1e9;
+    int remaining = g_time_limit - (int)elapsed;
+    if (remaining < 0) remaining = 0;
+    if (conn->proto == PROTO_BIN1) {
+        char question[2 + 2 + BIN_MAX_TEXT];
+        bin_send(conn, OP_QUESTION, question, question_payload(room, question));
+        bin_send_u16(conn, OP_TIME_LEFT, (unsigned)remaining);
+        bin_send_u8(conn, OP_IN_GAME, 0);
+        return;
+    }
+    conn_send_text(conn, room->current_question);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "TIME_LEFT=%d\n", remaining);
+    conn_send_text(conn, msg);
+    conn_send_text(conn, "IN_GAME=0\n");
+}
+
+int room_add_spectator(GameRoom *room, Connection *conn) {
+    if (fanout_add(&room->spectators, conn) != 0) return -1;
+    if (conn->proto == PROTO_BIN1) room->binary_spectators++;
+    send_round_state(room, conn);
+    return 0;
+}
+
+void room_remove_spectator(GameRoom *room, Connection *conn) {
+    if (!conn->spectator) return;
+    fanout_remove(&room->spectators, conn);
+    if (conn->proto == PROTO_BIN1) room->binary_spectators--;
+}
+
+// To samo w ramkach BIN1: OP_ROUND_END, K wpisów OP_RANK_ENTRY, na końcu IN_GAME=0 i TIME_LEFT=0
+static Frame *append_top_ranking_bin(GameRoom *room, Frame *frame, int n) {
+    char buf[10 + 2 * (2 + BIN_MAX_TEXT)];
+    char *end = bin_put_u16(bin_put_u16(buf, (unsigned)room->current_round + 1), (unsigned)n);
+    if (frame) frame = bin_append(frame, OP_ROUND_END, buf, (size_t)(end - buf));
+
+    for (int j = 0; frame && j < n; j++) {
+        const Player *pl = &room->players.items[room->topSlots[j]];
+        end = bin_put_u32(buf, (uint32_t)leaderboard_rank(&room->leaderboard, pl->score));
+        end = bin_put_u16(end, (unsigned)pl->lastPoints);
+        end = bin_put_u32(end, (uint32_t)pl->score);
+        end = bin_put_str(end, pl->name ? pl->name : "");
+        end = bin_put_str(end, pl->response ? pl->response : "");
+        frame = bin_append(frame, OP_RANK_ENTRY, buf, (size_t)(end - buf));
+    }
+
+    bin_put_u8(buf, 0);
+    bin_put_u16(buf + 1, 0);
+    if (frame) frame = bin_append(frame, OP_IN_GAME, buf, 1);
+    if (frame) frame = bin_append(frame, OP_TIME_LEFT, buf + 1, 2);
+    return frame;
+}
+
+// Rozpoczęcie rundy (wysłanie pytania, time_left)
+static void start_round(GameRoom *room) {
+    if (room->current_round >= g_max_rounds) {
+        room_send_event(room, "Gra zakończona!\n", OP_GAME_OVER, NULL, 0);
+        return;
+    }
+    room->round_in_progress = 1;
+
+    // Każdy gracz wchodzi do gry, p->answered=0 się ustawia w end_round
+    for (int i = 0; i < room->players.count; i++) {
+        Player *p = &room->players.items[i];
+        set_player_state(room, p, 1, p->answered);
+        p->answerTime = -1.0;
+    }
+
+    // Runda przypina najnowszą migawkę bazy - przeładowanie w trakcie rundy zadziała od następnej
+    BankSnapshot *snapshot = bank_acquire();
+    bank_release(room->bank);
+    room->bank = snapshot;
+
+    // Jeżeli mamy załadowane pytania, to bierzemy pytanie current_round
+    if (room->bank && room->current_round < room->bank->bank.questionCount) {
+        snprintf(room->current_question, BUFFER_SIZE, "Pytanie: %.1000s\n",
+                 bank_question_text(&room->bank->bank, room->current_round));
+    }
+
+    char question[2 + 2 + BIN_MAX_TEXT];
+    room_send_event(room, room->current_question, OP_QUESTION, question, question_payload(room, question));
+    room->round_start_ns = monotonic_ns();
+    arm_room_timer(room, ROOM_TIMER_ROUND, room->round_start_ns / 1000000ull, (uint64_t)g_time_limit * 1000ull);
+
+    LOG_DEBUG("Pokój %d, start rundy %d, pytanie = %s", room->id, room->current_round+1, room->current_question);
+
+    char timeMsg[64];
+    snprintf(timeMsg, sizeof(timeMsg), "TIME_LEFT=%d\n", g_time_limit);
+    room_send_event_u16(room, timeMsg, OP_TIME_LEFT, (unsigned)g_time_limit);
+}
+
+// Punkty za szybkość (0-10): 10 w pierwszej dziesiątej części czasu, potem o jeden mniej co kolejną dziesiątą
+static int speed_points(double elapsed) {
+    if (g_time_limit <= 0) return 0;
+    if (elapsed < 0) elapsed = (double)g_time_limit;
+    if (elapsed > g_time_limit) elapsed = g_time_limit;
+
+    double delta = (double)g_time_limit / 10.0;
+    // Numer przedziału 'delta', w którym padła odpowiedź (z marginesem jak przy porównaniu progów)
+    int i = (int)ceil((elapsed + 0.000001) / delta) - 1;
+    if (i < 0) i = 0;
+    return i <= 9 ? 10 - i : 0;
+}
+
+// Liczniki odpowiedzi pokoju indeksowane id odpowiedzi z bazy. Licznik jest ważny tylko,
+// gdy jego znacznik równa się bieżącej epoce, więc nowa runda nie musi niczego zerować.
+static int ensure_tally(GameRoom *room, int count) {
+    if (count <= room->tallyCap) return 0;
+    int *tally = (int *)realloc(room->answerTally, sizeof(int) * count);
+    if (!tally) return -1;
+    room->answerTally = tally;
+    uint32_t *epochs = (uint32_t *)realloc(room->answerEpoch, sizeof(uint32_t) * count);
+    if (!epochs) return -1;
+    room->answerEpoch = epochs;
+    memset(room->answerEpoch + room->tallyCap, 0, sizeof(uint32_t) * (count - room->tallyCap));
+    room->tallyCap = count;
+    return 0;
+}
+
+// Zakończenie rundy (liczenie punktów, ranking)
+static void end_round(GameRoom *room) {
+    uint64_t started_ns = monotonic_real_ns();
+    int current_round = room->current_round;
+    const QuestionBank *bank = room->bank ? &room->bank->bank : NULL;
+    int answers = bank ? bank_answer_count(bank, current_round) : 0;
+    int tallyOk = ensure_tally(room, answers) == 0;
+    if (!tallyOk) LOG_ERROR("Błąd alokacji liczników odpowiedzi w pokoju %d", room->id);
+
+    // Jedno przejście: id odpowiedzi z indeksu i zliczenie, ilu graczy ją podało
+    uint32_t epoch = ++room->tallyEpoch;
+    if (epoch == 0) {
+        // Licznik epok się przekręcił - stare znaczniki mogłyby znów wyglądać na aktualne
+        if (room->answerEpoch) memset(room->answerEpoch, 0, sizeof(uint32_t) * room->tallyCap);
+        epoch = room->tallyEpoch = 1;
+    }
+    for (int k = 0; k < room->players.count; k++) {
+        Player *p = &room->players.items[k];
+        p->answerId = -1;
+        if (!tallyOk || p->fd<=0 || p->in_game!=1 || !p->response) continue;
+        int id = bank ? bank_match_answer(bank, current_round, p->response, g_fuzzy_max_edits) : -1;
+        if (id < 0) continue;
+        p->answerId = id;
+        if (room->answerEpoch[id] != epoch) {
+            room->answerEpoch[id] = epoch;
+            room->answerTally[id] = 0;
+        }
+        room->answerTally[id]++;
+    }
+
+    // Lista K najlepszych zbierana w tym samym przejściu co punktacja
+    int topK = g_ranking_top_k;
+    if (topK > room->players.count) topK = room->players.count;
+    if (topK > room->topCap) {
+        int *tmp = (int *)realloc(room->topSlots, sizeof(int) * topK);
+        if (tmp) {
+            room->topSlots = tmp;
+            room->topCap = topK;
+        } else {
+            topK = room->topCap;
+        }
+    }
+    int topCount = 0;
+
+    // Przydzielamy punkty (m.in. za unikalność i szybkość)
+    for (int k = 0; k < room->players.count; k++) {
+        Player *p = &room->players.items[k];
+        int finalPoints = 0;
+        if (p->answerId >= 0) {
+            // Jeżeli więcej niż 1 gracz podał taką samą poprawną -> 5pkt, w przeciwnym razie 10
+            finalPoints = room->answerTally[p->answerId] > 1 ? 5 : 10;
+            finalPoints += speed_points(p->answerTime);
+        }
+        if (p->in_game == 1) {
+            p->played++;
+            if (p->answerId >= 0) p->correct++;
+        }
+        p->lastPoints = finalPoints;
+        if (leaderboard_update(&room->leaderboard, p->score, p->score + finalPoints) != 0) {
+            LOG_ERROR("Błąd alokacji rankingu w pokoju %d", room->id);
+        }
+        p->score += finalPoints;
+        offer_top(room, &topCount, topK, k);
+    }
+
+    // Wysyłamy czołówkę rankingu, blokujemy okienka w kliencie i zerujemy time_left - jedna ramka dla wszystkich
+    uint64_t ranking_ns = monotonic_real_ns();
+    // (osobny wariant dla każdego protokołu obecnego w pokoju)
+    Frame *summary = NULL, *binSummary = NULL;
+    if (wants_text(room)) {
+        summary = frame_alloc(BUFFER_SIZE);
+        if (summary) summary = append_top_ranking(room, summary, topCount);
+        if (summary) summary = frame_append(summary, "IN_GAME=0\nTIME_LEFT=0\n", 22);
+    }
+    if (wants_bin(room)) binSummary = append_top_ranking_bin(room, frame_alloc(BUFFER_SIZE), topCount);
+    room_broadcast_frames(room, summary, binSummary);
+    frame_unref(summary);
+    frame_unref(binSummary);
+
+    // Każdy gracz dostaje jeszcze własne miejsce - rozmiar wiadomości nie rośnie z liczbą graczy
+    for (int k = 0; k < room->players.count; k++) {
+        const Player *p = &room->players.items[k];
+        char msg[128];
+        if (p->conn->proto == PROTO_BIN1) {
+            char *end = bin_put_header(msg, OP_MY_RANK, 14);
+            end = bin_put_u32(end, (uint32_t)leaderboard_rank(&room->leaderboard, p->score));
+            end = bin_put_u32(end, (uint32_t)room->leaderboard.total);
+            end = bin_put_u16(end, (unsigned)p->lastPoints);
+            end = bin_put_u32(end, (uint32_t)p->score);
+            conn_send(p->conn, msg, (size_t)(end - msg));
+            continue;
+        }
+        int len = snprintf(msg, sizeof(msg), "Twoje miejsce: %d/%d, Punkty za pytanie: %d, Łącznie: %d\n",
+                           leaderboard_rank(&room->leaderboard, p->score), room->leaderboard.total,
+                           p->lastPoints, p->score);
+        conn_send(p->conn, msg, (size_t)len);
+    }
+    hist_record_since(&t_metrics->ranking, ranking_ns);
+
+    // Reset state'u na kolejną rundę
+    for (int k = 0; k < room->players.count; k++) {
+        Player *p = &room->players.items[k];
+        if(p->fd>0){
+            set_player_state(room, p, 1, 0);
+        }
+        p->response=NULL;
+    }
+    // Odpowiedzi żyły w arenie rundy - zwalniamy je wszystkie naraz
+    arena_reset(&room->roundArena);
+
+    room->current_round++;
+    if(room->current_round<g_max_rounds){
+        start_round(room);
+    } else {
+        // Ostatnie pytanie -> gra trafia do profili obecnych graczy (gracze z sesji - przy wznowieniu albo wygaśnięciu)
+        for (int k = 0; k < room->players.count; k++) {
+            Player *p = &room->players.items[k];
+            if (p->got_name && p->played > 0) profile_record_game(p->name, p->correct, p->score);
+            p->played = p->correct = 0;
+        }
+        // Koniec gry i czekamy 20s
+        room_send_event_u16(room, "Koniec pytań, za 20 sekund ruszy nowa gra / koniec.\n", OP_QUESTIONS_END,
+                            FINAL_RANKING_WAIT_MS / 1000);
+        room->round_in_progress=0;
+        arm_room_timer(room, ROOM_TIMER_FINAL, monotonic_ms(), FINAL_RANKING_WAIT_MS);
+    }
+    metric_add(&t_metrics->rounds, 1);
+    hist_record_since(&t_metrics->roundEnd, started_ns);
+}
+
+// Token wznowienia jest losowy, więc przy zapisie zdarzeń trafia do zapisu jak dane od klienta,
+// a przy odtwarzaniu połączenie dostaje ten sam token (RESUME= z zapisu pasuje)
+static int new_session_token(Connection *conn, uint64_t token[2]) {
+    if (conn->captureId && capture_replay_token(conn->captureId, token) == 0) return 0;
+    if (session_new_token(token) != 0) return -1;
+    if (conn->captureId && g_capture_fd >= 0) {
+        capture_event(CAPTURE_TOKEN, 0, conn->captureId, (const char *)token, 2 * sizeof(uint64_t));
+    }
+    return 0;
+}
+
+// Nowy token wznowienia (gdy wznawianie jest włączone) i profil gracza z poprzednich gier
+static void send_session_info(GameRoom *room, Player *p) {
+    Connection *conn = p->conn;
+    if (g_resume_grace > 0 && new_session_token(conn, p->token) == 0) {
+        char token[SESSION_TOKEN_TEXT];
+        session_format_token(p->token, room->id, token, sizeof(token));
+        if (conn->proto == PROTO_BIN1) {
+            bin_send_str(conn, OP_TOKEN, token);
+        } else {
+            char msg[16 + SESSION_TOKEN_TEXT];
+            snprintf(msg, sizeof(msg), "TOKEN=%s\n", token);
+            conn_send_text(conn, msg);
+        }
+    }
+
+    ProfileStats stats;
+    if (profile_lookup(p->name, &stats) != 0) return;
+    if (conn->proto == PROTO_BIN1) {
+        char payload[12];
+        bin_put_u32(bin_put_u32(bin_put_u32(payload, stats.games), stats.correct), stats.bestScore);
+        bin_send(conn, OP_PROFILE, payload, sizeof(payload));
+        return;
+    }
+    char msg[96];
+    snprintf(msg, sizeof(msg), "PROFILE=%u,%u,%u\n", stats.games, stats.correct, stats.bestScore);
+    conn_send_text(conn, msg);
+}
+
+// Po zalogowaniu albo wznowieniu sesji: start oczekiwania na graczy albo stan trwającej rundy
+static void after_login(GameRoom *room, Connection *conn) {
+    // Jeżeli to pierwszy gracz -> czekamy 20s, żeby inni mogli dołączyć
+    if(room->active_players==1 && room->current_round<g_max_rounds && !room->round_in_progress){
+        room_send_event_u16(room, "Pierwszy gracz dołączył! Za 20 sekund start rozgrywki...\n", OP_LOBBY_WAIT,
+                            LOBBY_WAIT_MS / 1000);
+        arm_room_timer(room, ROOM_TIMER_LOBBY, monotonic_ms(), LOBBY_WAIT_MS);
+    }
+
+    // Jeśli runda w trakcie -> nowy gracz dostaje pytanie + time_left, ale IN_GAME=0
+    send_round_state(room, conn);
+}
+
+int room_resume_player(GameRoom *room, Player *p, const uint64_t token[2]) {
+    Session *s = session_find(&room->sessions, token);
+    if (!s || registry_set_name(&room->players, p, s->name) != 0) return -1;
+    if (room->wheel) timer_cancel(room->wheel, &s->timer);
+
+    // Wynik wraca tylko do gry, w której został zdobyty; zakończona gra trafia do profilu
+    int score = 0;
+    if (s->game == room->game) {
+        score = s->score;
+        p->correct = s->correct;
+        p->played = s->played;
+    } else if (s->played > 0) {
+        profile_record_game(s->name, s->correct, s->score);
+    }
+    p->got_name = 1;
+    p->token[0] = token[0];
+    p->token[1] = token[1];
+    leaderboard_update(&room->leaderboard, p->score, score);
+    p->score = score;
+    set_player_state(room, p, 0, 0); // jak przy logowaniu: gra od następnej rundy
+    session_remove(&room->sessions, s);
+    metric_add(&t_metrics->sessionsResumed, 1);
+
+    Connection *conn = p->conn;
+    if (conn->proto == PROTO_BIN1) {
+        char payload[8];
+        bin_put_u32(bin_put_u32(payload, (uint32_t)room->id), (uint32_t)score);
+        bin_send(conn, OP_RESUMED, payload, sizeof(payload));
+    } else {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "RESUMED=%d:%d\n", room->id, score);
+        conn_send_text(conn, msg);
+    }
+    LOG_DEBUG("Wznowiono sesję %s(fd=%d) w pokoju %d, wynik=%d", p->name, p->fd, room->id, score);
+    after_login(room, conn);
+    return 0;
+}
+
+// Obsługa danych od gracza (przyjście pseudonimu lub odpowiedzi)
+void room_handle_message(GameRoom *room, Player *p, const char *buffer) {
+    Connection *conn = p->conn;
+
+    // Jeśli nie ustalono pseudonimu, to wybieramy inny
+    if(!p->got_name){
+        // Pseudonim gracza czekającego na wznowienie sesji też jest zajęty
+        if(registry_name_taken(&room->players, buffer) || session_name_taken(&room->sessions, buffer)){
+            send_to_player(conn, "Pseudonim zajęty, wybierz inny.\n", OP_NAME_TAKEN);
+            return;
+        }
+        if(registry_set_name(&room->players, p, buffer)!=0) return;
+        p->got_name=1;
+        leaderboard_update(&room->leaderboard, p->score, 0);
+        p->score=0;
+        p->played=p->correct=0;
+        set_player_state(room, p, 0, 0); // poczeka do next rundy
+        // Token i profil przed potwierdzeniem - klient.py pokazuje w okienku ostatni komunikat
+        send_session_info(room, p);
+        send_to_player(conn, "Zalogowano pomyślnie!\n", OP_LOGIN_OK);
+
+        LOG_DEBUG("Zalogował się %s(fd=%d) w pokoju %d, active_players=%d",
+                  p->name, p->fd, room->id, room->active_players);
+        after_login(room, conn);
+        return;
+    }
+
+    // W przeciwnym razie -> to jest odpowiedź gracza
+    if(p->answered==0 && p->in_game==1){
+        uint64_t started_ns = monotonic_real_ns();
+        p->response=arena_strdup(&room->roundArena, buffer);
+        set_player_state(room, p, 1, 1);
+        p->answerTime = (double)(monotonic_ns() - room->round_start_ns) / 1e9;
+        // Potwierdzenie przed ewentualnym końcem rundy, żeby klient dostał je przed rankingiem
+        if (conn->proto == PROTO_BIN1) bin_send_u8(conn, OP_ANSWER_ACK, 1);
+
+        LOG_DEBUG("Gracz %s odpowiedział: %s", p->name, p->response);
+        check_round_complete(room);
+        metric_add(&t_metrics->answers, 1);
+        hist_record_since(&t_metrics->answer, started_ns);
+    } else if (conn->proto == PROTO_BIN1) {
+        // Poza rundą albo druga odpowiedź - tekstowy klient nie dostaje tu nic, binarny wie, że odpowiedź przepadła
+        bin_send_u8(conn, OP_ANSWER_ACK, 0);
+    }
+}
+
+// Runda kończy się przed czasem, gdy odpowiedziała co najmniej połowa grających.
+// Wywoływane zaraz po odpowiedzi, która mogła przekroczyć próg, i po wyjściu gracza.
+static void check_round_complete(GameRoom *room) {
+    if (!room->round_in_progress) return;
+
+    // Liczniki są utrzymywane przy każdej zmianie stanu gracza - sprawdzenie kosztuje O(1)
+    int total_in_game = room->in_game_count;
+    int answered_count = room->answered_count;
+
+    int required_answers;
+    // Zaokrąglamy w górę: (total_in_game+1)/2
+    if (total_in_game % 2 == 0) {
+        required_answers = (total_in_game / 2) + 1;
+    } else {
+        required_answers = (total_in_game + 1) / 2;
+    }
+
+    if (answered_count >= required_answers) {
+        end_round(room);
+    }
+}
+
+void room_on_timer(void *arg) {
+    GameRoom *room = (GameRoom *)arg;
+    int phase = room->timer_phase;
+    room->timer_phase = ROOM_TIMER_IDLE;
+
+    // Minęło 20 s oczekiwania na pozostałych graczy
+    if(phase==ROOM_TIMER_LOBBY){
+        if(room->active_players>0 && !room->round_in_progress && room->current_round<g_max_rounds){
+            start_round(room);
+        }
+        return;
+    }
+
+    // Minęło 20 s pokazywania rankingu końcowego
+    if(phase==ROOM_TIMER_FINAL){
+        room->game++;
+        if(room->active_players>0){
+            // Reset punktów, start nowej gry
+            leaderboard_clear(&room->leaderboard);
+            for (int i = 0; i < room->players.count; i++) {
+                Player *tmp = &room->players.items[i];
+                tmp->score = 0;
+                leaderboard_add(&room->leaderboard, 0);
+                tmp->response = NULL;
+                set_player_state(room, tmp, 0, 0);
+            }
+            arena_reset(&room->roundArena);
+            room_send_event(room, "Nowa gra rozpoczęta!\n", OP_NEW_GAME, NULL, 0);
+            room->current_round = 0;
+            start_round(room);
+        } else {
+            // Pokój czeka na kolejnych graczy (serwer obsługuje dalej pozostałe pokoje)
+            room->current_round = 0;
+        }
+        return;
+    }
+
+    // Upłynął czas rundy
+    if (room->round_in_progress) {
+        end_round(room);
+    }
+}
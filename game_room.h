@@ -0,0 +1,110 @@
+#ifndef GAME_ROOM_H
+#define GAME_ROOM_H
+
+#include <stdint.h>
+
+#include "arena.h"
+#include "connection.h"
+#include "leaderboard.h"
+#include "player_registry.h"
+#include "question_bank.h"
+#include "session.h"
+#include "timer_wheel.h"
+
+struct GameRoom;
+struct Connection;
+struct Frame;
+
+// Pokój gry: własna lista graczy, licznik rund, zegar rundy i punktacja.
+// Baza pytań (question_bank) jest współdzielona przez wszystkie pokoje.
+typedef struct GameRoom {
+    int id;
+
+    // Gracze w ciągłej tablicy z indeksami po deskryptorze i pseudonimie, plus ogólne liczniki
+    PlayerRegistry players;
+    int active_players;
+    int in_game_count;          // gracze biorący udział w bieżącej rundzie
+    int answered_count;         // ... i ci z nich, którzy już odpowiedzieli
+    int binary_players;         // gracze z protokołem BIN1 (reszta dostaje tekst)
+
+    // Widzowie: dostają pytania, czas i rankingi (te same ramki co gracze), ale nie grają
+    // i nie liczą się do active_players ani do reguły wcześniejszego końca rundy
+    Fanout spectators;
+    int binary_spectators;
+
+    // Zalogowani gracze, którzy zerwali połączenie: pseudonim zostaje zajęty, a wynik czeka
+    // RESUME_GRACE sekund na RESUME=<token>. Pokój z sesjami nie jest resetowany ani usuwany.
+    SessionTable sessions;
+    unsigned game;              // numer gry w pokoju (wynik sesji wraca tylko do tej samej gry)
+    // Wywoływane, gdy po wygaśnięciu ostatniej sesji w pokoju nie ma już graczy (serwer może go usunąć)
+    void (*on_empty)(struct GameRoom *room, void *arg);
+    void *on_empty_arg;
+
+    // Ranking aktualizowany przy każdej zmianie wyniku; topSlots to bufor na K najlepszych (pozycje graczy)
+    Leaderboard leaderboard;
+    int *topSlots;
+    int topCap;
+
+    // Zmienne stanu rund
+    int current_round;
+    int round_in_progress;
+    char current_question[BUFFER_SIZE];
+    uint64_t round_start_ns;    // start rundy (ns zegara monotonicznego)
+    BankSnapshot *bank;         // migawka bazy pytań przypięta na czas rundy
+    Arena roundArena;           // odpowiedzi graczy z bieżącej rundy (czyszczona w end_round)
+
+    // Liczniki odpowiedzi z bieżącej rundy (id odpowiedzi -> ilu graczy), unieważniane epoką
+    int *answerTally;
+    uint32_t *answerEpoch;
+    int tallyCap;
+    uint32_t tallyEpoch;
+
+    // Jeden zegar pokoju: koniec oczekiwania na graczy, koniec rundy albo koniec rankingu końcowego;
+    // timer_phase mówi, na który z nich czeka (ROOM_TIMER_*)
+    int timer_phase;
+    Timer timer;
+    TimerWheel *wheel;          // koło zegarów wątku, do którego należy pokój
+} GameRoom;
+
+// Na co czeka zegar pokoju
+#define ROOM_TIMER_IDLE  0      // zegar nieustawiony
+#define ROOM_TIMER_LOBBY 1      // 20 s oczekiwania na graczy przed pierwszą rundą
+#define ROOM_TIMER_ROUND 2      // koniec czasu rundy
+#define ROOM_TIMER_FINAL 3      // 20 s pokazywania rankingu końcowego
+
+// Czas oczekiwania na graczy przed startem gry i czas pokazywania rankingu końcowego
+#define LOBBY_WAIT_MS         20000
+#define FINAL_RANKING_WAIT_MS 20000
+
+GameRoom *room_create(int id, TimerWheel *wheel);
+void room_destroy(GameRoom *room);
+
+// Dodanie nowego gracza do pokoju (połączenie już zaakceptowane)
+Player *room_add_player(GameRoom *room, struct Connection *conn);
+// Usunięcie gracza z pokoju (gniazdo zamyka wywołujący). Zalogowany gracz zostaje jako sesja
+// do wznowienia, a bez wznawiania wynik jego gry trafia od razu do profilu. Potem room_after_leave().
+void room_remove_player(GameRoom *room, int fd);
+// Po wyjściu gracza: reset pustego pokoju albo koniec rundy, jeśli połowa odpowiedzi jest już zebrana
+// (end_round() z rozesłaniem rankingu - wołać poza blokadą, pod którą zmieniono liczbę graczy)
+void room_after_leave(GameRoom *room);
+// Wznowienie: gracz świeżo dodany przez room_add_player dostaje pseudonim i wynik sesji o danym tokenie
+// (wynik tylko wtedy, gdy trwa ta sama gra). Zwraca 0 albo -1, gdy takiej sesji nie ma.
+int room_resume_player(GameRoom *room, Player *p, const uint64_t token[2]);
+Player *room_find_player(GameRoom *room, int fd);
+
+// Widz pokoju: od razu dostaje bieżące pytanie i czas, jeśli runda trwa. 0 albo -1 przy braku pamięci.
+int room_add_spectator(GameRoom *room, struct Connection *conn);
+void room_remove_spectator(GameRoom *room, struct Connection *conn);
+
+// Obsługa jednej linii od gracza: pseudonim albo odpowiedź
+void room_handle_message(GameRoom *room, Player *p, const char *message);
+
+// Wywoływane przez koło zegarów, gdy minie termin pokoju (start gry, koniec rundy, ranking końcowy)
+void room_on_timer(void *arg);
+
+void room_send_to_all(GameRoom *room, const char *message);
+void room_broadcast_frame(GameRoom *room, struct Frame *f);
+// Rozsyła gotowe warianty wiadomości: 'text' graczom z protokołem tekstowym, 'bin' graczom z BIN1 (NULL = pomiń)
+void room_broadcast_frames(GameRoom *room, struct Frame *text, struct Frame *bin);
+
+#endif
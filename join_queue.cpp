@@ -0,0 +1,82 @@
+#include "join_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Kolejka połączeń oczekujących na accept() w jądrze (jądro obcina ją do net.core.somaxconn)
+int g_listen_backlog = SOMAXCONN;
+
+// Powitań na sekundę na cały serwer (dzielone między wątki); 0 = bez tempa
+int g_join_rate = 0;
+
+// Ile przyjętych gniazd może czekać na powitanie (na cały serwer)
+int g_join_queue = 10000;
+
+int join_queue_init(JoinQueue *q, double rate, int limit) {
+    memset(q, 0, sizeof(*q));
+    if (rate <= 0) return 0;
+    if (limit < 1) limit = 1;
+    q->fds = (int *)malloc((size_t)limit * sizeof(int));
+    q->since = (uint64_t *)malloc((size_t)limit * sizeof(uint64_t));
+    if (!q->fds || !q->since) {
+        join_queue_free(q);
+        return -1;
+    }
+    q->cap = limit;
+    q->interval = (uint64_t)(1e9 / rate);
+    if (q->interval == 0) q->interval = 1;
+    // Po przerwie od razu przechodzi tyle powitań, ile przypada na 100 ms
+    uint64_t burst = (uint64_t)(rate / 10);
+    q->tolerance = burst > 1 ? (burst - 1) * q->interval : 0;
+    return 0;
+}
+
+void join_queue_free(JoinQueue *q) {
+    for (int i = 0; i < q->count; i++) close(q->fds[(q->head + i) % q->cap]);
+    free(q->fds);
+    free(q->since);
+    memset(q, 0, sizeof(*q));
+}
+
+// Czy tempo pozwala teraz na powitanie; jeśli tak, zużywa je
+static int take_slot(JoinQueue *q, uint64_t now_ns) {
+    if (q->tat > now_ns + q->tolerance) return 0;
+    q->tat = (q->tat > now_ns ? q->tat : now_ns) + q->interval;
+    return 1;
+}
+
+int join_queue_offer(JoinQueue *q, int fd, uint64_t now_ns) {
+    if (q->interval == 0) return JOIN_ADMIT;
+    // Kolejność przyjęć: nowy nie wyprzedza czekających
+    if (q->count == 0 && take_slot(q, now_ns)) return JOIN_ADMIT;
+    if (q->count == q->cap) return JOIN_REJECT;
+    int slot = (q->head + q->count) % q->cap;
+    q->fds[slot] = fd;
+    q->since[slot] = now_ns;
+    q->count++;
+    return JOIN_QUEUED;
+}
+
+int join_queue_next(JoinQueue *q, uint64_t now_ns, uint64_t *since) {
+    if (q->count == 0 || !take_slot(q, now_ns)) return -1;
+    int fd = q->fds[q->head];
+    if (since) *since = q->since[q->head];
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    return fd;
+}
+
+uint64_t join_queue_delay_ms(const JoinQueue *q, uint64_t now_ns) {
+    uint64_t ready = q->tat > q->tolerance ? q->tat - q->tolerance : 0;
+    if (ready <= now_ns) return 1;
+    uint64_t ms = (ready - now_ns + 999999) / 1000000;
+    return ms > 0 ? ms : 1;
+}
+
+int join_queue_retry_after(const JoinQueue *q) {
+    uint64_t ns = (uint64_t)q->count * q->interval;
+    int seconds = (int)((ns + 999999999) / 1000000000);
+    return seconds > 0 ? seconds : 1;
+}
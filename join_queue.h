@@ -0,0 +1,49 @@
+#ifndef JOIN_QUEUE_H
+#define JOIN_QUEUE_H
+
+#include <stdint.h>
+
+// Przyjmowanie fali połączeń (wszyscy dołączają w oknie przed startem gry).
+// Gniazdo nasłuchujące ma głęboką kolejkę (LISTEN_BACKLOG), a wątek opróżnia ją od razu do końca,
+// więc jądro nie odrzuca połączeń. Powitanie i logowanie dostają jednak tempo JOIN_RATE: nadmiar
+// czeka w kolejce przyjęć jako samo gniazdo (bez Connection i bez rejestracji w epollu), a gdy i ona
+// jest pełna, klient dostaje od razu "Serwer pełny, spróbuj ponownie za N s" i jest rozłączany.
+extern int g_listen_backlog;
+extern int g_join_rate;         // powitań na sekundę na cały serwer; 0 = bez tempa i bez kolejki
+extern int g_join_queue;        // limit czekających gniazd na cały serwer
+
+// Wynik join_queue_offer()
+#define JOIN_ADMIT   0          // można od razu powitać
+#define JOIN_QUEUED  1          // gniazdo czeka w kolejce
+#define JOIN_REJECT -1          // kolejka pełna
+
+// Kolejka przyjęć jednego wątku. Tempo wyznacza algorytm GCRA (odpowiednik wiadra żetonów):
+// każde powitanie przesuwa teoretyczny czas następnego o 'interval', a 'burst' powitań może
+// przejść od razu po przerwie.
+typedef struct JoinQueue {
+    int *fds;                   // bufor cykliczny gniazd
+    uint64_t *since;            // kiedy gniazdo trafiło do kolejki (ns, do histogramu czekania)
+    int head;
+    int count;
+    int cap;
+    uint64_t interval;          // ns na jedno powitanie
+    uint64_t tolerance;         // (burst - 1) * interval
+    uint64_t tat;               // teoretyczny czas kolejnego powitania (ns)
+} JoinQueue;
+
+// 'rate' - powitań na sekundę (0 = bez kolejki: join_queue_offer() zawsze przyjmuje).
+// Zwraca 0 albo -1 przy braku pamięci.
+int join_queue_init(JoinQueue *q, double rate, int limit);
+// Zamyka czekające gniazda i zwalnia kolejkę
+void join_queue_free(JoinQueue *q);
+
+// Nowe gniazdo: JOIN_ADMIT, JOIN_QUEUED albo JOIN_REJECT (gniazdo zostaje u wywołującego)
+int join_queue_offer(JoinQueue *q, int fd, uint64_t now_ns);
+// Kolejne gniazdo z kolejki, jeśli tempo na nie pozwala (i kiedy trafiło do kolejki), albo -1
+int join_queue_next(JoinQueue *q, uint64_t now_ns, uint64_t *since);
+// Za ile ms tempo pozwoli na kolejne powitanie (co najmniej 1)
+uint64_t join_queue_delay_ms(const JoinQueue *q, uint64_t now_ns);
+// Po ilu sekundach odrzucony klient ma szansę na miejsce (czas opróżnienia kolejki, co najmniej 1)
+int join_queue_retry_after(const JoinQueue *q);
+
+#endif
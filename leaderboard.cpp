@@ -0,0 +1,84 @@
+#include "leaderboard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void tree_add(Leaderboard *lb, int score, int delta) {
+    for (int i = score + 1; i <= lb->size; i += i & -i) lb->tree[i] += delta;
+}
+
+// Liczba graczy z wynikiem <= score
+static int tree_prefix(const Leaderboard *lb, int score) {
+    if (score >= lb->size) score = lb->size - 1;
+    int sum = 0;
+    for (int i = score + 1; i > 0; i -= i & -i) sum += lb->tree[i];
+    return sum;
+}
+
+// Powiększa zakres wyników tak, by mieścił 'score', i odbudowuje drzewo z counts w O(size)
+static int ensure_score(Leaderboard *lb, int score) {
+    if (score < lb->size) return 0;
+    int newSize = lb->size ? lb->size : 64;
+    while (newSize <= score) newSize *= 2;
+
+    int *counts = (int *)realloc(lb->counts, sizeof(int) * newSize);
+    if (!counts) return -1;
+    memset(counts + lb->size, 0, sizeof(int) * (newSize - lb->size));
+    lb->counts = counts;
+
+    int *tree = (int *)realloc(lb->tree, sizeof(int) * (newSize + 1));
+    if (!tree) return -1;
+    lb->tree = tree;
+    lb->size = newSize;
+
+    memset(lb->tree, 0, sizeof(int) * (newSize + 1));
+    for (int i = 1; i <= newSize; i++) {
+        lb->tree[i] += lb->counts[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= newSize) lb->tree[parent] += lb->tree[i];
+    }
+    return 0;
+}
+
+int leaderboard_add(Leaderboard *lb, int score) {
+    if (score < 0) score = 0;
+    if (ensure_score(lb, score) != 0) return -1;
+    lb->counts[score]++;
+    tree_add(lb, score, 1);
+    lb->total++;
+    return 0;
+}
+
+void leaderboard_remove(Leaderboard *lb, int score) {
+    if (score < 0) score = 0;
+    if (score >= lb->size || lb->counts[score] == 0) return;
+    lb->counts[score]--;
+    tree_add(lb, score, -1);
+    lb->total--;
+}
+
+int leaderboard_update(Leaderboard *lb, int oldScore, int newScore) {
+    if (oldScore == newScore) return 0;
+    if (ensure_score(lb, newScore) != 0) return -1;
+    leaderboard_remove(lb, oldScore);
+    return leaderboard_add(lb, newScore);
+}
+
+int leaderboard_rank(const Leaderboard *lb, int score) {
+    if (lb->size == 0) return 1;
+    return 1 + lb->total - tree_prefix(lb, score);
+}
+
+void leaderboard_clear(Leaderboard *lb) {
+    if (lb->size > 0) {
+        memset(lb->counts, 0, sizeof(int) * lb->size);
+        memset(lb->tree, 0, sizeof(int) * (lb->size + 1));
+    }
+    lb->total = 0;
+}
+
+void leaderboard_free(Leaderboard *lb) {
+    free(lb->counts);
+    free(lb->tree);
+    memset(lb, 0, sizeof(*lb));
+}
@@ -0,0 +1,27 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+// Ranking pokoju jako indeks wyników: counts[s] = ilu graczy ma wynik s,
+// a nad nim drzewo Fenwicka, dzięki któremu miejsce gracza liczymy w O(log S).
+// Aktualizowany na bieżąco przy każdej zmianie wyniku, bez sortowania graczy.
+typedef struct Leaderboard {
+    int *counts;
+    int *tree;          // drzewo Fenwicka nad counts (indeksy od 1)
+    int size;           // potęga dwójki; obsługiwane wyniki 0..size-1
+    int total;          // liczba graczy w rankingu
+} Leaderboard;
+
+// Dodaje gracza z wynikiem 'score' (>= 0). Zwraca 0 albo -1 przy błędzie alokacji.
+int leaderboard_add(Leaderboard *lb, int score);
+void leaderboard_remove(Leaderboard *lb, int score);
+// Zmiana wyniku gracza. Zwraca 0 albo -1 przy błędzie alokacji (ranking bez zmian).
+int leaderboard_update(Leaderboard *lb, int oldScore, int newScore);
+
+// Miejsce gracza z danym wynikiem: 1 + liczba graczy z wyższym wynikiem
+int leaderboard_rank(const Leaderboard *lb, int score);
+
+// Usuwa wszystkich graczy z rankingu (pamięć zostaje)
+void leaderboard_clear(Leaderboard *lb);
+void leaderboard_free(Leaderboard *lb);
+
+#endif
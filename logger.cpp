@@ -0,0 +1,389 @@
+#include "logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "metrics.h"
+
+#define LOG_TEXT_SIZE (LOG_RECORD_SIZE - 2 * sizeof(uint64_t) - LOG_MAX_ARGS * sizeof(uint64_t) - 4)
+#define LOG_OUT_SIZE (64 * 1024)    // bufor wątku dziennika - jedno write() na paczkę
+#define LOG_LINE_MAX 2048           // tyle miejsca w buforze wystarcza na jeden sformatowany wpis
+
+// Wpis w postaci surowej: format (stała z programu), argumenty liczbowe jako 64 bity
+// (double - bitowo) i skopiowane napisy, jeden po drugim, każdy zakończony '\0'
+typedef struct LogRecord {
+    uint64_t ns;                // CLOCK_REALTIME
+    const char *fmt;
+    uint64_t args[LOG_MAX_ARGS];
+    uint8_t level;
+    uint8_t argCount;
+    uint16_t textLen;
+    char text[LOG_TEXT_SIZE];
+} LogRecord;
+
+static_assert(sizeof(LogRecord) == LOG_RECORD_SIZE, "LogRecord musi mieć LOG_RECORD_SIZE bajtów");
+
+// Pierścień jednego wątku: 'tail' przesuwa tylko producent, 'head' tylko wątek dziennika
+// (osobne linie pamięci podręcznej, żeby się nie unieważniały)
+typedef struct LogRing {
+    unsigned tail __attribute__((aligned(64)));
+    uint64_t dropped;           // pominięte przy pełnym pierścieniu (pisze producent)
+    unsigned head __attribute__((aligned(64)));
+    unsigned limit;             // koniec bieżącej paczki (wątek dziennika)
+    uint64_t reported;          // ile pominiętych już zgłoszono (wątek dziennika)
+    struct LogRing *next;
+    LogRecord records[LOG_RING_RECORDS];
+} LogRing;
+
+static __thread LogRing *t_ring = NULL;
+static LogRing *rings = NULL;   // lista wszystkich pierścieni (tylko dopisywana, czytana bez blokady)
+static pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t loggerThread;
+static int running = 0;
+static int stopping = 0;
+static int sleeping = 0;        // wątek dziennika czeka na futeksie (wszystkie pierścienie były puste)
+static LoggerCounters counters;
+
+// Kolejna konwersja formatu od 'p' (pomija "%%"): zwraca wskaźnik na '%' albo NULL.
+// *mod - początek modyfikatora długości (albo znak konwersji), *conv - znak konwersji,
+// *len - modyfikator: 'H' (hh), 'h', 'l', 'L' (ll), 'z', 'j', 't' albo 0.
+static const char *next_spec(const char *p, const char **mod, char *conv, char *len) {
+    for (;;) {
+        p = strchr(p, '%');
+        if (!p) return NULL;
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        const char *q = p + 1;
+        while (*q && strchr("-+ #0", *q)) q++;
+        while (*q >= '0' && *q <= '9') q++;
+        if (*q == '.') {
+            q++;
+            while (*q >= '0' && *q <= '9') q++;
+        }
+        *mod = q;
+        *len = 0;
+        if (*q == 'h' || *q == 'l') {
+            *len = *q++;
+            if (*q == *len) {
+                *len = *len == 'h' ? 'H' : 'L';
+                q++;
+            }
+        } else if (*q == 'z' || *q == 'j' || *q == 't') {
+            *len = *q++;
+        }
+        if (!*q) return NULL;
+        *conv = *q;
+        return p;
+    }
+}
+
+static int is_float_conv(char conv) {
+    return conv == 'f' || conv == 'F' || conv == 'e' || conv == 'E' || conv == 'g' || conv == 'G';
+}
+
+static void futex_wake(int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static LogRing *register_ring() {
+    void *mem = NULL;
+    if (posix_memalign(&mem, 64, sizeof(LogRing)) != 0) return NULL;
+    memset(mem, 0, sizeof(LogRing));
+    LogRing *r = (LogRing *)mem;
+    pthread_mutex_lock(&ringsLock);
+    r->next = rings;
+    __atomic_store_n(&rings, r, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&ringsLock);
+    t_ring = r;
+    return r;
+}
+
+void logger_write(int level, const char *fmt, ...) {
+    if (!__atomic_load_n(&running, __ATOMIC_RELAXED)) return;
+    LogRing *r = t_ring ? t_ring : register_ring();
+    if (!r) return;
+    unsigned tail = r->tail;
+    if (tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == LOG_RING_RECORDS) {
+        // Wątek dziennika nie nadąża - nie czekamy na niego
+        __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+        metric_add(&t_metrics->logDropped, 1);
+        return;
+    }
+
+    LogRecord *rec = &r->records[tail & (LOG_RING_RECORDS - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec->ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    rec->fmt = fmt;
+    rec->level = (uint8_t)level;
+
+    int argCount = 0;
+    size_t textLen = 0;
+    va_list ap;
+    va_start(ap, fmt);
+    const char *p = fmt, *mod;
+    char conv, len;
+    while ((p = next_spec(p, &mod, &conv, &len)) != NULL) {
+        p = mod + (len == 'H' || len == 'L' ? 2 : len ? 1 : 0) + 1;
+        uint64_t v;
+        if (conv == 's') {
+            const char *s = va_arg(ap, const char *);
+            if (!s) s = "(null)";
+            if (textLen < sizeof(rec->text)) {
+                size_t n = strnlen(s, sizeof(rec->text) - textLen - 1);
+                memcpy(rec->text + textLen, s, n);
+                rec->text[textLen + n] = '\0';
+                textLen += n + 1;
+            }
+            continue;
+        } else if (is_float_conv(conv)) {
+            double d = va_arg(ap, double);
+            memcpy(&v, &d, sizeof(v));
+        } else if (conv == 'p') {
+            v = (uint64_t)(uintptr_t)va_arg(ap, void *);
+        } else if (conv == 'd' || conv == 'i') {
+            if (len == 'L') v = (uint64_t)va_arg(ap, long long);
+            else if (len == 'l') v = (uint64_t)va_arg(ap, long);
+            else if (len == 'z' || len == 't') v = (uint64_t)va_arg(ap, ptrdiff_t);
+            else if (len == 'j') v = (uint64_t)va_arg(ap, intmax_t);
+            else v = (uint64_t)va_arg(ap, int);
+        } else {
+            // u x X o c (i nieobsługiwane - jako int)
+            if (len == 'L') v = va_arg(ap, unsigned long long);
+            else if (len == 'l') v = va_arg(ap, unsigned long);
+            else if (len == 'z' || len == 't') v = va_arg(ap, size_t);
+            else if (len == 'j') v = va_arg(ap, uintmax_t);
+            else v = va_arg(ap, unsigned);
+        }
+        if (argCount < LOG_MAX_ARGS) rec->args[argCount++] = v;
+    }
+    va_end(ap);
+    rec->argCount = (uint8_t)argCount;
+    rec->textLen = (uint16_t)textLen;
+    // seq_cst: zapis ogona przed odczytem 'sleeping' (para z logger_loop)
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_SEQ_CST);
+    // Budzimy uśpiony wątek dziennika - wywołanie systemowe tylko przy pierwszym wpisie po bezczynności
+    if (__atomic_load_n(&sleeping, __ATOMIC_SEQ_CST) && __atomic_exchange_n(&sleeping, 0, __ATOMIC_SEQ_CST)) {
+        futex_wake(&sleeping);
+    }
+}
+
+static const char *level_name(int level) {
+    switch (level) {
+    case LOG_LEVEL_DEBUG: return "DEBUG";
+    case LOG_LEVEL_INFO: return "INFO";
+    case LOG_LEVEL_WARN: return "UWAGA";
+    default: return "BŁĄD";
+    }
+}
+
+// "HH:MM:SS.mmm POZIOM: " (czas lokalny; localtime_r tylko przy zmianie sekundy)
+static size_t format_prefix(char *out, uint64_t ns, int level) {
+    static time_t lastSec = (time_t)-1;
+    static char stamp[16];
+    time_t sec = (time_t)(ns / 1000000000ull);
+    if (sec != lastSec) {
+        struct tm tm;
+        localtime_r(&sec, &tm);
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm);
+        lastSec = sec;
+    }
+    return (size_t)sprintf(out, "%s.%03u %s: ", stamp, (unsigned)(ns / 1000000ull % 1000), level_name(level));
+}
+
+// Dopisuje tekst formatu [from, to), zamieniając "%%" na '%'
+static size_t append_literal(char *out, size_t cap, const char *from, const char *to) {
+    size_t n = 0;
+    while (from < to && n < cap) {
+        out[n++] = *from;
+        from += (from[0] == '%' && from + 1 < to && from[1] == '%') ? 2 : 1;
+    }
+    return n;
+}
+
+// Formatuje wpis jako jedną linię (z '\n'). 'cap' >= LOG_LINE_MAX.
+static size_t format_record(const LogRecord *rec, char *out, size_t cap) {
+    size_t n = format_prefix(out, rec->ns, rec->level);
+    cap -= 1;   // miejsce na '\n'
+    const char *p = rec->fmt, *spec, *mod;
+    char conv, len;
+    int arg = 0;
+    size_t text = 0;
+    while ((spec = next_spec(p, &mod, &conv, &len)) != NULL && n < cap) {
+        n += append_literal(out + n, cap - n, p, spec);
+        p = mod + (len == 'H' || len == 'L' ? 2 : len ? 1 : 0) + 1;
+
+        // Ta sama specyfikacja, ale z typem, w jakim argument leży w rekordzie
+        char sf[40];
+        size_t flags = (size_t)(mod - spec);
+        if (flags > sizeof(sf) - 4) flags = 1;
+        memcpy(sf, spec, flags);
+        int w = 0;
+        if (conv == 's') {
+            const char *s = text < rec->textLen ? rec->text + text : "";
+            text += strlen(s) + 1;
+            memcpy(sf + flags, "s", 2);
+            w = snprintf(out + n, cap - n, sf, s);
+        } else if (arg >= rec->argCount) {
+            w = snprintf(out + n, cap - n, "?");
+        } else if (is_float_conv(conv)) {
+            double d;
+            memcpy(&d, &rec->args[arg++], sizeof(d));
+            sf[flags] = conv;
+            sf[flags + 1] = '\0';
+            w = snprintf(out + n, cap - n, sf, d);
+        } else if (conv == 'p' || conv == 'c') {
+            sf[flags] = conv;
+            sf[flags + 1] = '\0';
+            if (conv == 'p') w = snprintf(out + n, cap - n, sf, (void *)(uintptr_t)rec->args[arg++]);
+            else w = snprintf(out + n, cap - n, sf, (int)rec->args[arg++]);
+        } else {
+            char c = (conv == 'd' || conv == 'i' || conv == 'u' || conv == 'x' || conv == 'X' || conv == 'o') ? conv : 'd';
+            memcpy(sf + flags, "ll", 2);
+            sf[flags + 2] = c;
+            sf[flags + 3] = '\0';
+            if (c == 'd' || c == 'i') w = snprintf(out + n, cap - n, sf, (long long)rec->args[arg++]);
+            else w = snprintf(out + n, cap - n, sf, (unsigned long long)rec->args[arg++]);
+        }
+        if (w > 0) n += (size_t)w < cap - n ? (size_t)w : cap - n - 1;
+    }
+    if (n < cap) n += append_literal(out + n, cap - n, p, p + strlen(p));
+    if (n == 0 || out[n - 1] != '\n') out[n++] = '\n';
+    return n;
+}
+
+static void flush_out(const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t w = write(STDERR_FILENO, buf, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        buf += w;
+        len -= (size_t)w;
+    }
+    __atomic_add_fetch(&counters.writes, 1, __ATOMIC_RELAXED);
+}
+
+// Jedna paczka: wszystko, co było w pierścieniach na jej początku, scalone po czasie.
+// Zwraca liczbę wypisanych wpisów.
+static size_t drain(char *out) {
+    size_t len = 0, done = 0;
+    LogRing *head = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    for (LogRing *r = head; r; r = r->next) {
+        r->limit = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        uint64_t dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        if (dropped != r->reported) {
+            if (LOG_OUT_SIZE - len < LOG_LINE_MAX) {
+                flush_out(out, len);
+                len = 0;
+            }
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            len += format_prefix(out + len, (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec, LOG_LEVEL_WARN);
+            len += (size_t)sprintf(out + len, "Dziennik nie nadąża - pominięto %llu wpisów\n",
+                                   (unsigned long long)(dropped - r->reported));
+            __atomic_add_fetch(&counters.dropped, dropped - r->reported, __ATOMIC_RELAXED);
+            r->reported = dropped;
+        }
+    }
+    for (;;) {
+        LogRing *next = NULL;
+        for (LogRing *r = head; r; r = r->next) {
+            if (r->head == r->limit) continue;
+            if (!next || r->records[r->head & (LOG_RING_RECORDS - 1)].ns <
+                             next->records[next->head & (LOG_RING_RECORDS - 1)].ns) {
+                next = r;
+            }
+        }
+        if (!next) break;
+        if (LOG_OUT_SIZE - len < LOG_LINE_MAX) {
+            flush_out(out, len);
+            len = 0;
+        }
+        len += format_record(&next->records[next->head & (LOG_RING_RECORDS - 1)], out + len, LOG_LINE_MAX);
+        // Miejsce wraca do producenta dopiero po odczytaniu rekordu
+        __atomic_store_n(&next->head, next->head + 1, __ATOMIC_RELEASE);
+        done++;
+    }
+    if (len > 0) flush_out(out, len);
+    __atomic_add_fetch(&counters.written, done, __ATOMIC_RELAXED);
+    return done;
+}
+
+// Czy w którymś pierścieniu są wpisy
+static int rings_pending() {
+    for (LogRing *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        if (__atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) != r->head) return 1;
+    }
+    return 0;
+}
+
+// Paczka co LOG_FLUSH_MS, dopóki przychodzą wpisy; bez wpisów wątek śpi na futeksie, aż obudzi go
+// pierwszy nowy wpis (bezczynny serwer nie budzi się wcale)
+static void *logger_loop(void *arg) {
+    char *out = (char *)arg;
+    struct timespec pause = {0, LOG_FLUSH_MS * 1000000L};
+    for (;;) {
+        int stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+        size_t done = drain(out);
+        if (stop) break;
+        if (done == 0) {
+            __atomic_store_n(&sleeping, 1, __ATOMIC_SEQ_CST);
+            if (!rings_pending() && !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+                syscall(SYS_futex, &sleeping, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+            }
+            __atomic_store_n(&sleeping, 0, __ATOMIC_SEQ_CST);
+        }
+        // Zbieramy paczkę
+        nanosleep(&pause, NULL);
+    }
+    return out;
+}
+
+int logger_start() {
+    if (running) return 0;
+    char *out = (char *)malloc(LOG_OUT_SIZE);
+    if (!out) {
+        fprintf(stderr, "Błąd alokacji pamięci dla dziennika.\n");
+        return -1;
+    }
+    stopping = 0;
+    if (pthread_create(&loggerThread, NULL, logger_loop, out) != 0) {
+        perror("pthread_create");
+        free(out);
+        return -1;
+    }
+    __atomic_store_n(&running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void logger_stop() {
+    if (!running) return;
+    __atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&stopping, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&sleeping, 0, __ATOMIC_SEQ_CST);
+    futex_wake(&sleeping);
+    void *out = NULL;
+    pthread_join(loggerThread, &out);
+    free(out);
+    // Pierścienie zostają: wątki trzymają do nich wskaźniki, a ponowny logger_start() ich używa
+}
+
+void logger_counters(LoggerCounters *out) {
+    out->written = __atomic_load_n(&counters.written, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&counters.dropped, __ATOMIC_RELAXED);
+    out->writes = __atomic_load_n(&counters.writes, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,58 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+
+// Dziennik zdarzeń serwera bez blokowania pętli zdarzeń. Wywołanie LOG_*() niczego nie formatuje
+// ani nie zapisuje: przechodzi po formacie (jak printf), kopiuje argumenty do rekordu stałego
+// rozmiaru i wkłada go do pierścienia swojego wątku (jeden producent, jeden konsument, bez blokad).
+// Wątek dziennika co LOG_FLUSH_MS zbiera rekordy ze wszystkich pierścieni w kolejności czasu,
+// formatuje je i wypisuje na stderr jednym write() na paczkę; bez wpisów śpi na futeksie, a budzi
+// go dopiero pierwszy wpis po bezczynności. Gdy pierścień jest pełny, rekord
+// przepada - liczy go quiz_log_dropped_total, a wątek dziennika wypisuje, ile pominięto.
+//
+// Poziomy poniżej LOG_MIN_LEVEL (opcja CMake) nie trafiają nawet do programu.
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RECORD_SIZE 256         // rekord: nagłówek, argumenty liczbowe i napisy
+#define LOG_MAX_ARGS 6              // argumentów liczbowych (%d, %zu, %f, ...) w jednym wpisie
+#define LOG_RING_RECORDS 4096       // rekordów w pierścieniu wątku (potęga dwójki)
+#define LOG_FLUSH_MS 10
+
+// Format jak w printf (bez '\n' na końcu - dopisuje go dziennik). Obsługiwane konwersje:
+// d i u x X o c s p f e g (z modyfikatorami hh h l ll z j t); bez '*' w szerokości i precyzji.
+// Napisy są kopiowane (razem do ok. 180 bajtów na wpis, dłuższe ucinane), format musi być stałą.
+#define LOG_AT(level, ...) \
+    do { \
+        if ((level) >= LOG_MIN_LEVEL) logger_write((level), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// Uruchamia wątek dziennika. Zwraca 0 albo -1. Bez uruchomionego wątku wpisy są pomijane (np. w benchmarkach).
+int logger_start();
+// Wypisuje zaległe wpisy i zatrzymuje wątek
+void logger_stop();
+
+// Wkłada wpis do pierścienia bieżącego wątku (pierwszy wpis wątku tworzy jego pierścień)
+void logger_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// Liczniki: wpisy wypisane, pominięte przy pełnym pierścieniu, wywołania write()
+typedef struct LoggerCounters {
+    uint64_t written;
+    uint64_t dropped;
+    uint64_t writes;
+} LoggerCounters;
+void logger_counters(LoggerCounters *out);
+
+#endif
@@ -0,0 +1,117 @@
+#include "metrics.h"
+
+#include <string.h>
+
+#include "timer_wheel.h"
+
+static Metrics unusedMetrics;
+__thread Metrics *t_metrics = &unusedMetrics;
+
+void hist_record_since(Histogram *h, uint64_t start_ns) {
+    uint64_t now = monotonic_real_ns();
+    hist_record(h, now > start_ns ? now - start_ns : 0);
+}
+
+static uint64_t load(const uint64_t *v) {
+    return __atomic_load_n(v, __ATOMIC_RELAXED);
+}
+
+static void hist_merge(Histogram *dst, const Histogram *src) {
+    for (int i = 0; i < HIST_BUCKETS; i++) dst->counts[i] += load(&src->counts[i]);
+    dst->sum += load(&src->sum);
+    dst->total += load(&src->total);
+}
+
+void metrics_merge(Metrics *dst, const Metrics *src) {
+    dst->accepted += load(&src->accepted);
+    dst->closed += load(&src->closed);
+    dst->rejected += load(&src->rejected);
+    dst->joinQueued += load(&src->joinQueued);
+    dst->answers += load(&src->answers);
+    dst->rounds += load(&src->rounds);
+    dst->bytesSent += load(&src->bytesSent);
+    dst->writeCalls += load(&src->writeCalls);
+    dst->shortWrites += load(&src->shortWrites);
+    dst->spectatorSkips += load(&src->spectatorSkips);
+    dst->sessionsParked += load(&src->sessionsParked);
+    dst->sessionsResumed += load(&src->sessionsResumed);
+    dst->sessionsExpired += load(&src->sessionsExpired);
+    dst->logDropped += load(&src->logDropped);
+    hist_merge(&dst->roundEnd, &src->roundEnd);
+    hist_merge(&dst->ranking, &src->ranking);
+    hist_merge(&dst->answer, &src->answer);
+    hist_merge(&dst->accept, &src->accept);
+    hist_merge(&dst->joinWait, &src->joinWait);
+    hist_merge(&dst->loopLag, &src->loopLag);
+}
+
+// Górna granica przedziału (ns)
+static uint64_t bucket_upper(int i) {
+    if (i < HIST_SUB) return (uint64_t)i;
+    int m = (i >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(i & (HIST_SUB - 1));
+    return ((HIST_SUB + sub + 1) << (m - HIST_SUB_BITS)) - 1;
+}
+
+static uint64_t hist_quantile(const Histogram *h, double q) {
+    if (h->total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)h->total);
+    if (rank >= h->total) rank = h->total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > rank) return bucket_upper(i);
+    }
+    return bucket_upper(HIST_BUCKETS - 1);
+}
+
+// Histogram jako "summary" Prometheusa: kwantyle, suma i liczba pomiarów (sekundy)
+static Frame *format_summary(Frame *f, const char *name, const char *help, const Histogram *h) {
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    f = frame_appendf(f, "# HELP %s %s\n# TYPE %s summary\n", name, help, name);
+    for (size_t i = 0; f && i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        f = frame_appendf(f, "%s{quantile=\"%g\"} %.9f\n", name, quantiles[i], hist_quantile(h, quantiles[i]) / 1e9);
+    }
+    if (f) f = frame_appendf(f, "%s_sum %.9f\n%s_count %llu\n", name, h->sum / 1e9, name, (unsigned long long)h->total);
+    return f;
+}
+
+static Frame *format_value(Frame *f, const char *name, const char *type, const char *help, long long value) {
+    return frame_appendf(f, "# HELP %s %s\n# TYPE %s %s\n%s %lld\n", name, help, name, type, name, value);
+}
+
+Frame *metrics_format(Frame *f, const Metrics *m, int threads) {
+    f = format_value(f, "quiz_worker_threads", "gauge", "Reactor threads.", threads);
+    if (f) f = format_value(f, "quiz_connections_accepted_total", "counter", "Accepted player connections.",
+                            (long long)m->accepted);
+    if (f) f = format_value(f, "quiz_connections_open", "gauge", "Open player connections.",
+                            (long long)(m->accepted - m->closed));
+    if (f) f = format_value(f, "quiz_connections_rejected_total", "counter",
+                            "Connections turned away with a retry hint (join queue full).", (long long)m->rejected);
+    if (f) f = format_value(f, "quiz_join_queue_length", "gauge", "Accepted connections waiting for the greeting.",
+                            (long long)(m->joinQueued - m->joinWait.total));
+    if (f) f = format_value(f, "quiz_answers_total", "counter", "Answers received from players.", (long long)m->answers);
+    if (f) f = format_value(f, "quiz_rounds_total", "counter", "Finished rounds.", (long long)m->rounds);
+    if (f) f = format_value(f, "quiz_bytes_sent_total", "counter", "Bytes written to player sockets.",
+                            (long long)m->bytesSent);
+    if (f) f = format_value(f, "quiz_writev_calls_total", "counter", "writev() calls (sendmsg submissions with io_uring).", (long long)m->writeCalls);
+    if (f) f = format_value(f, "quiz_short_writes_total", "counter", "writev() calls that left data for EPOLLOUT.",
+                            (long long)m->shortWrites);
+    if (f) f = format_value(f, "quiz_spectator_skipped_total", "counter",
+                            "Queued messages skipped for spectators that fell behind.", (long long)m->spectatorSkips);
+    if (f) f = format_value(f, "quiz_sessions_parked_total", "counter",
+                            "Dropped player connections kept for resume.", (long long)m->sessionsParked);
+    if (f) f = format_value(f, "quiz_sessions_resumed_total", "counter", "Sessions resumed with RESUME=<token>.",
+                            (long long)m->sessionsResumed);
+    if (f) f = format_value(f, "quiz_sessions_expired_total", "counter", "Sessions that outlived RESUME_GRACE.",
+                            (long long)m->sessionsExpired);
+    if (f) f = format_value(f, "quiz_log_dropped_total", "counter", "Log records dropped because the log ring was full.",
+                            (long long)m->logDropped);
+    if (f) f = format_summary(f, "quiz_round_end_seconds", "Time spent in end_round().", &m->roundEnd);
+    if (f) f = format_summary(f, "quiz_ranking_send_seconds", "Formatting and queueing the round ranking.", &m->ranking);
+    if (f) f = format_summary(f, "quiz_answer_seconds", "Handling of a single answer.", &m->answer);
+    if (f) f = format_summary(f, "quiz_accept_seconds", "Accepting a connection.", &m->accept);
+    if (f) f = format_summary(f, "quiz_join_wait_seconds", "Time in the join queue before the greeting.", &m->joinWait);
+    if (f) f = format_summary(f, "quiz_event_loop_lag_seconds", "Delay of room timers past their deadline.", &m->loopLag);
+    return f;
+}
@@ -0,0 +1,77 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+#include "frame.h"
+
+// Metryki wątku reaktora: liczniki i histogramy opóźnień w stylu HDR.
+// Każdy wątek pisze tylko do własnej struktury (bez blokad i instrukcji atomowych typu read-modify-write),
+// a wątek serwujący /metrics sumuje struktury wszystkich wątków przy odczycie.
+
+// Histogram: przedziały logarytmiczne (potęgi dwójki) dzielone na HIST_SUB równych części,
+// czyli błąd względny najwyżej 1/HIST_SUB. Wartości w nanosekundach.
+#define HIST_SUB_BITS 3
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS  ((64 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+typedef struct Histogram {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t sum;               // suma wartości (ns)
+    uint64_t total;             // liczba pomiarów
+} Histogram;
+
+typedef struct Metrics {
+    uint64_t accepted;          // przyjęte połączenia graczy
+    uint64_t closed;            // zamknięte połączenia (otwarte = accepted - closed, sumowane po wątkach)
+    uint64_t rejected;          // połączenia odrzucone przy pełnej kolejce przyjęć (albo braku deskryptorów)
+    uint64_t joinQueued;        // połączenia, które czekały w kolejce przyjęć (czekające = joinQueued - joinWait.total)
+    uint64_t answers;           // odpowiedzi graczy
+    uint64_t rounds;            // zakończone rundy
+    uint64_t bytesSent;
+    uint64_t writeCalls;        // wywołania writev()
+    uint64_t shortWrites;       // writev() nie przyjął wszystkiego (reszta czeka na EPOLLOUT)
+    uint64_t spectatorSkips;    // wiadomości pominięte w kolejkach widzów, którzy nie nadążają
+    uint64_t sessionsParked;    // zerwane połączenia zalogowanych graczy czekające na RESUME=
+    uint64_t sessionsResumed;
+    uint64_t sessionsExpired;
+    uint64_t logDropped;        // wpisy dziennika pominięte przy pełnym pierścieniu (logger.h)
+
+    Histogram roundEnd;         // end_round(): punkty, ranking, start kolejnej rundy
+    Histogram ranking;          // formatowanie i rozesłanie rankingu
+    Histogram answer;           // obsługa jednej odpowiedzi
+    Histogram accept;           // przyjęcie połączenia
+    Histogram joinWait;         // czekanie w kolejce przyjęć (od accept() do powitania)
+    Histogram loopLag;          // opóźnienie zegarów pokoi względem terminu (opóźnienie pętli zdarzeń)
+} Metrics;
+
+// Metryki bieżącego wątku. Poza wątkami reaktora (benchmarki, narzędzia) wskazują na strukturę zastępczą.
+extern __thread Metrics *t_metrics;
+
+// Zapis tylko przez wątek-właściciela; odczyt z innego wątku widzi całe 64-bitowe wartości
+static inline void metric_add(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static inline int hist_bucket(uint64_t v) {
+    if (v < HIST_SUB) return (int)v;
+    int m = 63 - __builtin_clzll(v);
+    return ((m - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + (int)((v >> (m - HIST_SUB_BITS)) & (HIST_SUB - 1));
+}
+
+static inline void hist_record(Histogram *h, uint64_t ns) {
+    metric_add(&h->counts[hist_bucket(ns)], 1);
+    metric_add(&h->sum, ns);
+    metric_add(&h->total, 1);
+}
+
+// Pomiar od 'start_ns' (monotonic_real_ns()) do teraz
+void hist_record_since(Histogram *h, uint64_t start_ns);
+
+// Dodaje do 'dst' metryki jednego wątku (odczyt z innego wątku)
+void metrics_merge(Metrics *dst, const Metrics *src);
+
+// Dopisuje metryki w formacie tekstowym Prometheusa. Przy braku pamięci zwraca NULL (ramka zwolniona).
+Frame *metrics_format(Frame *f, const Metrics *m, int threads);
+
+#endif
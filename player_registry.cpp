@@ -0,0 +1,192 @@
+#include "player_registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "answer_index.h"
+#include "connection.h"
+
+static uint32_t fd_hash(int fd) {
+    return (uint32_t)fd * 2654435761u;
+}
+
+static uint32_t name_hash(const char *name) {
+    return answer_hash(name, strlen(name));
+}
+
+// Wstawia parę (hash, pozycja); miejsce jest zawsze, bo tablica ma co najmniej 2x więcej slotów niż graczy
+static void st_insert(SlotTable *t, uint32_t hash, int slot) {
+    uint32_t mask = t->capacity - 1;
+    uint32_t pos = hash & mask;
+    while (t->slots[pos]) pos = (pos + 1) & mask;
+    t->hashes[pos] = hash;
+    t->slots[pos] = (uint32_t)slot + 1;
+}
+
+// Pozycja w tablicy, pod którą zapisano daną pozycję gracza
+static uint32_t st_locate(const SlotTable *t, uint32_t hash, int slot) {
+    uint32_t mask = t->capacity - 1;
+    uint32_t pos = hash & mask;
+    while (t->slots[pos] != (uint32_t)slot + 1) pos = (pos + 1) & mask;
+    return pos;
+}
+
+// Usuwa wpis i przesuwa wstecz kolejne wpisy z tego samego ciągu (bez znaczników "usunięty")
+static void st_erase(SlotTable *t, uint32_t hash, int slot) {
+    uint32_t mask = t->capacity - 1;
+    uint32_t hole = st_locate(t, hash, slot);
+    uint32_t pos = hole;
+    while (1) {
+        pos = (pos + 1) & mask;
+        if (!t->slots[pos]) break;
+        uint32_t home = t->hashes[pos] & mask;
+        // Wpis może zająć dziurę, jeśli jego miejsce docelowe nie leży między dziurą a nim
+        int between = (hole <= pos) ? (home > hole && home <= pos) : (home > hole || home <= pos);
+        if (!between) {
+            t->hashes[hole] = t->hashes[pos];
+            t->slots[hole] = t->slots[pos];
+            hole = pos;
+        }
+    }
+    t->slots[hole] = 0;
+}
+
+static void st_move(SlotTable *t, uint32_t hash, int from, int to) {
+    t->slots[st_locate(t, hash, from)] = (uint32_t)to + 1;
+}
+
+static void st_free(SlotTable *t) {
+    free(t->hashes);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
+
+static int st_alloc(SlotTable *t, uint32_t capacity) {
+    t->hashes = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+    t->slots = (uint32_t *)calloc(capacity, sizeof(uint32_t));
+    if (!t->hashes || !t->slots) {
+        st_free(t);
+        return -1;
+    }
+    t->capacity = capacity;
+    return 0;
+}
+
+// Powiększa tablicę graczy i odbudowuje oba indeksy
+static int grow(PlayerRegistry *reg) {
+    int newCap = reg->cap ? reg->cap * 2 : 8;
+
+    // Najpierw nowe indeksy: przy braku pamięci rejestr zostaje nietknięty
+    // (stare rekordy, stara pojemność i pasujące do niej indeksy)
+    SlotTable byFd, byName;
+    memset(&byFd, 0, sizeof(byFd));
+    memset(&byName, 0, sizeof(byName));
+    if (st_alloc(&byFd, (uint32_t)newCap * 2) != 0 || st_alloc(&byName, (uint32_t)newCap * 2) != 0) {
+        st_free(&byFd);
+        return -1;
+    }
+    Player *tmp = (Player *)realloc(reg->items, sizeof(Player) * newCap);
+    if (!tmp) {
+        st_free(&byFd);
+        st_free(&byName);
+        return -1;
+    }
+    reg->items = tmp;
+    reg->cap = newCap;
+    st_free(&reg->byFd);
+    st_free(&reg->byName);
+    reg->byFd = byFd;
+    reg->byName = byName;
+
+    for (int i = 0; i < reg->count; i++) {
+        Player *p = &reg->items[i];
+        // realloc mógł przenieść rekordy
+        if (p->conn) p->conn->player = p;
+        st_insert(&reg->byFd, fd_hash(p->fd), i);
+        if (p->name) st_insert(&reg->byName, name_hash(p->name), i);
+    }
+    return 0;
+}
+
+Player *registry_add(PlayerRegistry *reg, Connection *conn) {
+    if (reg->count == reg->cap && grow(reg) != 0) return NULL;
+
+    int slot = reg->count++;
+    Player *p = &reg->items[slot];
+    memset(p, 0, sizeof(*p));
+    p->fd = conn->fd;
+    p->conn = conn;
+    p->answerId = -1;
+    p->answerTime = -1.0;
+    st_insert(&reg->byFd, fd_hash(p->fd), slot);
+    conn->player = p;
+    return p;
+}
+
+Player *registry_find(const PlayerRegistry *reg, int fd) {
+    if (reg->count == 0) return NULL;
+    uint32_t mask = reg->byFd.capacity - 1;
+    uint32_t hash = fd_hash(fd);
+    for (uint32_t pos = hash & mask; reg->byFd.slots[pos]; pos = (pos + 1) & mask) {
+        Player *p = &reg->items[reg->byFd.slots[pos] - 1];
+        if (reg->byFd.hashes[pos] == hash && p->fd == fd) return p;
+    }
+    return NULL;
+}
+
+int registry_remove(PlayerRegistry *reg, int fd) {
+    Player *p = registry_find(reg, fd);
+    if (!p) return -1;
+    int slot = (int)(p - reg->items);
+
+    st_erase(&reg->byFd, fd_hash(p->fd), slot);
+    if (p->name) {
+        st_erase(&reg->byName, name_hash(p->name), slot);
+        free(p->name);
+    }
+
+    // Ostatni gracz zajmuje zwolnione miejsce, tablica zostaje ciągła
+    int last = --reg->count;
+    if (slot != last) {
+        Player *moved = &reg->items[last];
+        st_move(&reg->byFd, fd_hash(moved->fd), last, slot);
+        if (moved->name) st_move(&reg->byName, name_hash(moved->name), last, slot);
+        *p = *moved;
+        if (p->conn) p->conn->player = p;
+    }
+    return 0;
+}
+
+int registry_name_taken(const PlayerRegistry *reg, const char *name) {
+    if (reg->count == 0) return 0;
+    uint32_t mask = reg->byName.capacity - 1;
+    uint32_t hash = name_hash(name);
+    for (uint32_t pos = hash & mask; reg->byName.slots[pos]; pos = (pos + 1) & mask) {
+        const Player *p = &reg->items[reg->byName.slots[pos] - 1];
+        if (reg->byName.hashes[pos] == hash && strcmp(p->name, name) == 0) return 1;
+    }
+    return 0;
+}
+
+int registry_set_name(PlayerRegistry *reg, Player *p, const char *name) {
+    char *copy = strdup(name);
+    if (!copy) return -1;
+    int slot = (int)(p - reg->items);
+    if (p->name) {
+        st_erase(&reg->byName, name_hash(p->name), slot);
+        free(p->name);
+    }
+    p->name = copy;
+    st_insert(&reg->byName, name_hash(copy), slot);
+    return 0;
+}
+
+void registry_free(PlayerRegistry *reg) {
+    for (int i = 0; i < reg->count; i++) {
+        if (reg->items[i].name) free(reg->items[i].name);
+    }
+    free(reg->items);
+    st_free(&reg->byFd);
+    st_free(&reg->byName);
+    memset(reg, 0, sizeof(*reg));
+}
@@ -0,0 +1,59 @@
+#ifndef PLAYER_REGISTRY_H
+#define PLAYER_REGISTRY_H
+
+#include <stdint.h>
+
+struct GameRoom;
+struct Connection;
+
+// Struktura gracza
+typedef struct Player {
+    int fd;             // deskryptor gniazda
+    struct Connection *conn; // połączenie (kolejka wyjściowa)
+    char *name;         // pseudonim
+    char *response;     // odpowiedź (w arenie rundy pokoju, nie zwalniamy osobno)
+    int score;          // suma punktów
+    int answered;       // czy odpowiedział w tej rundzie (flaga)
+    int in_game;        // czy jest w grze w tej rundzie
+    int got_name;       // czy w ogóle ma pseudonim
+    int lastPoints;     // punkty uzyskane w ostatniej rundzie
+    int answerId;       // id poprawnej odpowiedzi w bazie (-1 = brak), ustalane na koniec rundy
+    double answerTime;  // czas odpowiedzi (sekundy od startu rundy, zegar monotoniczny)
+    int played;         // rundy bieżącej gry, w których grał (do profilu)
+    int correct;        // ... i te z poprawną odpowiedzią
+    uint64_t token[2];  // token wznowienia sesji (session.h); zera = brak
+    struct GameRoom *room; // pokój, w którym gra
+} Player;
+
+// Indeks haszujący klucz -> pozycja gracza w tablicy (adresowanie otwarte, sondowanie liniowe)
+typedef struct SlotTable {
+    uint32_t capacity;  // potęga dwójki, co najmniej 2x pojemność tablicy graczy
+    uint32_t *hashes;
+    uint32_t *slots;    // pozycja + 1 (0 = pusty slot)
+} SlotTable;
+
+// Gracze pokoju w jednej ciągłej tablicy (usuwanie przez przeniesienie ostatniego na zwolnione miejsce)
+// oraz dwa indeksy: deskryptor -> gracz i pseudonim -> gracz.
+// Przeniesienie rekordu (usuwanie, powiększenie tablicy) aktualizuje conn->player,
+// więc wskaźnik Player* jest ważny tylko do następnego dodania/usunięcia gracza.
+typedef struct PlayerRegistry {
+    Player *items;
+    int count;
+    int cap;
+    SlotTable byFd;
+    SlotTable byName;
+} PlayerRegistry;
+
+// Dodaje gracza dla połączenia; NULL przy błędzie alokacji
+Player *registry_add(PlayerRegistry *reg, struct Connection *conn);
+// Usuwa gracza (zwalnia pseudonim i odpowiedź). Zwraca 0 albo -1, gdy nie ma takiego gracza.
+int registry_remove(PlayerRegistry *reg, int fd);
+Player *registry_find(const PlayerRegistry *reg, int fd);
+
+int registry_name_taken(const PlayerRegistry *reg, const char *name);
+// Nadaje graczowi pseudonim i dodaje go do indeksu nazw. 0 albo -1 przy błędzie alokacji.
+int registry_set_name(PlayerRegistry *reg, Player *p, const char *name);
+
+void registry_free(PlayerRegistry *reg);
+
+#endif
@@ -0,0 +1,460 @@
+#include "profile_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+#include "answer_index.h"
+
+// Nagłówek rekordu na dysku; za nim nazwa (nameLen bajtów, bez '\0')
+typedef struct ProfileRecord {
+    uint32_t check;             // FNV-1a pozostałych pól nagłówka i nazwy
+    uint16_t nameLen;
+    uint16_t reserved;
+    uint32_t games;
+    uint32_t correct;
+    uint32_t bestScore;
+    uint32_t reserved2;
+    uint64_t points;
+} ProfileRecord;
+
+// Profil w pamięci (tablica z adresowaniem otwartym po hashu nazwy)
+typedef struct ProfileEntry {
+    uint32_t hash;
+    uint32_t nameLen;
+    char *name;                 // NULL = pusty slot
+    ProfileStats stats;
+} ProfileEntry;
+
+static int logFd = -1;
+static int logOpen = 0;
+static char logPath[256];
+static uint64_t logSize = 0;    // bajty zapisane w dzienniku (także nagłówek)
+
+// Bufor rekordów czekających na zapis; pętle zdarzeń dopisują, wątek zapisu zabiera całość naraz
+static pthread_t writerThread;
+static pthread_mutex_t pendingLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pendingCond = PTHREAD_COND_INITIALIZER;
+static char *pending = NULL;
+static size_t pendingLen = 0, pendingCap = 0;
+static int stopping = 0;
+
+// Profile: zmienia je tylko wątek zapisu (i odtwarzanie przy starcie), blokada chroni odczyt z pętli zdarzeń
+static pthread_mutex_t mapLock = PTHREAD_MUTEX_INITIALIZER;
+static ProfileEntry *entries = NULL;
+static uint32_t entriesCap = 0;
+static uint32_t entriesCount = 0;
+static uint64_t liveBytes = 0;  // rozmiar dziennika po kompakcji
+
+static ProfileLogCounters counters;
+
+static uint32_t fnv_continue(uint32_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t record_check(const ProfileRecord *r, const char *name) {
+    uint32_t h = fnv_continue(2166136261u, (const char *)r + sizeof(r->check), sizeof(*r) - sizeof(r->check));
+    return fnv_continue(h, name, r->nameLen);
+}
+
+// Zapisuje rekord do 'out' (sizeof(ProfileRecord) + nameLen bajtów)
+static void encode_record(char *out, const char *name, size_t nameLen, const ProfileStats *s) {
+    ProfileRecord r;
+    memset(&r, 0, sizeof(r));
+    r.nameLen = (uint16_t)nameLen;
+    r.games = s->games;
+    r.correct = s->correct;
+    r.bestScore = s->bestScore;
+    r.points = s->points;
+    r.check = record_check(&r, name);
+    memcpy(out, &r, sizeof(r));
+    memcpy(out + sizeof(r), name, nameLen);
+}
+
+// Rozmiar poprawnego rekordu pod 'p' albo 0 (urwany lub uszkodzony)
+static size_t decode_record(const char *p, size_t avail, ProfileRecord *r) {
+    if (avail < sizeof(*r)) return 0;
+    memcpy(r, p, sizeof(*r));
+    size_t size = sizeof(*r) + r->nameLen;
+    if (r->nameLen == 0 || avail < size) return 0;
+    if (record_check(r, p + sizeof(*r)) != r->check) return 0;
+    return size;
+}
+
+static int map_grow() {
+    uint32_t newCap = entriesCap ? entriesCap * 2 : 256;
+    ProfileEntry *tmp = (ProfileEntry *)calloc(newCap, sizeof(ProfileEntry));
+    if (!tmp) return -1;
+    for (uint32_t i = 0; i < entriesCap; i++) {
+        if (!entries[i].name) continue;
+        uint32_t pos = entries[i].hash & (newCap - 1);
+        while (tmp[pos].name) pos = (pos + 1) & (newCap - 1);
+        tmp[pos] = entries[i];
+    }
+    free(entries);
+    entries = tmp;
+    entriesCap = newCap;
+    return 0;
+}
+
+static ProfileEntry *map_find(const char *name, size_t len, uint32_t hash) {
+    if (entriesCount == 0) return NULL;
+    for (uint32_t pos = hash & (entriesCap - 1); entries[pos].name; pos = (pos + 1) & (entriesCap - 1)) {
+        ProfileEntry *e = &entries[pos];
+        if (e->hash == hash && e->nameLen == len && memcmp(e->name, name, len) == 0) return e;
+    }
+    return NULL;
+}
+
+// Dokłada rekord do profilu (wywołuje tylko wątek zapisu albo odtwarzanie przed jego startem)
+static void apply_record(const ProfileRecord *r, const char *name) {
+    uint32_t hash = answer_hash(name, r->nameLen);
+    pthread_mutex_lock(&mapLock);
+    ProfileEntry *e = map_find(name, r->nameLen, hash);
+    if (!e) {
+        char *copy = (char *)malloc(r->nameLen + 1u);
+        if (!copy || ((entriesCount + 1) * 2 > entriesCap && map_grow() != 0)) {
+            pthread_mutex_unlock(&mapLock);
+            free(copy);
+            fprintf(stderr, "Błąd alokacji pamięci dla profili graczy.\n");
+            return;
+        }
+        memcpy(copy, name, r->nameLen);
+        copy[r->nameLen] = '\0';
+        uint32_t pos = hash & (entriesCap - 1);
+        while (entries[pos].name) pos = (pos + 1) & (entriesCap - 1);
+        e = &entries[pos];
+        e->hash = hash;
+        e->nameLen = r->nameLen;
+        e->name = copy;
+        entriesCount++;
+        liveBytes += sizeof(ProfileRecord) + r->nameLen;
+    }
+    e->stats.games += r->games;
+    e->stats.correct += r->correct;
+    if (r->bestScore > e->stats.bestScore) e->stats.bestScore = r->bestScore;
+    e->stats.points += r->points;
+    pthread_mutex_unlock(&mapLock);
+}
+
+// Dokłada wszystkie rekordy bufora; zwraca liczbę bajtów poprawnych rekordów od początku
+static size_t apply_buffer(const char *buf, size_t len, uint64_t *records) {
+    size_t off = 0;
+    ProfileRecord r;
+    size_t n;
+    while ((n = decode_record(buf + off, len - off, &r)) != 0) {
+        apply_record(&r, buf + off + sizeof(r));
+        off += n;
+        if (records) (*records)++;
+    }
+    return off;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// fsync katalogu pliku, żeby utworzenie/rename przetrwało awarię
+static void sync_parent_dir(const char *path) {
+    char dir[sizeof(logPath)];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash == dir) slash[1] = '\0';
+    else if (slash) *slash = '\0';
+    else snprintf(dir, sizeof(dir), ".");
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return;
+    fsync(fd);
+    close(fd);
+}
+
+// Przepisuje dziennik: jeden rekord na gracza, w pliku tymczasowym podmienianym przez rename.
+// Nowy plik jest zablokowany (flock) jeszcze przed rename i jego deskryptor zostaje dziennikiem,
+// więc pod ścieżką dziennika nigdy nie ma pliku bez blokady.
+static void compact() {
+    char tmpPath[sizeof(logPath) + 8];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", logPath);
+    int fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        perror("Kompakcja profili");
+        return;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        perror("Kompakcja profili (flock)");
+        close(fd);
+        return;
+    }
+
+    // Profile zmienia tylko ten wątek, więc czytamy je bez blokady
+    // (bufor mieści każdy rekord: nazwa ma najwyżej 0xFFFF bajtów)
+    size_t cap = 1 << 17, len = 8;
+    char *buf = (char *)malloc(cap);
+    int ok = buf != NULL;
+    uint64_t written = 0;
+    if (ok) memcpy(buf, PROFILE_MAGIC, 8);
+    for (uint32_t i = 0; ok && i < entriesCap; i++) {
+        const ProfileEntry *e = &entries[i];
+        if (!e->name) continue;
+        size_t need = sizeof(ProfileRecord) + e->nameLen;
+        if (len + need > cap) {
+            ok = write_all(fd, buf, len) == 0;
+            written += len;
+            len = 0;
+        }
+        encode_record(buf + len, e->name, e->nameLen, &e->stats);
+        len += need;
+    }
+    if (ok) {
+        ok = write_all(fd, buf, len) == 0;
+        written += len;
+    }
+    free(buf);
+    if (ok && fsync(fd) != 0) ok = 0;
+    if (!ok) {
+        perror("Kompakcja profili");
+        close(fd);
+        unlink(tmpPath);
+        return;
+    }
+    if (rename(tmpPath, logPath) != 0) {
+        perror("Kompakcja profili (rename)");
+        close(fd);
+        unlink(tmpPath);
+        return;
+    }
+    sync_parent_dir(logPath);
+
+    close(logFd);
+    logFd = fd;
+    fprintf(stderr, "INFO: Kompakcja profili: %llu -> %llu bajtów\n",
+            (unsigned long long)logSize, (unsigned long long)written);
+    logSize = written;
+    __atomic_add_fetch(&counters.compactions, 1, __ATOMIC_RELAXED);
+}
+
+// Wątek zapisu: wszystko, co zebrało się w czasie poprzedniego fdatasync, idzie na dysk razem
+static void *writer_loop(void *arg) {
+    (void)arg;
+    char *batch = NULL;
+    size_t batchCap = 0;
+
+    pthread_mutex_lock(&pendingLock);
+    while (1) {
+        while (pendingLen == 0 && !stopping) pthread_cond_wait(&pendingCond, &pendingLock);
+        if (pendingLen == 0) break;
+
+        // Zamiana buforów - pętle zdarzeń dopisują dalej do pustego
+        char *tmp = batch;
+        size_t tmpCap = batchCap;
+        batch = pending;
+        batchCap = pendingCap;
+        size_t len = pendingLen;
+        pending = tmp;
+        pendingCap = tmpCap;
+        pendingLen = 0;
+        pthread_mutex_unlock(&pendingLock);
+
+        if (write_all(logFd, batch, len) != 0) {
+            perror("Zapis dziennika profili");
+            // Urwany rekord w środku dziennika zatrzymałby odtwarzanie - cofamy plik do ostatniego zatwierdzenia
+            if (ftruncate(logFd, (off_t)logSize) != 0) perror("ftruncate");
+        } else {
+            if (fdatasync(logFd) != 0) perror("fdatasync");
+            logSize += len;
+            __atomic_add_fetch(&counters.commits, 1, __ATOMIC_RELAXED);
+        }
+        // Profile w pamięci odzwierciedlają grę nawet wtedy, gdy zapis się nie powiódł
+        uint64_t records = 0;
+        apply_buffer(batch, len, &records);
+        __atomic_add_fetch(&counters.records, records, __ATOMIC_RELAXED);
+
+        if (logSize > PROFILE_COMPACT_MIN && logSize > PROFILE_COMPACT_RATIO * (liveBytes + 8)) compact();
+
+        pthread_mutex_lock(&pendingLock);
+    }
+    pthread_mutex_unlock(&pendingLock);
+    free(batch);
+    return NULL;
+}
+
+// Odtwarza istniejący dziennik (albo zakłada nowy) i obcina urwaną końcówkę
+static int replay(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror("fstat");
+        return -1;
+    }
+    if (st.st_size == 0) {
+        if (write_all(fd, PROFILE_MAGIC, 8) != 0 || fdatasync(fd) != 0) {
+            perror("Zapis dziennika profili");
+            return -1;
+        }
+        sync_parent_dir(logPath);
+        logSize = 8;
+        return 0;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *buf = (char *)malloc(size);
+    if (!buf) {
+        fprintf(stderr, "Błąd alokacji pamięci dla dziennika profili.\n");
+        return -1;
+    }
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = pread(fd, buf + got, size - got, (off_t)got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    if (got < 8 || memcmp(buf, PROFILE_MAGIC, 8) != 0) {
+        fprintf(stderr, "%s: to nie jest dziennik profili graczy.\n", logPath);
+        free(buf);
+        return -1;
+    }
+
+    uint64_t records = 0;
+    size_t end = 8 + apply_buffer(buf + 8, got - 8, &records);
+    free(buf);
+    if (end < size) {
+        fprintf(stderr, "UWAGA: %s: uszkodzony rekord na pozycji %zu - dziennik obcięty (%zu bajtów).\n",
+                logPath, end, size - end);
+        if (ftruncate(fd, (off_t)end) != 0 || fdatasync(fd) != 0) {
+            perror("ftruncate");
+            return -1;
+        }
+    }
+    logSize = end;
+    fprintf(stderr, "INFO: Profile graczy z %s: %u (rekordy: %llu)\n", logPath, entriesCount,
+            (unsigned long long)records);
+    return 0;
+}
+
+int profile_log_open(const char *path) {
+    if (logOpen) return 0;
+    snprintf(logPath, sizeof(logPath), "%s", path);
+    int fd = open(logPath, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        perror(logPath);
+        return -1;
+    }
+    // Dziennik ma jednego właściciela: dwa procesy dopisywałyby każdy ze swoim logSize,
+    // a kompakcja jednego podmieniłaby plik pod drugim (jego dalsze wpisy trafiłyby do usuniętego pliku)
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        if (errno == EWOULDBLOCK) {
+            fprintf(stderr, "Dziennik profili %s jest używany przez inny proces (czy działa już inna instancja serwera?)\n",
+                    logPath);
+        } else {
+            perror(logPath);
+        }
+        close(fd);
+        return -1;
+    }
+    if (replay(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    logFd = fd;
+    stopping = 0;
+    if (pthread_create(&writerThread, NULL, writer_loop, NULL) != 0) {
+        perror("pthread_create");
+        close(fd);
+        logFd = -1;
+        return -1;
+    }
+    __atomic_store_n(&logOpen, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void profile_log_close() {
+    if (!logOpen) return;
+    pthread_mutex_lock(&pendingLock);
+    stopping = 1;
+    __atomic_store_n(&logOpen, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&pendingCond);
+    pthread_mutex_unlock(&pendingLock);
+    pthread_join(writerThread, NULL);
+
+    close(logFd);
+    logFd = -1;
+    free(pending);
+    pending = NULL;
+    pendingLen = pendingCap = 0;
+    for (uint32_t i = 0; i < entriesCap; i++) free(entries[i].name);
+    free(entries);
+    entries = NULL;
+    entriesCap = entriesCount = 0;
+    liveBytes = 0;
+}
+
+void profile_record_game(const char *name, int correct, int score) {
+    if (!__atomic_load_n(&logOpen, __ATOMIC_ACQUIRE) || !name) return;
+    size_t nameLen = strlen(name);
+    if (nameLen == 0) return;
+    if (nameLen > 0xFFFF) nameLen = 0xFFFF;
+    ProfileStats s;
+    s.games = 1;
+    s.correct = correct > 0 ? (uint32_t)correct : 0;
+    s.bestScore = score > 0 ? (uint32_t)score : 0;
+    s.points = s.bestScore;
+
+    size_t need = sizeof(ProfileRecord) + nameLen;
+    pthread_mutex_lock(&pendingLock);
+    if (pendingLen + need > pendingCap) {
+        size_t newCap = pendingCap ? pendingCap : 4096;
+        while (newCap < pendingLen + need) newCap *= 2;
+        char *tmp = pendingLen + need <= PROFILE_PENDING_MAX ? (char *)realloc(pending, newCap) : NULL;
+        if (!tmp) {
+            pthread_mutex_unlock(&pendingLock);
+            // Komunikat tylko przy pierwszym odrzuconym rekordzie (dalej widać licznik)
+            if (__atomic_fetch_add(&counters.dropped, 1, __ATOMIC_RELAXED) == 0) {
+                fprintf(stderr, "UWAGA: Dziennik profili nie nadąża - wyniki gier są pomijane.\n");
+            }
+            return;
+        }
+        pending = tmp;
+        pendingCap = newCap;
+    }
+    encode_record(pending + pendingLen, name, nameLen, &s);
+    pendingLen += need;
+    pthread_cond_signal(&pendingCond);
+    pthread_mutex_unlock(&pendingLock);
+}
+
+int profile_lookup(const char *name, ProfileStats *out) {
+    if (!__atomic_load_n(&logOpen, __ATOMIC_ACQUIRE)) return -1;
+    size_t len = strlen(name);
+    uint32_t hash = answer_hash(name, len);
+    pthread_mutex_lock(&mapLock);
+    const ProfileEntry *e = map_find(name, len, hash);
+    if (e) *out = e->stats;
+    pthread_mutex_unlock(&mapLock);
+    return e ? 0 : -1;
+}
+
+void profile_log_counters(ProfileLogCounters *out) {
+    out->records = __atomic_load_n(&counters.records, __ATOMIC_RELAXED);
+    out->commits = __atomic_load_n(&counters.commits, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&counters.dropped, __ATOMIC_RELAXED);
+    out->compactions = __atomic_load_n(&counters.compactions, __ATOMIC_RELAXED);
+}
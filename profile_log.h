@@ -0,0 +1,50 @@
+#ifndef PROFILE_LOG_H
+#define PROFILE_LOG_H
+
+#include <stdint.h>
+
+// Statystyki gracza z wszystkich gier (po pseudonimie), trwałe między uruchomieniami serwera.
+// Plik to dziennik tylko do dopisywania: nagłówek PROFILE_MAGIC i rekordy
+//   [u32 suma kontrolna][u16 długość nazwy][u16 0][u32 gry][u32 poprawne][u32 najlepszy wynik][u32 0][u64 punkty][nazwa]
+// (liczby w porządku bajtów maszyny). Rekord dokłada się do profilu: gry, poprawne i punkty sumujemy,
+// najlepszy wynik to maksimum. Przy starcie dziennik jest odtwarzany do pierwszego uszkodzonego rekordu
+// (np. urwanego przy awarii) i w tym miejscu obcinany.
+//
+// Pętle zdarzeń tylko dopisują rekord do bufora w pamięci. Osobny wątek zapisuje wszystko, co się
+// zebrało, jednym write() i jednym fdatasync() (group commit), a gdy dziennik urośnie kilkukrotnie
+// ponad żywe dane - przepisuje go (kompakcja: plik tymczasowy, fsync, rename).
+#define PROFILE_MAGIC "QUIZPRF1"
+
+// Powyżej tylu bajtów niezapisanych rekordów nowe są odrzucane (dysk nie nadąża)
+#define PROFILE_PENDING_MAX (16u << 20)
+// Kompakcja, gdy dziennik ma ponad tyle bajtów i ponad PROFILE_COMPACT_RATIO razy więcej niż żywe dane
+#define PROFILE_COMPACT_MIN (1u << 20)
+#define PROFILE_COMPACT_RATIO 4
+
+typedef struct ProfileStats {
+    uint32_t games;
+    uint32_t correct;           // poprawne odpowiedzi
+    uint32_t bestScore;         // najlepszy wynik w jednej grze
+    uint64_t points;            // suma punktów
+} ProfileStats;
+
+// Odtwarza dziennik i uruchamia wątek zapisu. Zwraca 0 albo -1 (komunikat na stderr).
+int profile_log_open(const char *path);
+// Zapisuje zaległe rekordy i zatrzymuje wątek
+void profile_log_close();
+
+// Dopisuje wynik jednej gry gracza (nie blokuje na dysku). Bez otwartego dziennika nic nie robi.
+void profile_record_game(const char *name, int correct, int score);
+// Profil gracza; 0 albo -1, gdy gracz nie ma jeszcze zapisanej gry (albo dziennik jest wyłączony)
+int profile_lookup(const char *name, ProfileStats *out);
+
+// Liczniki: rekordy zapisane, wywołania fdatasync, rekordy odrzucone, kompakcje
+typedef struct ProfileLogCounters {
+    uint64_t records;
+    uint64_t commits;
+    uint64_t dropped;
+    uint64_t compactions;
+} ProfileLogCounters;
+void profile_log_counters(ProfileLogCounters *out);
+
+#endif
@@ -0,0 +1,52 @@
+#include "protocol.h"
+
+#include <string.h>
+
+#include "connection.h"
+
+char *bin_put_str(char *p, const char *s) {
+    size_t len = strlen(s);
+    if (len > BIN_MAX_TEXT) {
+        len = BIN_MAX_TEXT;
+        // Nie urywamy znaku wielobajtowego: cofamy się przed bajty kontynuacji (10xxxxxx)
+        while (len > 0 && ((unsigned char)s[len] & 0xC0) == 0x80) len--;
+    }
+    p = bin_put_u16(p, (unsigned)len);
+    memcpy(p, s, len);
+    return p + len;
+}
+
+void bin_send(Connection *c, int op, const char *payload, size_t len) {
+    if (len > BIN_MAX_PAYLOAD) return;
+    char header[BIN_HEADER_SIZE];
+    bin_put_header(header, op, len);
+    conn_send(c, header, sizeof(header));
+    if (len > 0) conn_send(c, payload, len);
+}
+
+void bin_send_u8(Connection *c, int op, unsigned v) {
+    char buf[BIN_HEADER_SIZE + 1];
+    bin_put_u8(bin_put_header(buf, op, 1), v);
+    conn_send(c, buf, sizeof(buf));
+}
+
+void bin_send_u16(Connection *c, int op, unsigned v) {
+    char buf[BIN_HEADER_SIZE + 2];
+    bin_put_u16(bin_put_header(buf, op, 2), v);
+    conn_send(c, buf, sizeof(buf));
+}
+
+void bin_send_str(Connection *c, int op, const char *s) {
+    char buf[2 + BIN_MAX_TEXT];
+    char *end = bin_put_str(buf, s);
+    bin_send(c, op, buf, (size_t)(end - buf));
+}
+
+Frame *bin_append(Frame *f, int op, const char *payload, size_t len) {
+    if (len > BIN_MAX_PAYLOAD) return f;
+    char header[BIN_HEADER_SIZE];
+    bin_put_header(header, op, len);
+    f = frame_append(f, header, sizeof(header));
+    if (f && len > 0) f = frame_append(f, payload, len);
+    return f;
+}
@@ -0,0 +1,83 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame.h"
+
+struct Connection;
+
+// Protokół połączenia. Domyślnie tekstowy (linie po polsku, jak w klient.py).
+// Klient może w lobby wysłać linię "PROTO=BIN1"; serwer odpowiada tekstem "PROTO=BIN1\n"
+// i od tej chwili wysyła mu wyłącznie ramki binarne. Klient dalej wysyła zwykłe linie.
+#define PROTO_TEXT 0
+#define PROTO_BIN1 1
+
+// Ramka BIN1: [długość ładunku u16][kod u8][ładunek]. Liczby w kolejności sieciowej (big-endian),
+// napisy jako [długość u16][bajty UTF-8] bez zera na końcu.
+#define BIN_HEADER_SIZE 3
+#define BIN_MAX_PAYLOAD 65535
+#define BIN_MAX_TEXT    1000   // dłuższe napisy przycinamy (jak %.1000s w protokole tekstowym)
+
+// Kody ramek serwer -> klient (w nawiasie ładunek)
+#define OP_NAME_PROMPT    0x01   // podaj pseudonim ()
+#define OP_LOGIN_OK       0x02   // zalogowano ()
+#define OP_NAME_TAKEN     0x03   // pseudonim zajęty ()
+#define OP_ROOM           0x04   // dołączono do pokoju (u32 id)
+#define OP_ROOM_ERROR     0x05   // błąd lobby (napis)
+#define OP_ROOM_LIST      0x06   // lista pokoi (n x [u32 id, u32 gracze])
+#define OP_SPECTATE       0x07   // oglądanie pokoju jako widz (u32 id)
+#define OP_TOKEN          0x08   // token do wznowienia sesji linią RESUME=<token> (napis)
+#define OP_PROFILE        0x09   // profil gracza ze wszystkich gier (u32 gry, u32 poprawne odpowiedzi, u32 najlepszy wynik)
+#define OP_RESUMED        0x0A   // sesja wznowiona (u32 pokój, u32 wynik)
+#define OP_QUESTION       0x10   // pytanie (u16 runda od 1, napis)
+#define OP_TIME_LEFT      0x11   // sekundy do końca rundy (u16)
+#define OP_IN_GAME        0x12   // udział w bieżącej rundzie (u8 0/1)
+#define OP_ANSWER_ACK     0x13   // odpowiedź przyjęta (u8 1) albo pominięta (u8 0)
+#define OP_ROUND_END      0x14   // koniec rundy (u16 runda od 1, u16 liczba wpisów OP_RANK_ENTRY, które następują)
+#define OP_RANK_ENTRY     0x15   // wpis czołówki (u32 miejsce, u16 punkty za pytanie, u32 łącznie, napis pseudonim, napis odpowiedź)
+#define OP_MY_RANK        0x16   // własne miejsce (u32 miejsce, u32 graczy, u16 punkty za pytanie, u32 łącznie)
+#define OP_LOBBY_WAIT     0x20   // pierwszy gracz - start za tyle sekund (u16)
+#define OP_NEW_GAME       0x21   // nowa gra ()
+#define OP_QUESTIONS_END  0x22   // koniec pytań - nowa gra za tyle sekund (u16)
+#define OP_GAME_OVER      0x23   // gra zakończona ()
+
+static inline char *bin_put_u8(char *p, unsigned v) {
+    p[0] = (char)v;
+    return p + 1;
+}
+
+static inline char *bin_put_u16(char *p, unsigned v) {
+    p[0] = (char)(v >> 8);
+    p[1] = (char)v;
+    return p + 2;
+}
+
+static inline char *bin_put_u32(char *p, uint32_t v) {
+    p[0] = (char)(v >> 24);
+    p[1] = (char)(v >> 16);
+    p[2] = (char)(v >> 8);
+    p[3] = (char)v;
+    return p + 4;
+}
+
+// Napis (najwyżej BIN_MAX_TEXT bajtów, przycięty na granicy znaku UTF-8); 'p' musi pomieścić 2 + BIN_MAX_TEXT
+char *bin_put_str(char *p, const char *s);
+
+// Nagłówek ramki o kodzie 'op' i długości ładunku 'len'; zwraca wskaźnik na ładunek
+static inline char *bin_put_header(char *p, int op, size_t len) {
+    p = bin_put_u16(p, (unsigned)len);
+    return bin_put_u8(p, (unsigned)op);
+}
+
+// Dopisuje ramkę do kolejki połączenia (ładunek najwyżej BIN_MAX_PAYLOAD bajtów)
+void bin_send(struct Connection *c, int op, const char *payload, size_t len);
+void bin_send_u8(struct Connection *c, int op, unsigned v);
+void bin_send_u16(struct Connection *c, int op, unsigned v);
+void bin_send_str(struct Connection *c, int op, const char *s);
+
+// Dopisuje ramkę do współdzielonej ramki rozsyłanej (zasady jak frame_append)
+Frame *bin_append(Frame *f, int op, const char *payload, size_t len);
+
+#endif
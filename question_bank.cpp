@@ -0,0 +1,267 @@
+#include "question_bank.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#include "connection.h"
+#include "join_queue.h"
+
+// Zmienne globalne: limit czasu na rundę (s) i liczba rund (wczytywane z config.ini)
+int g_time_limit = 30;
+int g_max_rounds;
+
+// Liczba wątków reaktora (0 = tyle, ile rdzeni)
+int g_worker_threads = 0;
+
+// Ilu najlepszych graczy trafia do rankingu rozsyłanego po rundzie
+int g_ranking_top_k = 10;
+
+// Port administracyjny z metrykami (127.0.0.1, format Prometheusa); 0 = wyłączony
+int g_metrics_port = 0;
+
+// Domyślny limit literówek w odpowiedzi (pytania mogą go zmienić linią FUZZY=<n>); 0 = tylko dokładne trafienia
+int g_fuzzy_max_edits = 0;
+
+// Ile sekund zerwana sesja zalogowanego gracza czeka na RESUME=<token>; 0 = bez wznawiania
+int g_resume_grace = 60;
+
+// Dziennik profili graczy (profile_log.h); pusty = profile wyłączone
+char g_profile_log_path[256] = "";
+
+// Zapis zdarzeń wejściowych do odtworzenia (capture.h); pusty = bez zapisu
+char g_capture_path[256] = "";
+
+// Plik ze skompilowaną bazą pytań (BANK_IMAGE); pusty = baza budowana z sekcji config.ini
+char g_bank_image_path[256] = "";
+
+// Baza pytań i odpowiedzi: niezmienna migawka współdzielona (tylko do odczytu) przez wszystkie pokoje.
+// Pokój przypina migawkę na starcie rundy; przeładowanie publikuje nową, a stara jest zwalniana,
+// gdy odda ją ostatni pokój (w stylu RCU). Blokada chroni tylko odczyt wskaźnika z podbiciem licznika i podmianę.
+static BankSnapshot *current = NULL;
+static pthread_mutex_t currentLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned generationCounter = 0;
+
+// Sekcje bazy zebrane przy jedynym przejściu po config.ini w load_config()
+static BankBuilder pendingBuilder;
+static char pendingFile[256] = "";
+
+// --- Funkcje wczytywania configu (plik config.ini) ---
+
+// Jedno przejście po pliku: parametry klucz=wartość, a sekcje [QUESTION]/[ANSWER] trafiają do budowniczego bazy.
+// Bez 'time_limit' (przeładowanie) czytamy tylko bazę i BANK_IMAGE.
+static int parse_config_file(const char *filename, BankBuilder *builder, char *imagePath, size_t imagePathCap,
+                             int *time_limit, int *max_rounds) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        perror("Nie można otworzyć pliku konfiguracyjnego");
+        return -1;
+    }
+    imagePath[0] = '\0';
+
+    char *line = NULL;
+    size_t lineCap = 0;
+    ssize_t n;
+    while ((n = getline(&line, &lineCap, fp)) != -1) {
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+
+        int inBank = bank_builder_feed_line(builder, line);
+        if (inBank < 0) {
+            fprintf(stderr, "Błąd alokacji pamięci dla bazy pytań.\n");
+            free(line);
+            fclose(fp);
+            return -1;
+        }
+        if (inBank) continue;
+
+        if (line[0] == '#' || line[0] == '\0') {
+            continue; // Pomijamy komentarze i puste linie
+        }
+
+        char *eq = strchr(line, '=');
+        if (!eq) continue;
+
+        *eq = '\0';
+        char *key = line;
+        char *value_str = eq + 1;
+
+        // Odczyt klucz=wartość
+        if (strcmp(key, "BANK_IMAGE") == 0) {
+            snprintf(imagePath, imagePathCap, "%s", value_str);
+        } else if (!time_limit) {
+            continue; // Przeładowanie bazy - parametrów serwera nie zmieniamy
+        } else if (strcmp(key, "TIME_LIMIT") == 0) {
+            // Runda bez czasu (albo z ujemnym) skończyłaby się, zanim ktoś zobaczy pytanie
+            int limit = atoi(value_str);
+            if (limit > 0) {
+                *time_limit = limit;
+            } else {
+                fprintf(stderr, "TIME_LIMIT=%s pominięte - czas rundy musi być dodatni (zostaje %d s).\n", value_str,
+                        *time_limit);
+            }
+        } else if (strcmp(key, "MAX_ROUNDS") == 0) {
+            *max_rounds = atoi(value_str);
+        } else if (strcmp(key, "WORKERS") == 0) {
+            g_worker_threads = atoi(value_str);
+        } else if (strcmp(key, "RANKING_TOP_K") == 0) {
+            int k = atoi(value_str);
+            if (k >= 0) g_ranking_top_k = k;
+        } else if (strcmp(key, "FUZZY_MAX_EDITS") == 0) {
+            int edits = atoi(value_str);
+            g_fuzzy_max_edits = edits > 0 ? edits : 0;
+        } else if (strcmp(key, "RESUME_GRACE") == 0) {
+            int grace = atoi(value_str);
+            g_resume_grace = grace > 0 ? grace : 0;
+        } else if (strcmp(key, "PROFILE_LOG") == 0) {
+            snprintf(g_profile_log_path, sizeof(g_profile_log_path), "%s", value_str);
+        } else if (strcmp(key, "CAPTURE_FILE") == 0) {
+            snprintf(g_capture_path, sizeof(g_capture_path), "%s", value_str);
+        } else if (strcmp(key, "METRICS_PORT") == 0) {
+            g_metrics_port = atoi(value_str);
+        } else if (strcmp(key, "OUTPUT_HIGH_WATER") == 0) {
+            long hw = atol(value_str);
+            if (hw > 0) g_output_high_water = (size_t)hw;
+        } else if (strcmp(key, "SPECTATOR_HIGH_WATER") == 0) {
+            long hw = atol(value_str);
+            if (hw > 0) g_spectator_high_water = (size_t)hw;
+        } else if (strcmp(key, "SLOW_CLIENT_POLICY") == 0) {
+            g_slow_client_drop = (strcmp(value_str, "drop") == 0);
+        } else if (strcmp(key, "LISTEN_BACKLOG") == 0) {
+            int backlog = atoi(value_str);
+            if (backlog > 0) g_listen_backlog = backlog;
+        } else if (strcmp(key, "JOIN_RATE") == 0) {
+            int rate = atoi(value_str);
+            g_join_rate = rate > 0 ? rate : 0;
+        } else if (strcmp(key, "JOIN_QUEUE") == 0) {
+            int limit = atoi(value_str);
+            if (limit > 0) g_join_queue = limit;
+        } else if (strcmp(key, "IO_BACKEND") == 0) {
+            g_io_uring = (strcmp(value_str, "io_uring") == 0);
+        }
+    }
+
+    free(line);
+    fclose(fp);
+    return 0;
+}
+
+int load_config(const char *filename, int *time_limit, int *max_rounds) {
+    bank_builder_free(&pendingBuilder);
+    bank_builder_init(&pendingBuilder);
+    pendingFile[0] = '\0';
+    if (parse_config_file(filename, &pendingBuilder, g_bank_image_path, sizeof(g_bank_image_path),
+                          time_limit, max_rounds) != 0) {
+        bank_builder_free(&pendingBuilder);
+        return -1;
+    }
+    snprintf(pendingFile, sizeof(pendingFile), "%s", filename);
+    return 0;
+}
+
+// Nowa migawka: zmapowany obraz (imagePath), sekcje zebrane w 'builder' albo kompilacja pliku
+static BankSnapshot *build_snapshot(const char *filename, BankBuilder *builder, const char *imagePath) {
+    BankSnapshot *s = (BankSnapshot *)calloc(1, sizeof(BankSnapshot));
+    if (!s) {
+        fprintf(stderr, "Błąd alokacji pamięci dla bazy pytań.\n");
+        return NULL;
+    }
+
+    int rc;
+    if (imagePath[0]) {
+        rc = bank_image_open(&s->bank, imagePath);
+    } else {
+        char *image = NULL;
+        size_t size = 0;
+        rc = builder ? bank_builder_finish(builder, &image, &size) : bank_compile_file(filename, &image, &size);
+        if (rc == 0) rc = bank_image_from_memory(&s->bank, image, size);
+    }
+    if (rc != 0) {
+        free(s);
+        return NULL;
+    }
+    s->refs = 1; // referencja trzymana przez 'current'
+    s->generation = __atomic_add_fetch(&generationCounter, 1, __ATOMIC_RELAXED);
+    return s;
+}
+
+// Podmienia bieżącą migawkę; pokoje z trwającą rundą dokończą ją na poprzedniej
+static void publish(BankSnapshot *s) {
+    pthread_mutex_lock(&currentLock);
+    BankSnapshot *old = current;
+    current = s;
+    pthread_mutex_unlock(&currentLock);
+    bank_release(old);
+}
+
+BankSnapshot *bank_acquire() {
+    pthread_mutex_lock(&currentLock);
+    BankSnapshot *s = current;
+    if (s) __atomic_add_fetch(&s->refs, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&currentLock);
+    return s;
+}
+
+void bank_release(BankSnapshot *s) {
+    if (!s) return;
+    if (__atomic_sub_fetch(&s->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        bank_image_close(&s->bank);
+        free(s);
+    }
+}
+
+// Zwolnienie pamięci dynamicznie zaalokowanej
+void free_resources() {
+    publish(NULL);
+    bank_builder_free(&pendingBuilder);
+    pendingFile[0] = '\0';
+}
+
+// Wczytanie bazy pytań/odpowiedzi: zmapowany obraz (BANK_IMAGE) albo obraz zbudowany w pamięci z config.ini
+int load_answers_from_config(const char *filename) {
+    // Sekcje zebrane już przez load_config() - plik nie jest czytany drugi raz
+    int collected = pendingFile[0] && strcmp(pendingFile, filename) == 0;
+    BankSnapshot *s = build_snapshot(filename, collected ? &pendingBuilder : NULL, g_bank_image_path);
+    bank_builder_free(&pendingBuilder);
+    pendingFile[0] = '\0';
+    if (!s) return -1;
+    if (g_bank_image_path[0]) {
+        fprintf(stderr, "INFO: Baza pytań z obrazu %s (pytania: %d)\n", g_bank_image_path, s->bank.questionCount);
+    }
+    publish(s);
+    return 0;
+}
+
+int reload_question_bank(const char *filename) {
+    BankBuilder builder;
+    bank_builder_init(&builder);
+    char imagePath[sizeof(g_bank_image_path)];
+    BankSnapshot *s = NULL;
+    if (parse_config_file(filename, &builder, imagePath, sizeof(imagePath), NULL, NULL) == 0) {
+        s = build_snapshot(filename, &builder, imagePath);
+    }
+    bank_builder_free(&builder);
+    if (!s) {
+        fprintf(stderr, "Przeładowanie bazy pytań nie powiodło się - zostaje poprzednia.\n");
+        return -1;
+    }
+    fprintf(stderr, "INFO: Przeładowano bazę pytań (wersja %u, pytania: %d)\n", s->generation, s->bank.questionCount);
+    publish(s);
+    return 0;
+}
+
+// Funkcja porównująca stringi case-insensitive
+int strcase_compare(const char *a, const char *b) {
+    while (*a && *b) {
+        char ca = tolower((unsigned char)*a);
+        char cb = tolower((unsigned char)*b);
+        if (ca != cb) {
+            return (int)(unsigned char)ca - (int)(unsigned char)cb;
+        }
+        a++;
+        b++;
+    }
+    return (int)(unsigned char)tolower((unsigned char)*a)
+         - (int)(unsigned char)tolower((unsigned char)*b);
+}
@@ -0,0 +1,43 @@
+#ifndef QUESTION_BANK_H
+#define QUESTION_BANK_H
+
+#include "bank_image.h"
+
+#define BUFFER_SIZE 1024
+
+// Parametry gry (config.ini)
+extern int g_time_limit;
+extern int g_max_rounds;
+extern int g_worker_threads;
+extern int g_ranking_top_k;
+extern int g_metrics_port;
+extern int g_fuzzy_max_edits;
+extern int g_resume_grace;
+
+extern char g_bank_image_path[256];
+extern char g_profile_log_path[256];
+extern char g_capture_path[256];
+
+int load_config(const char *filename, int *time_limit, int *max_rounds);
+int load_answers_from_config(const char *filename);
+void free_resources();
+
+// Migawka bazy pytań/odpowiedzi (niezmienna). Pokój przypina ją na czas rundy,
+// więc przeładowanie nie zmienia pytań ani odpowiedzi w trakcie trwającej rundy.
+typedef struct BankSnapshot {
+    QuestionBank bank;          // funkcje dostępu w bank_image.h
+    int refs;                   // licznik referencji (atomowy)
+    unsigned generation;        // numer kolejnej wczytanej wersji
+} BankSnapshot;
+
+// Bieżąca migawka z podbitym licznikiem referencji (NULL, gdy baza nie jest wczytana)
+BankSnapshot *bank_acquire();
+void bank_release(BankSnapshot *s);
+
+// Buduje nową migawkę z pliku (poza wątkami reaktora) i podmienia bieżącą.
+// Przy błędzie zostaje poprzednia baza. Zwraca 0 albo -1.
+int reload_question_bank(const char *filename);
+
+int strcase_compare(const char *a, const char *b);
+
+#endif
@@ -4,587 +4,1331 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/epoll.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <fcntl.h>
 #include <time.h>
-#include <ctype.h>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+
+#include "question_bank.h"
+#include "game_room.h"
+#include "connection.h"
+#include "timer_wheel.h"
+#include "metrics.h"
+#include "profile_log.h"
+#include "protocol.h"
+#include "session.h"
+#include "capture.h"
+#include "uring.h"
+#include "join_queue.h"
+#include "logger.h"
 
 #define PORT 12345
-#define BUFFER_SIZE 1024
-
-// Zmienne globalne: limit czasu na rundę i liczba rund (wczytywane z config.ini)
-static int g_time_limit;
-static int g_max_rounds;
-
-// Ustawienia dot. pytań i odpowiedzi
-#define MAX_QUESTIONS 50
-static int  g_loaded_questions = 0;   // Ile pytań wczytano
-static char questionsConfig[MAX_QUESTIONS][BUFFER_SIZE]; // Tablica pytań
-static char ***answersDB = NULL;      // Tablica 3-wymiarowa: answersDB[i][j] - j-ta poprawna odpowiedź do pytania i
-static int  *answerCounts = NULL;     // Ile odpowiedzi przypada na pytanie i
-
-// --- Funkcje wczytywania configu (plik config.ini) ---
-
-int load_config(const char *filename, int *time_limit, int *max_rounds) {
-    // Wczytywanie TIME_LIMIT i MAX_ROUNDS z pliku
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror("Nie można otworzyć pliku konfiguracyjnego");
-        return -1;
+
+// Połączenie przekazywane między wątkami (np. dołączenie do pokoju innego wątku)
+typedef struct Handoff {
+    Connection *conn;
+    char line[BUFFER_SIZE];   // linia lobby do obsłużenia już w docelowym wątku
+    struct Handoff *next;
+} Handoff;
+
+// Wątek reaktora: własny epoll, własne gniazdo nasłuchujące (SO_REUSEPORT),
+// własne połączenia i pokoje. Połączenie i jego gra są przypięte do jednego wątku,
+// więc obsługa odpowiedzi i rozsyłanie nie wymagają blokad.
+typedef struct Worker {
+    int index;
+    pthread_t thread;
+    int epfd;
+    int listen_fd;
+    int wake_fd;               // eventfd budzący wątek, gdy w skrzynce są przekazane połączenia
+    TimerWheel wheel;          // zegary pokoi wątku (timerfd w epollu)
+    int admin_fd;              // port administracyjny z /metrics (tylko wątek 0; -1 = wyłączony)
+    int spare_fd;              // zapasowy deskryptor: przy EMFILE zwalniany, żeby przyjąć i odrzucić połączenie
+    JoinQueue joins;           // przyjęte gniazda czekające na powitanie (JOIN_RATE)
+    Timer joinTimer;           // kolejne powitanie z kolejki, gdy tempo na nie pozwoli
+    int uring;                 // IO_BACKEND=io_uring: pętla na 'ring' zamiast epolla
+    Uring ring;                // przyjmowanie, gotowość i odbiór
+    Uring sendRing;            // zbiorcza wysyłka kolejek (conn_flush_all)
+
+    pthread_mutex_t inbox_lock;
+    Handoff *inbox;
+
+    // Połączenia wątku indeksowane deskryptorem
+    Connection **conns;
+    int connCap;
+
+    // Pokoje tego wątku indeksowane numerem lokalnym; numer globalny = lokalny * workerCount + index.
+    // rooms_lock chroni tablicę i liczniki graczy, bo ROOM_LIST czyta je z innych wątków.
+    pthread_mutex_t rooms_lock;
+    GameRoom **rooms;
+    int roomsCap;
+
+    Metrics metrics;           // pisane tylko przez ten wątek, czytane przy /metrics
+} Worker;
+
+static Worker *workers = NULL;
+static int workerCount = 0;
+
+// Ustawia deskryptor w tryb nieblokujący
+static void set_nonblock(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Podnosi limit deskryptorów do maksimum (tysiące połączeń, także czekających w kolejce przyjęć)
+static void raise_fd_limit() {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
     }
+}
 
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) {
-        if (line[0] == '#' || line[0] == '\n') {
-            continue; // Pomijamy komentarze i puste linie
-        }
-        char *nl = strchr(line, '\n');
-        if (nl) *nl = '\0';
+// Rejestruje połączenie w wątku (w lobby albo przekazane z innego wątku) i dodaje je do epolla
+static int track_connection(Worker *w, Connection *c) {
+    int fd = c->fd;
+    if (fd >= w->connCap) {
+        int newCap = w->connCap ? w->connCap : 64;
+        while (newCap <= fd) newCap *= 2;
+        Connection **tmp = (Connection **)realloc(w->conns, newCap * sizeof(Connection *));
+        if (!tmp) return -1;
+        memset(tmp + w->connCap, 0, (newCap - w->connCap) * sizeof(Connection *));
+        w->conns = tmp;
+        w->connCap = newCap;
+    }
+    if (conn_attach(c, w->epfd) != 0) return -1;
+    w->conns[fd] = c;
+    return 0;
+}
 
-        char *eq = strchr(line, '=');
-        if (!eq) continue;
+static void destroy_room(Worker *w, GameRoom *room);
 
-        *eq = '\0';
-        char *key = line;
-        char *value_str = eq + 1;
+// Ostatnia sesja pustego pokoju wygasła - pokój (poza domyślnym i oglądanym przez widzów) jest usuwany
+static void room_empty_cb(GameRoom *room, void *arg) {
+    if (room->spectators.count == 0 && room->id != 0) destroy_room((Worker *)arg, room);
+}
 
-        // Odczyt klucz=wartość
-        if (strcmp(key, "TIME_LIMIT") == 0) {
-            *time_limit = atoi(value_str);
-        } else if (strcmp(key, "MAX_ROUNDS") == 0) {
-            *max_rounds = atoi(value_str);
+// Tworzy pokój w pierwszym wolnym numerze lokalnym wątku
+static GameRoom *create_room(Worker *w) {
+    pthread_mutex_lock(&w->rooms_lock);
+    int local = 0;
+    while (local < w->roomsCap && w->rooms[local]) local++;
+    if (local >= w->roomsCap) {
+        int newCap = w->roomsCap ? w->roomsCap * 2 : 16;
+        GameRoom **tmp = (GameRoom **)realloc(w->rooms, newCap * sizeof(GameRoom *));
+        if (!tmp) {
+            pthread_mutex_unlock(&w->rooms_lock);
+            return NULL;
         }
+        memset(tmp + w->roomsCap, 0, (newCap - w->roomsCap) * sizeof(GameRoom *));
+        w->rooms = tmp;
+        w->roomsCap = newCap;
+    }
+    w->rooms[local] = room_create(local * workerCount + w->index, &w->wheel);
+    GameRoom *room = w->rooms[local];
+    if (room) {
+        room->on_empty = room_empty_cb;
+        room->on_empty_arg = w;
     }
+    pthread_mutex_unlock(&w->rooms_lock);
+    return room;
+}
 
-    fclose(fp);
-    return 0;
+static void destroy_room(Worker *w, GameRoom *room) {
+    pthread_mutex_lock(&w->rooms_lock);
+    w->rooms[room->id / workerCount] = NULL;
+    pthread_mutex_unlock(&w->rooms_lock);
+    room_destroy(room);
+}
+
+// Pokój o numerze globalnym 'id' należący do wątku 'w' (lub NULL)
+static GameRoom *find_room(Worker *w, int id) {
+    int local = id / workerCount;
+    if (id < 0 || local >= w->roomsCap) return NULL;
+    return w->rooms[local];
+}
+
+// Przenosi połączenie z lobby do pokoju
+static Player *join_room(Worker *w, Connection *c, GameRoom *room) {
+    pthread_mutex_lock(&w->rooms_lock);
+    Player *p = room_add_player(room, c);
+    pthread_mutex_unlock(&w->rooms_lock);
+    if (!p) return NULL;
+    c->room = room;
+    c->player = p;
+    return p;
 }
 
-// Zwolnienie pamięci dynamicznie zaalokowanej
-void free_resources() {
-    // Usuwamy tablice z pytaniami i odpowiedziami
-    for (int i = 0; i < g_loaded_questions; i++) {
-        for (int j = 0; j < answerCounts[i]; j++) {
-            free(answersDB[i][j]);
+// Zamyka połączenie; pusty pokój (poza domyślnym, bez graczy, widzów i sesji do wznowienia) jest usuwany
+static void drop_connection(Worker *w, Connection *c) {
+    int fd = c->fd;
+    GameRoom *room = c->room;
+    if (room) {
+        // Pod blokadą tylko zmiana liczników; ewentualny koniec rundy (punkty, ranking, rozsyłka) już bez niej
+        pthread_mutex_lock(&w->rooms_lock);
+        if (c->spectator) room_remove_spectator(room, c);
+        else room_remove_player(room, fd);
+        pthread_mutex_unlock(&w->rooms_lock);
+        if (!c->spectator) room_after_leave(room);
+        if (room->active_players == 0 && room->spectators.count == 0 && room->sessions.count == 0 && room->id != 0) {
+            destroy_room(w, room);
         }
-        free(answersDB[i]);
     }
-    free(answersDB);
-    free(answerCounts);
+    int admin = c->admin;
+    if (fd < w->connCap) w->conns[fd] = NULL;
+    conn_free(c);
+    conn_close_fd(fd);
+    if (admin) return;
+    metric_add(&t_metrics->closed, 1);
+    LOG_DEBUG("Rozłączono klienta fd=%d", fd);
 }
 
-// Wczytywanie bazy pytań/odpowiedzi z pliku config.ini
-int load_answers_from_config(const char *filename) {
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        fprintf(stderr, "Brak pliku %s lub nie można wczytać.\n", filename);
-        return -1;
-    }
+static void drop_connection_cb(Connection *c, void *arg) {
+    drop_connection((Worker *)arg, c);
+}
 
-    answersDB = (char ***)calloc(MAX_QUESTIONS, sizeof(char**));
-    if (!answersDB) {
-        fprintf(stderr, "Błąd alokacji pamięci dla answersDB.\n");
-        fclose(fp);
-        return -1;
-    }
-    answerCounts = (int *)calloc(MAX_QUESTIONS, sizeof(int));
-    if (!answerCounts) {
-        fprintf(stderr, "Błąd alokacji pamięci dla answerCounts.\n");
-        free(answersDB);
-        fclose(fp);
-        return -1;
+// Przekazuje połączenie (z nieobsłużoną linią lobby i kolejką wyjściową) do innego wątku
+static void hand_off(Worker *from, Connection *c, const char *line, Worker *to) {
+    Handoff *h = (Handoff *)malloc(sizeof(Handoff));
+    if (!h) {
+        drop_connection(from, c);
+        return;
     }
+    conn_detach(c);
+    if (c->fd < from->connCap) from->conns[c->fd] = NULL;
+
+    h->conn = c;
+    snprintf(h->line, sizeof(h->line), "%s", line);
+    pthread_mutex_lock(&to->inbox_lock);
+    h->next = to->inbox;
+    to->inbox = h;
+    pthread_mutex_unlock(&to->inbox_lock);
+
+    uint64_t one = 1;
+    if (write(to->wake_fd, &one, sizeof(one)) < 0) perror("write eventfd");
+}
 
-    int currentQ = -1;
-    char line[BUFFER_SIZE];
-
-    while (fgets(line, sizeof(line), fp)) {
-        char *nl = strchr(line, '\n');
-        if (nl) *nl = '\0';
+// Błąd lobby w protokole połączenia
+static void send_room_error(Connection *c, const char *reason) {
+    if (c->proto == PROTO_BIN1) {
+        bin_send_str(c, OP_ROOM_ERROR, reason);
+        return;
+    }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "ROOM_ERROR=%s\n", reason);
+    conn_send_text(c, msg);
+}
 
-        // Sekcja [QUESTION]
-        if (strcmp(line, "[QUESTION]") == 0) {
-            if (fgets(line, sizeof(line), fp)) {
-                nl = strchr(line, '\n');
-                if (nl) *nl = '\0';
-                currentQ++;
-                if (currentQ >= MAX_QUESTIONS) {
-                    fprintf(stderr, "Za dużo pytań w pliku konfiguracyjnym!\n");
-                    break;
-                }
-                strcpy(questionsConfig[currentQ], line);
-                answersDB[currentQ] = NULL;
-                answerCounts[currentQ] = 0;
-                g_loaded_questions++;
+// Lista pokoi wszystkich wątków: ROOMS=<id>:<gracze>,<id>:<gracze>,...
+// (w BIN1 ramka OP_ROOM_LIST z parami u32, najwyżej tyle, ile zmieści się w jednej ramce)
+static void send_room_list(Connection *c) {
+    int binary = c->proto == PROTO_BIN1;
+    size_t cap = 64, len = 0;
+    char *msg = (char *)malloc(cap);
+    if (!msg) return;
+    if (!binary) len = (size_t)snprintf(msg, cap, "ROOMS=");
+    for (int i = 0; i < workerCount; i++) {
+        Worker *w = &workers[i];
+        pthread_mutex_lock(&w->rooms_lock);
+        size_t need = len + (size_t)w->roomsCap * 24 + 2;
+        if (need > cap) {
+            char *tmp = (char *)realloc(msg, need);
+            if (!tmp) {
+                pthread_mutex_unlock(&w->rooms_lock);
+                break;
             }
+            msg = tmp;
+            cap = need;
         }
-        // Sekcja [ANSWER]
-        else if (strcmp(line, "[ANSWER]") == 0) {
-            while (fgets(line, sizeof(line), fp)) {
-                char *nl2 = strchr(line, '\n');
-                if (nl2) *nl2 = '\0';
-
-                if (strcmp(line, "[QUESTION]") == 0 || strcmp(line, "[ANSWER]") == 0) {
-                    // Cofamy wskaźnik w pliku, by nie zgubić tej linii
-                    fseek(fp, -((long)strlen(line) + 1), SEEK_CUR);
-                    break;
-                }
-                int idx = answerCounts[currentQ];
-                char **newAnswers = (char **)realloc(answersDB[currentQ], (idx + 1) * sizeof(char *));
-                if (!newAnswers) {
-                    fprintf(stderr, "Błąd alokacji pamięci dla odpowiedzi.\n");
-                    fclose(fp);
-                    free_resources();
-                    return -1;
-                }
-                answersDB[currentQ] = newAnswers;
-                answersDB[currentQ][idx] = strdup(line);
-                if (!answersDB[currentQ][idx]) {
-                    fprintf(stderr, "Błąd alokacji pamięci dla odpowiedzi.\n");
-                    fclose(fp);
-                    free_resources();
-                    return -1;
-                }
-                answerCounts[currentQ]++;
+        for (int r = 0; r < w->roomsCap; r++) {
+            if (!w->rooms[r]) continue;
+            if (binary) {
+                if (len + 8 > BIN_MAX_PAYLOAD) break;
+                char *end = bin_put_u32(msg + len, (uint32_t)w->rooms[r]->id);
+                end = bin_put_u32(end, (uint32_t)w->rooms[r]->active_players);
+                len = (size_t)(end - msg);
+                continue;
             }
+            len += (size_t)snprintf(msg + len, cap - len, "%s%d:%d",
+                                    (len > 6 ? "," : ""), w->rooms[r]->id, w->rooms[r]->active_players);
         }
+        pthread_mutex_unlock(&w->rooms_lock);
+    }
+    if (binary) {
+        bin_send(c, OP_ROOM_LIST, msg, len);
+    } else {
+        snprintf(msg + len, cap - len, "\n");
+        conn_send_text(c, msg);
     }
+    free(msg);
+}
 
-    fclose(fp);
-    return 0;
+static int handle_lobby_message(Worker *w, Connection *c, const char *buffer);
+static int process_lines(Worker *w, Connection *c);
+
+// Obsługa połączeń przekazanych przez inne wątki
+static void drain_inbox(Worker *w) {
+    uint64_t cnt;
+    if (read(w->wake_fd, &cnt, sizeof(cnt)) < 0) {
+        // EAGAIN - ktoś już opróżnił licznik
+    }
+
+    pthread_mutex_lock(&w->inbox_lock);
+    Handoff *h = w->inbox;
+    w->inbox = NULL;
+    pthread_mutex_unlock(&w->inbox_lock);
+
+    while (h) {
+        Handoff *next = h->next;
+        if (track_connection(w, h->conn) != 0) {
+            close(h->conn->fd);
+            conn_free(h->conn);
+        } else if (handle_lobby_message(w, h->conn, h->line) == 0) {
+            // Linie, które przyszły w tej samej paczce, co przekazana
+            if (process_lines(w, h->conn) == 0) conn_update_io(h->conn);
+        }
+        free(h);
+        h = next;
+    }
 }
 
-// Funkcja porównująca stringi case-insensitive
-int strcase_compare(const char *a, const char *b) {
-    while (*a && *b) {
-        char ca = tolower((unsigned char)*a);
-        char cb = tolower((unsigned char)*b);
-        if (ca != cb) {
-            return (int)(unsigned char)ca - (int)(unsigned char)cb;
+// RESUME= z tokenem gracza, którego stare połączenie jeszcze nie zostało zamknięte: zerwanie mogło
+// dotrzeć później niż nowe połączenie (io_uring nie porządkuje zakończeń różnych gniazd, a półotwarte
+// łącze WAN wisi do keepalive). Stare połączenie zamykamy jak po zerwaniu - jego sesja czeka na wznowienie.
+static void take_over_session(Worker *w, Connection *c, GameRoom *room, const uint64_t token[2]) {
+    for (int i = 0; i < room->players.count; i++) {
+        Player *p = &room->players.items[i];
+        if (p->conn != c && p->token[0] == token[0] && p->token[1] == token[1] && (token[0] | token[1])) {
+            LOG_INFO("RESUME przejmuje sesję %s - zamykam poprzednie połączenie fd=%d",
+                     p->name ? p->name : "?", p->fd);
+            drop_connection(w, p->conn);
+            return;
         }
-        a++;
-        b++;
     }
-    return (int)(unsigned char)tolower((unsigned char)*a)
-         - (int)(unsigned char)tolower((unsigned char)*b);
 }
 
-// Sprawdza, czy 'response' istnieje w answersDB dla rundy 'roundIndex'
-int is_in_database(int roundIndex, const char *response) {
-    if (roundIndex < 0 || roundIndex >= g_loaded_questions) {
+// Wznowienie sesji po zerwanym połączeniu. Token zaczyna się numerem pokoju, więc linia trafia
+// do wątku pokoju jak ROOM_JOIN=. Zwraca 1, jeśli połączenie przekazano innemu wątkowi.
+static int resume_session(Worker *w, Connection *c, const char *buffer) {
+    int id;
+    uint64_t token[2];
+    if (session_parse_token(buffer + 7, &id, token) != 0) {
+        send_room_error(c, "Niepoprawny token");
         return 0;
     }
-    for (int i = 0; i < answerCounts[roundIndex]; i++) {
-        if (strcase_compare(answersDB[roundIndex][i], response) == 0) {
-            return 1;
-        }
+    Worker *owner = &workers[id % workerCount];
+    if (owner != w) {
+        hand_off(w, c, buffer, owner);
+        return 1;
+    }
+    GameRoom *room = find_room(w, id);
+    if (room && !session_find(&room->sessions, token)) take_over_session(w, c, room, token);
+    if (!room || !session_find(&room->sessions, token)) {
+        send_room_error(c, "Sesja wygasła");
+        return 0;
     }
+    Player *p = join_room(w, c, room);
+    if (!p) {
+        send_room_error(c, "Brak pamięci");
+        return 0;
+    }
+    room_resume_player(room, p, token);
     return 0;
 }
 
-// Struktura gracza
-typedef struct Player {
-    int fd;             // deskryptor gniazda
-    char *name;         // pseudonim
-    char *response;     // odpowiedź (jeden string na rundę)
-    int score;          // suma punktów
-    int answered;       // czy odpowiedział w tej rundzie (flaga)
-    int in_game;        // czy jest w grze w tej rundzie
-    int got_name;       // czy w ogóle ma pseudonim
-    int lastPoints;     // punkty uzyskane w ostatniej rundzie
-    double answerTime;  // czas odpowiedzi (sekundy od startu rundy)
-    struct Player *next;
-} Player;
+// Numer pokoju z ROOM_JOIN=<id> / SPECTATE=<id>: same cyfry (strtol przyjąłby też pusty napis,
+// spacje i znak). Zwraca 0 albo -1.
+static int parse_room_id(const char *text, int *id) {
+    if (*text < '0' || *text > '9') return -1;
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (errno != 0 || *end != '\0' || value > INT_MAX) return -1;
+    *id = (int)value;
+    return 0;
+}
 
-// Lista graczy (powiązania przez next), plus ogólne liczniki
-static Player *playersHead = NULL;
-int active_players = 0;
+// Protokół lobby (przed podaniem pseudonimu):
+//   ROOM_LIST        -> ROOMS=<id>:<gracze>,...
+//   ROOM_CREATE      -> ROOM=<id>, nowy pokój (w bieżącym wątku)
+//   ROOM_JOIN=<id>   -> ROOM=<id> albo ROOM_ERROR=...
+//   SPECTATE=<id>    -> SPECTATE=<id> albo ROOM_ERROR=..., połączenie tylko ogląda grę (bez pseudonimu)
+//   PROTO=BIN1       -> PROTO=BIN1, dalej serwer wysyła ramki binarne (protocol.h); nieznana wersja -> PROTO=TEXT
+//   RESUME=<token>   -> RESUMED=<id>:<wynik> albo ROOM_ERROR=..., powrót do gry z tokenem TOKEN= z logowania
+// Każda inna linia to pseudonim w pokoju domyślnym 0 (zgodność ze starym klientem).
+// Pokój o numerze id należy do wątku id % workerCount - połączenie jest tam przekazywane.
+// Zwraca 1, jeśli połączenie opuściło ten wątek (dalszych linii nie przetwarzamy tutaj).
+static int handle_lobby_message(Worker *w, Connection *c, const char *buffer) {
+    if (strcmp(buffer, "ROOM_LIST") == 0) {
+        send_room_list(c);
+        return 0;
+    }
+    if (strncmp(buffer, "PROTO=", 6) == 0) {
+        // Potwierdzenie idzie jeszcze tekstem - klient przełącza się po tej linii
+        if (c->proto == PROTO_TEXT && strcmp(buffer + 6, "BIN1") == 0) {
+            conn_send_text(c, "PROTO=BIN1\n");
+            c->proto = PROTO_BIN1;
+        } else if (c->proto == PROTO_TEXT) {
+            conn_send_text(c, "PROTO=TEXT\n");
+        }
+        return 0;
+    }
 
-// Zmienne stanu rund
-int current_round = 0;
-int round_in_progress = 0;
-char current_question[BUFFER_SIZE] = {0};
-time_t round_start_time;
+    if (strncmp(buffer, "RESUME=", 7) == 0) {
+        return resume_session(w, c, buffer);
+    }
 
-// Zmienne do czekania 20s na start gry i do wyświetlania rankingu końcowego
-int waiting_for_first_player = 0;
-time_t first_player_wait_start = 0;
+    GameRoom *room;
+    int explicitJoin = 1;
+    int spectate = strncmp(buffer, "SPECTATE=", 9) == 0;
+    if (strcmp(buffer, "ROOM_CREATE") == 0) {
+        room = create_room(w);
+        if (!room) {
+            send_room_error(c, "Nie udało się utworzyć pokoju");
+            return 0;
+        }
+    } else {
+        int id = 0;
+        int rc = 0;
+        if (strncmp(buffer, "ROOM_JOIN=", 10) == 0) {
+            rc = parse_room_id(buffer + 10, &id);
+        } else if (spectate) {
+            rc = parse_room_id(buffer + 9, &id);
+        } else {
+            explicitJoin = 0;
+        }
+        if (rc != 0) {
+            send_room_error(c, "Niepoprawny numer pokoju");
+            return 0;
+        }
+        Worker *owner = &workers[id % workerCount];
+        if (owner != w) {
+            hand_off(w, c, buffer, owner);
+            return 1;
+        }
+        room = find_room(w, id);
+        if (!room) {
+            send_room_error(c, "Nie ma takiego pokoju");
+            return 0;
+        }
+    }
 
-int showing_final_ranking = 0;
-time_t final_ranking_start = 0;
+    if (spectate) {
+        pthread_mutex_lock(&w->rooms_lock);
+        int rc = room_add_spectator(room, c);
+        pthread_mutex_unlock(&w->rooms_lock);
+        if (rc != 0) {
+            send_room_error(c, "Brak pamięci");
+            return 0;
+        }
+        c->room = room;
+        if (c->proto == PROTO_BIN1) {
+            char id[4];
+            bin_put_u32(id, (uint32_t)room->id);
+            bin_send(c, OP_SPECTATE, id, sizeof(id));
+        } else {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "SPECTATE=%d\n", room->id);
+            conn_send_text(c, msg);
+        }
+        return 0;
+    }
+
+    Player *p = join_room(w, c, room);
+    if (!p) {
+        send_room_error(c, "Brak pamięci");
+        if (room->active_players == 0 && room->id != 0) {
+            destroy_room(w, room);
+        }
+        return 0;
+    }
 
-// Zamyka wszystkie gniazda (wywoływane przy wyjściu z programu)
-void close_all_sockets() {
-    Player *p = playersHead;
-    while (p) {
-        close(p->fd);
-        p = p->next;
+    if (explicitJoin && c->proto == PROTO_BIN1) {
+        char id[4];
+        bin_put_u32(id, (uint32_t)room->id);
+        bin_send(c, OP_ROOM, id, sizeof(id));
+        bin_send(c, OP_NAME_PROMPT, NULL, 0);
+    } else if (explicitJoin) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "ROOM=%d\n", room->id);
+        conn_send_text(c, msg);
+        conn_send_text(c, "Podaj swój pseudonim:\n");
+    } else {
+        // Stary klient od razu podał pseudonim
+        room_handle_message(room, p, buffer);
     }
+    return 0;
 }
 
-// Ustawia deskryptor w tryb nieblokujący
-static void set_nonblock(int fd) {
-    int flags = fcntl(fd, F_GETFL, 0);
-    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+// Port administracyjny: minimalny HTTP. Pierwsza linia to żądanie, pusta linia kończy nagłówki -
+// wtedy odsyłamy metryki wszystkich wątków (format tekstowy Prometheusa) i zamykamy połączenie.
+// Stan w c->admin: 1 = czekamy na linię żądania, 2 = GET /metrics, 3 = inna ścieżka.
+static void handle_admin_line(Connection *c, const char *line) {
+    if (c->closeAfterFlush) return;
+    if (c->admin == 1) {
+        c->admin = (strncmp(line, "GET /metrics ", 13) == 0 || strncmp(line, "GET / ", 6) == 0) ? 2 : 3;
+        return;
+    }
+    if (line[0] != '\0') return; // kolejne nagłówki pomijamy
+
+    char header[256];
+    Frame *body = NULL;
+    if (c->admin == 2) {
+        Metrics *total = (Metrics *)calloc(1, sizeof(Metrics));
+        if (total) {
+            for (int i = 0; i < workerCount; i++) metrics_merge(total, &workers[i].metrics);
+            body = frame_alloc(8192);
+            if (body) body = metrics_format(body, total, workerCount);
+            free(total);
+        }
+    }
+    if (body) {
+        snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                 "Content-Length: %zu\r\nConnection: close\r\n\r\n", body->len);
+        conn_send_text(c, header);
+        conn_send_frame(c, body);
+        frame_unref(body);
+    } else {
+        const char *status = c->admin == 2 ? "500 Internal Server Error" : "404 Not Found";
+        snprintf(header, sizeof(header), "HTTP/1.1 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+        conn_send_text(c, header);
+    }
+    c->closeAfterFlush = 1;
 }
 
-// Dodanie nowego gracza do listy
-static void add_player(int fd) {
-    Player *p = (Player*) malloc(sizeof(Player));
-    p->fd = fd;
-    p->name = NULL;
-    p->response = NULL;
-    p->score = 0;
-    p->answered = 0;
-    p->in_game = 0;
-    p->got_name = 0;
-    p->lastPoints = 0;
-    p->answerTime = -1.0;
-    p->next = playersHead;
-    playersHead = p;
-    active_players++;
-}
-
-// Usunięcie gracza (rozłączył się itp.)
-static void remove_player(int fd) {
-    Player *curr = playersHead;
-    Player *prev = NULL;
-
-    while (curr) {
-        if (curr->fd == fd) {
-            if (!prev) {
-                playersHead = curr->next;
-            } else {
-                prev->next = curr->next;
-            }
-            close(curr->fd);
-            if (curr->name) free(curr->name);
-            if (curr->response) free(curr->response);
-            free(curr);
-            active_players--;
-
-            // Jeżeli już nie ma graczy -> reset stanu
-            if (active_players == 0) {
-                current_round = 0;
-                round_in_progress = 0;
-                memset(current_question, 0, sizeof(current_question));
-                fprintf(stderr, "INFO: Wszyscy gracze wyszli - gra zostaje zresetowana.\n");
-            }
+// Przetwarza wszystkie pełne linie z bufora wejściowego połączenia (polecenia lobby, pseudonim, odpowiedzi).
+// Zwraca 1, jeśli połączenie przekazano innemu wątkowi - resztę obsłuży już on.
+static int process_lines(Worker *w, Connection *c) {
+    char *line;
+    while ((line = conn_next_line(c)) != NULL) {
+        if (c->admin) {
+            handle_admin_line(c, line);
+            continue;
+        }
+        if (!c->room) {
+            if (handle_lobby_message(w, c, line) != 0) return 1;
+            continue;
+        }
+        if (c->spectator) continue; // widz tylko odbiera
+        room_handle_message(c->room, c->player, line);
+    }
+    return 0;
+}
+
+// Obsługa danych od klienta: cała dostępna paczka bajtów jest wczytywana naraz,
+// a zawarte w niej linie obsługiwane po kolei
+static void handle_client_data(Worker *w, Connection *c) {
+    int st;
+    do {
+        // Nowe bajty trafią za nieprzetworzoną resztą (conn_read() przesuwa ją na początek bufora)
+        size_t kept = c->inEnd - c->inStart;
+        st = conn_read(c);
+        if (c->captureId && c->inEnd > kept) {
+            capture_event(CAPTURE_DATA, w->index, c->captureId, c->in + kept, c->inEnd - kept);
+        }
+        if (process_lines(w, c) != 0) return;
+    } while (st == CONN_READ_FULL);
+
+    if (st == CONN_READ_CLOSED) {
+        // Błąd/rozłączenie
+        if (c->captureId) capture_event(CAPTURE_CLOSE, w->index, c->captureId, NULL, 0);
+        drop_connection(w, c);
+        return;
+    }
+    // io_uring: połączenie, które weszło do pokoju, dalej czyta odbiór multishot
+    conn_update_io(c);
+}
+
+// io_uring: paczka danych z odbioru multishot połączenia w pokoju (bufor pierścienia oddaje wywołujący)
+static void handle_client_recv(Worker *w, Connection *c, const char *data, size_t len) {
+    while (len > 0) {
+        size_t kept = c->inEnd - c->inStart;
+        size_t n = conn_feed(c, data, len);
+        if (n == 0) {
+            drop_connection(w, c);
             return;
         }
-        prev = curr;
-        curr = curr->next;
+        if (c->captureId) capture_event(CAPTURE_DATA, w->index, c->captureId, c->in + kept, n);
+        data += n;
+        len -= n;
+        if (process_lines(w, c) != 0) return;
     }
 }
 
-// Wyszukiwanie gracza po deskryptorze gniazda
-static Player* find_player_by_fd(int fd) {
-    Player *p = playersHead;
-    while (p) {
-        if (p->fd == fd) return p;
-        p = p->next;
+// Rejestruje nowe połączenie gracza w wątku i wysyła powitanie (przy zapisie zdarzeń - rekord ACCEPT).
+// Przy błędzie zamyka gniazdo i zwraca NULL.
+static Connection *admit_client(Worker *w, int fd) {
+    Connection *c = conn_create(fd, w->epfd);
+    if (!c || track_connection(w, c) != 0) {
+        conn_free(c);
+        close(fd);
+        return NULL;
     }
-    return NULL;
+    if (g_capture_fd >= 0) {
+        c->captureId = capture_next_conn();
+        capture_event(CAPTURE_ACCEPT, w->index, c->captureId, NULL, 0);
+    }
+    conn_send_text(c, "Podaj swój pseudonim:\n");
+    metric_add(&t_metrics->accepted, 1);
+    LOG_DEBUG("Połączono klienta fd=%d", fd);
+    return c;
 }
 
-// Sprawdza, czy pseudonim jest już zajęty
-int is_name_taken(const char *name) {
-    Player *p = playersHead;
-    while (p) {
-        if (p->name && strcmp(p->name, name) == 0) {
-            return 1;
+// Odmowa przy pełnej kolejce przyjęć: jedna linia wprost do gniazda (bez Connection) i zamknięcie.
+// Klient nie zdążył jeszcze wybrać protokołu, więc zawsze tekstowo.
+static void reject_client(int fd, int retryAfter) {
+    char msg[80];
+    int len = snprintf(msg, sizeof(msg), "Serwer pełny, spróbuj ponownie za %d s\n", retryAfter);
+    if (send(fd, msg, (size_t)len, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+        // klient i tak dostanie rozłączenie
+    }
+    close(fd);
+    metric_add(&t_metrics->rejected, 1);
+}
+
+// Nowe gniazdo gracza z accept(): powitanie od razu albo w tempie JOIN_RATE (kolejka przyjęć)
+static void offer_client(Worker *w, int fd, uint64_t accept_ns) {
+    int verdict = join_queue_offer(&w->joins, fd, accept_ns);
+    if (verdict == JOIN_ADMIT) {
+        if (admit_client(w, fd)) hist_record_since(&t_metrics->accept, accept_ns);
+    } else if (verdict == JOIN_QUEUED) {
+        metric_add(&t_metrics->joinQueued, 1);
+        if (!timer_pending(&w->joinTimer)) {
+            timer_schedule(&w->wheel, &w->joinTimer, monotonic_ms() + join_queue_delay_ms(&w->joins, accept_ns));
         }
-        p = p->next;
+    } else {
+        reject_client(fd, join_queue_retry_after(&w->joins));
     }
-    return 0;
 }
 
-// Wysyłanie tekstu do wszystkich graczy
-void send_to_all(const char *message) {
-    if (!message || !*message) return;
-    Player *p = playersHead;
-    while (p) {
-        send(p->fd, message, strlen(message), 0);
-        p = p->next;
+// Zegar kolejki przyjęć: wita tylu czekających, na ilu pozwala tempo, i czeka na kolejne
+static void join_timer_cb(void *arg) {
+    Worker *w = (Worker *)arg;
+    uint64_t now = monotonic_real_ns();
+    uint64_t since;
+    int fd;
+    while ((fd = join_queue_next(&w->joins, now, &since)) >= 0) {
+        hist_record(&t_metrics->joinWait, now > since ? now - since : 0);
+        admit_client(w, fd);
+    }
+    if (w->joins.count > 0) {
+        timer_schedule(&w->wheel, &w->joinTimer, monotonic_ms() + join_queue_delay_ms(&w->joins, now));
     }
 }
 
-// Struktura pomocnicza do sortowania rankingu
-typedef struct {
-    Player *player;
-    int position;
-} RankedPlayer;
+// Limit deskryptorów procesu wyczerpany (EMFILE): zwalniamy zapasowy, przyjmujemy jedno połączenie
+// i od razu je odrzucamy. Inaczej czekające połączenie budziłoby wątek bez końca.
+// Zwraca 0, gdy coś przyjęto (warto próbować dalej).
+static int shed_connection(Worker *w) {
+    if (w->spare_fd == -1) return -1;
+    close(w->spare_fd);
+    int fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd != -1) reject_client(fd, join_queue_retry_after(&w->joins));
+    w->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    return fd != -1 ? 0 : -1;
+}
 
-// Porównanie wg score (malejąco)
-int compare_scores(const void *a, const void *b) {
-    const RankedPlayer *ra = (const RankedPlayer *)a;
-    const RankedPlayer *rb = (const RankedPlayer *)b;
-    return rb->player->score - ra->player->score;
+// Opróżnia kolejkę gniazda nasłuchującego do końca (accept4 aż do EAGAIN), żeby przy fali
+// dołączeń jądro nie odrzucało połączeń. Przyjęte gniazda są od razu nieblokujące, a SO_KEEPALIVE
+// dziedziczą po gnieździe nasłuchującym - bez fcntl() i setsockopt() na każde połączenie.
+static void accept_clients(Worker *w) {
+    for (;;) {
+        uint64_t accept_ns = monotonic_real_ns();
+        int fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if ((errno == EMFILE || errno == ENFILE) && shed_connection(w) == 0) continue;
+            // EAGAIN: kolejka pusta (przy wielu wątkach mógł ją opróżnić inny)
+            return;
+        }
+        offer_client(w, fd, accept_ns);
+    }
+}
+
+// Rejestruje połączenie z portem administracyjnym (zapytanie o metryki)
+static void admit_admin(Worker *w, int fd) {
+    Connection *c = conn_create(fd, w->epfd);
+    if (!c) {
+        close(fd);
+        return;
+    }
+    c->admin = 1;
+    if (track_connection(w, c) != 0) {
+        conn_free(c);
+        close(fd);
+    }
 }
 
-// Wysyła posortowany ranking do wszystkich
-void send_sorted_ranking() {
-    int count = 0;
-    Player *p = playersHead;
-    while (p) {
-        count++;
-        p = p->next;
+// SO_REUSEPORT pozwoliłby drugiej instancji serwera dołączyć do grupy gniazd na tym samym porcie
+// (jądro dzieliłoby klientów między dwa niezależne zestawy pokojów). Dlatego przed otwarciem gniazd
+// wątków próbne gniazdo bez SO_REUSEPORT sprawdza, czy nikt inny nie nasłuchuje. Zwraca 0 albo -1.
+static int check_port_free() {
+    int probe = socket(AF_INET, SOCK_STREAM, 0);
+    if (probe == -1) {
+        perror("socket");
+        return -1;
+    }
+    // SO_REUSEADDR - połączenia w TIME_WAIT po poprzedniej instancji nie blokują portu
+    int opt = 1;
+    setsockopt(probe, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(PORT);
+    int rc = bind(probe, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc < 0) {
+        if (errno == EADDRINUSE) {
+            fprintf(stderr, "Port %d jest zajęty - czy działa już inna instancja serwera?\n", PORT);
+        } else {
+            perror("bind");
+        }
     }
-    if (count == 0) return;
+    close(probe);
+    return rc < 0 ? -1 : 0;
+}
+
+// Gniazdo nasłuchujące wątku; SO_REUSEPORT rozkłada nowe połączenia między wątki
+static int open_listen_socket() {
+    int server_socket;
+    struct sockaddr_in server_addr;
 
-    RankedPlayer *array = (RankedPlayer*) malloc(sizeof(RankedPlayer) * count);
+    server_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_socket == -1) {
+        perror("socket");
+        return -1;
+    }
 
-    int i=0;
-    p=playersHead;
-    while(p){
-        array[i].player=p;
-        array[i].position=i+1;
-        i++;
-        p=p->next;
+    int opt = 1;
+    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT");
+        close(server_socket);
+        return -1;
     }
 
-    qsort(array, count, sizeof(RankedPlayer), compare_scores);
+    // Ustawiamy keepalive (obsługa zerwań łącza w sieciach WAN)
+    int keepAlive=1;
+    setsockopt(server_socket, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive));
 
-    char msg[BUFFER_SIZE];
-    snprintf(msg, BUFFER_SIZE, "Runda %d zakończona, wyniki:\n", current_round + 1);
-    send_to_all(msg);
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+    server_addr.sin_port = htons(PORT);
 
-    for(int j=0;j<count;j++){
-        Player *pl = array[j].player;
-        // Odpowiedź gracza, lastPoints, sumaryczny score itd.
-        snprintf(msg, BUFFER_SIZE,
-                "%d. %s, Punkty za pytanie: %d, Łącznie: %d, Odpowiedź: %s\n",
-                j+1,
-                (pl->name ? pl->name : "???"),
-                pl->lastPoints,
-                pl->score,
-                (pl->response ? pl->response : "brak"));
-        send_to_all(msg);
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        perror("bind");
+        close(server_socket);
+        return -1;
     }
+    if (listen(server_socket, g_listen_backlog) < 0) {
+        perror("listen");
+        close(server_socket);
+        return -1;
+    }
+    set_nonblock(server_socket);
+    return server_socket;
+}
 
-    free(array);
+// Port administracyjny z metrykami - tylko lokalnie (127.0.0.1)
+static int open_admin_socket(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        perror("port administracyjny");
+        close(fd);
+        return -1;
+    }
+    set_nonblock(fd);
+    return fd;
 }
 
-// Rozpoczęcie rundy (wysłanie pytania, time_left)
-void start_round() {
-    if (current_round >= g_max_rounds) {
-        send_to_all("Gra zakończona!\n");
-        return;
+// io_uring: uzbraja (ponownie, gdy zgłoszenie multishot się skończyło) stałe źródło zdarzeń wątku
+static int arm_worker_source(Worker *w, int kind) {
+    struct io_uring_sqe *sqe = uring_sqe(&w->ring);
+    if (!sqe) return -1;
+    uint64_t tag = io_tag(kind, 0, 0);
+    if (kind == IO_TAG_ACCEPT) uring_prep_accept(sqe, w->listen_fd, tag);
+    else if (kind == IO_TAG_ADMIN) uring_prep_accept(sqe, w->admin_fd, tag);
+    else if (kind == IO_TAG_WAKE) uring_prep_poll(sqe, w->wake_fd, POLLIN, 1, tag);
+    else uring_prep_poll(sqe, w->wheel.tfd, POLLIN, 1, tag);
+    return 0;
+}
+
+// Pierścienie io_uring wątku: przyjmowanie multishot, gotowość eventfd i timerfd. Epoll zostaje
+// utworzony, ale nie jest używany.
+static int worker_init_uring(Worker *w) {
+    if (uring_init(&w->ring, URING_ENTRIES, URING_CQ_ENTRIES, 1) != 0) return -1;
+    if (uring_init(&w->sendRing, URING_ENTRIES, URING_ENTRIES * 2, 0) != 0) return -1;
+    if (arm_worker_source(w, IO_TAG_ACCEPT) != 0 || arm_worker_source(w, IO_TAG_WAKE) != 0 ||
+        arm_worker_source(w, IO_TAG_TIMER) != 0) {
+        return -1;
     }
-    round_in_progress = 1;
+    if (w->admin_fd != -1 && arm_worker_source(w, IO_TAG_ADMIN) != 0) return -1;
+    // Od razu wysyłamy - nieobsługiwana operacja wyjdzie jeszcze przy starcie
+    if (uring_submit(&w->ring, 0) != 0) return -1;
+    w->uring = 1;
+    return 0;
+}
 
-    // Każdy gracz wchodzi do gry, p->answered=0 się ustawia w end_round
-    Player *p = playersHead;
-    while(p){
-        p->in_game=1;
-        p->answerTime = -1.0;
-        p=p->next;
+// Przygotowanie wątku: gniazdo, epoll, eventfd skrzynki.
+// Bez 'sockets' (odtwarzanie zapisu) wątek nie nasłuchuje - połączenia tworzy sterownik odtwarzania.
+static int worker_init(Worker *w, int index, int sockets) {
+    memset(w, 0, sizeof(*w));
+    w->index = index;
+    w->epfd = w->listen_fd = w->wake_fd = w->admin_fd = w->spare_fd = -1;
+    w->wheel.tfd = -1;
+    w->ring.fd = w->sendRing.fd = -1;
+    pthread_mutex_init(&w->inbox_lock, NULL);
+    pthread_mutex_init(&w->rooms_lock, NULL);
+
+    timer_init(&w->joinTimer, join_timer_cb, w);
+
+    if (sockets) {
+        w->listen_fd = open_listen_socket();
+        if (w->listen_fd == -1) return -1;
+        w->spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        // JOIN_RATE i JOIN_QUEUE dotyczą całego serwera - każdy wątek dostaje swoją część
+        int limit = g_join_queue / workerCount;
+        if (join_queue_init(&w->joins, (double)g_join_rate / workerCount, limit > 0 ? limit : 1) != 0) {
+            fprintf(stderr, "Błąd alokacji pamięci dla kolejki przyjęć.\n");
+            return -1;
+        }
     }
 
-    // Jeżeli mamy załadowane pytania, to bierzemy pytanie current_round
-    if (current_round < g_loaded_questions) {
-        snprintf(current_question, BUFFER_SIZE, "Pytanie: %.1000s\n", questionsConfig[current_round]);
+    // Tworzymy epoll
+    w->epfd = epoll_create1(0);
+    if (w->epfd == -1) {
+        perror("epoll_create1");
+        return -1;
+    }
+    w->wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (w->wake_fd == -1) {
+        perror("eventfd");
+        return -1;
+    }
+    if (timer_wheel_init(&w->wheel) != 0) {
+        perror("timerfd_create");
+        return -1;
     }
 
-    send_to_all(current_question);
-    round_start_time=time(NULL);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = w->listen_fd;
+    if (sockets && epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->listen_fd, &ev) == -1) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    ev.data.fd = w->wake_fd;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wake_fd, &ev) == -1) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    // Przy odtwarzaniu zegary odpala sterownik (zegar gry jest wirtualny, timerfd go nie zna)
+    ev.data.fd = w->wheel.tfd;
+    if (sockets && epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->wheel.tfd, &ev) == -1) {
+        perror("epoll_ctl");
+        return -1;
+    }
 
-    fprintf(stderr, "DEBUG: Start rundy %d, pytanie = %s\n", current_round+1, current_question);
+    // /metrics obsługuje wątek 0, w tej samej pętli co graczy
+    if (sockets && index == 0 && g_metrics_port > 0) {
+        w->admin_fd = open_admin_socket(g_metrics_port);
+        if (w->admin_fd == -1) return -1;
+        ev.data.fd = w->admin_fd;
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->admin_fd, &ev) == -1) {
+            perror("epoll_ctl");
+            return -1;
+        }
+    }
 
-    char timeMsg[64];
-    snprintf(timeMsg, sizeof(timeMsg), "TIME_LEFT=%d\n", g_time_limit);
-    send_to_all(timeMsg);
+    if (sockets && g_io_uring && worker_init_uring(w) != 0) {
+        // Jądro bez potrzebnych operacji io_uring (albo limit RLIMIT_MEMLOCK) - ten i kolejne wątki zostają przy epollu
+        perror("io_uring");
+        fprintf(stderr, "IO_BACKEND=io_uring niedostępne - używam epolla.\n");
+        uring_destroy(&w->ring);
+        uring_destroy(&w->sendRing);
+        g_io_uring = 0;
+    }
+    return 0;
 }
 
-// Zakończenie rundy (liczenie punktów, ranking)
-void end_round() {
-    #define MAX_ANSWERS_TEMP 200
-    char *answersTemp[MAX_ANSWERS_TEMP]; // Bufor unikalnych odpowiedzi
-    int countTemp[MAX_ANSWERS_TEMP];
-    int used=0;
+// Zamyka wszystkie gniazda i pokoje wątku (wywoływane przy wyjściu z programu)
+static void worker_cleanup(Worker *w) {
+    for (int fd = 0; fd < w->connCap; fd++) {
+        if (w->conns[fd]) {
+            close(fd);
+            conn_free(w->conns[fd]);
+        }
+    }
+    for (int i = 0; i < w->roomsCap; i++) {
+        if (w->rooms[i]) room_destroy(w->rooms[i]);
+    }
+    free(w->rooms);
+    free(w->conns);
+    while (w->inbox) {
+        Handoff *next = w->inbox->next;
+        close(w->inbox->conn->fd);
+        conn_free(w->inbox->conn);
+        free(w->inbox);
+        w->inbox = next;
+    }
+    if (w->listen_fd != -1) close(w->listen_fd);
+    if (w->admin_fd != -1) close(w->admin_fd);
+    if (w->spare_fd != -1) close(w->spare_fd);
+    join_queue_free(&w->joins);
+    if (w->epfd != -1) close(w->epfd);
+    if (w->wake_fd != -1) close(w->wake_fd);
+    uring_destroy(&w->ring);
+    uring_destroy(&w->sendRing);
+    timer_wheel_destroy(&w->wheel);
+    pthread_mutex_destroy(&w->inbox_lock);
+    pthread_mutex_destroy(&w->rooms_lock);
+}
 
-    // Zliczamy i zapamiętujemy unikalne poprawne odpowiedzi
-    Player *p=playersHead;
-    while (p) {
-        if (p->fd>0 && p->in_game==1 && p->response && is_in_database(current_round, p->response)) {
-            int found=-1;
-            for(int i=0; i<used; i++){
-                if(strcase_compare(answersTemp[i], p->response)==0){
-                    found=i;
-                    break;
+// Jedna iteracja pętli wątku: zdarzenia z epolla (czekając najwyżej 'timeout' ms) i zbiorcza wysyłka.
+// Zwraca liczbę obsłużonych zdarzeń albo -1 przy błędzie epolla.
+static int worker_poll(Worker *w, int timeout) {
+    t_metrics = &w->metrics;
+    struct epoll_event events[64];
+    int nfds = epoll_wait(w->epfd, events, 64, timeout);
+    if(nfds==-1){
+        if(errno==EINTR) return 0;
+        perror("epoll_wait");
+        return -1;
+    }
+    // Obsługa zdarzeń
+    for(int i=0;i<nfds;i++){
+        if(events[i].data.fd==w->listen_fd){
+            // Nowe połączenia - wszystkie czekające naraz
+            accept_clients(w);
+        } else if(events[i].data.fd==w->admin_fd){
+            // Zapytanie o metryki
+            int admin_fd=accept4(w->admin_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(admin_fd==-1) continue;
+            admit_admin(w, admin_fd);
+        } else if(events[i].data.fd==w->wake_fd){
+            drain_inbox(w);
+        } else if(events[i].data.fd==w->wheel.tfd){
+            // Zegary pokoi: start gry, koniec rundy, ranking końcowy
+            timer_wheel_run(&w->wheel);
+        } else {
+            int cfd=events[i].data.fd;
+            Connection *c=(cfd<w->connCap) ? w->conns[cfd] : NULL;
+            if(!c) continue;
+            // Gniazdo znów przyjmuje dane -> dosyłamy zaległą kolejkę
+            if(events[i].events & EPOLLOUT){
+                if(conn_on_writable(c)<0){
+                    drop_connection(w, c);
+                    continue;
                 }
             }
-            if(found>=0){
-                countTemp[found]++;
-            } else if(used<MAX_ANSWERS_TEMP){
-                answersTemp[used] = strdup(p->response);
-                countTemp[used] = 1;
-                used++;
+            // Dane od istniejącego klienta
+            if(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)){
+                handle_client_data(w, c);
             }
         }
-        p=p->next;
-    }
-
-    // Przydzielamy punkty (m.in. za unikalność i szybkość)
-    p=playersHead;
-    while (p) {
-        int finalPoints = 0;
-        if(p->fd>0 && p->in_game==1 && p->response) {
-            if(is_in_database(current_round, p->response)) {
-                // Odpowiedź w bazie -> sprawdzamy unikalność
-                int foundIndex=-1;
-                for(int i=0; i<used; i++){
-                    if(strcase_compare(answersTemp[i], p->response)==0){
-                        foundIndex=i;
-                        break;
-                    }
-                }
-                if(foundIndex>=0){
-                    int howMany = countTemp[foundIndex];
-                    // Jeżeli więcej niż 1 gracz podał taką samą poprawną -> 5pkt, w przeciwnym razie 10
-                    if(howMany>1){
-                        finalPoints = 5;
-                    } else {
-                        finalPoints = 10;
-                    }
-
-                    // Punkty za szybkość (przedział 0-10)
-                    double playerElapsed = p->answerTime;
-                    if(playerElapsed<0) playerElapsed = (double)g_time_limit;
-                    if(playerElapsed>g_time_limit) playerElapsed = g_time_limit;
-
-                    double delta = (double)g_time_limit / 10.0;
-                    double playerTimeLeft = (double)g_time_limit - playerElapsed;
-                    int speedPoints=0;
-                    // Sprawdzamy progi co 'delta'
-                    for(int i=0; i<10; i++){
-                        double cutoff = (double)g_time_limit - (i*delta);
-                        if(playerTimeLeft >= (cutoff - delta + 0.000001)){
-                            speedPoints = 10 - i;
-                            break;
-                        }
-                    }
-                    finalPoints += speedPoints;
-                }
+    }
+
+    // Jedna zbiorcza wysyłka na połączenie za całą iterację
+    conn_flush_all(drop_connection_cb, w);
+    if (g_capture_fd >= 0) capture_flush();
+    return nfds;
+}
+
+// io_uring: obsługa jednego zakończenia z pierścienia wątku
+static void handle_completion(Worker *w, uint64_t tag, int res, unsigned flags) {
+    int kind = io_tag_kind(tag);
+    if (kind <= IO_TAG_TIMER) {
+        if (kind == IO_TAG_ACCEPT && res >= 0) {
+            // SO_KEEPALIVE przyjęte gniazdo dziedziczy po nasłuchującym
+            offer_client(w, res, monotonic_real_ns());
+        } else if (kind == IO_TAG_ACCEPT && (res == -EMFILE || res == -ENFILE)) {
+            while (shed_connection(w) == 0) {
             }
+        } else if (kind == IO_TAG_ADMIN && res >= 0) {
+            admit_admin(w, res);
+        } else if (kind == IO_TAG_WAKE) {
+            drain_inbox(w);
+        } else if (kind == IO_TAG_TIMER) {
+            timer_wheel_run(&w->wheel);
+        }
+        if (!(flags & IORING_CQE_F_MORE) && arm_worker_source(w, kind) != 0) perror("io_uring");
+        return;
+    }
+
+    int fd = io_tag_fd(tag);
+    Connection *c = (fd >= 0 && fd < w->connCap) ? w->conns[fd] : NULL;
+    // Spóźnione zakończenie poprzedniego uzbrojenia (albo poprzedniego właściciela deskryptora)
+    if (c && c->ioGen != io_tag_gen(tag)) c = NULL;
+
+    if (kind == IO_TAG_RECV) {
+        if (flags & IORING_CQE_F_BUFFER) {
+            unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+            if (c && res > 0) handle_client_recv(w, c, uring_buffer(&w->ring, bid), (size_t)res);
+            uring_buffer_return(&w->ring, bid);
+            return;
+        }
+        if (!c) return;
+        if (res == 0 || (res < 0 && res != -ENOBUFS)) {
+            // Rozłączenie albo błąd (-ECANCELED tylko po odwołaniu, a wtedy numer uzbrojenia już inny)
+            if (c->captureId) capture_event(CAPTURE_CLOSE, w->index, c->captureId, NULL, 0);
+            drop_connection(w, c);
+        } else if (!(flags & IORING_CQE_F_MORE)) {
+            // Zabrakło buforów - są już oddane, odbiór startuje od nowa
+            conn_rearm_recv(c);
         }
-        p->lastPoints = finalPoints;
-        p->score += finalPoints;
-        p = p->next;
+    } else if (kind == IO_TAG_READABLE) {
+        if (c && res >= 0) handle_client_data(w, c);
+    } else if (kind == IO_TAG_WRITABLE) {
+        if (c && c->wantWrite && conn_on_writable(c) < 0) drop_connection(w, c);
     }
+}
 
-    // Sprzątamy skopiowane odpowiedzi
-    for(int i=0; i<used; i++){
-        free(answersTemp[i]);
+// Jedna iteracja pętli wątku na io_uring: wysłanie zgłoszeń z poprzedniej iteracji, czekanie
+// na co najmniej jedno zakończenie, obsługa wszystkich gotowych i zbiorcza wysyłka.
+static int worker_poll_uring(Worker *w) {
+    t_metrics = &w->metrics;
+    if (uring_submit(&w->ring, 1) != 0) {
+        if (errno == EINTR) return 0;
+        perror("io_uring_enter");
+        return -1;
+    }
+    int handled = 0;
+    struct io_uring_cqe *cqe;
+    while ((cqe = uring_peek(&w->ring)) != NULL) {
+        uint64_t tag = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        uring_seen(&w->ring);
+        handle_completion(w, tag, res, flags);
+        handled++;
     }
+    conn_flush_all(drop_connection_cb, w);
+    if (g_capture_fd >= 0) capture_flush();
+    return handled;
+}
+
+// Pętla główna wątku reaktora
+static void *worker_loop(void *arg) {
+    Worker *w = (Worker *)arg;
+    if (w->uring) {
+        conn_use_uring(&w->ring, &w->sendRing);
+        while (worker_poll_uring(w) >= 0) {
+        }
+        return NULL;
+    }
+    // epoll_wait bez limitu czasu - terminy pokoi budzą wątek przez timerfd
+    while (worker_poll(w, -1) >= 0) {
+    }
+    return NULL;
+}
 
-    // Wysyłamy ranking
-    send_sorted_ranking();
+// Odtwarzanie zapisu zdarzeń (quiz-server --replay <plik> [--realtime]). Wszystkie wątki reaktora
+// działają w wątku głównym, klientów zastępują pary gniazd (socketpair), a zegar gry jest wirtualny:
+// przeskakuje do czasu kolejnego zdarzenia albo terminu zegara pokoju. Bez --realtime nic nie czeka,
+// więc end_round() i rozsyłanie dostają prawdziwy ruch tak szybko, jak nadążają - czas ich obsługi
+// mierzą zwykłe metryki (zegar systemowy), wypisywane na końcu.
+typedef struct Replay {
+    CaptureLog log;
+    int *peers;                // numer połączenia z zapisu -> gniazdo klienta (-1 = brak)
+    int epfd;                  // epoll gniazd klientów (odbiór tego, co wysłał serwer)
+    int realtime;
+    uint64_t now;              // bieżący czas zegara gry (ns)
+    uint64_t startNs;          // czas pierwszego zdarzenia
+    uint64_t startReal;        // kiedy zaczęło się odtwarzanie (zegar systemowy)
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    uint64_t timers;
+    uint64_t skipped;          // zdarzenia połączeń zamkniętych już przez serwer
+} Replay;
+
+// W trybie --realtime czeka, aż od startu minie tyle, ile w zapisie
+static void replay_wait(Replay *r, uint64_t ns) {
+    if (!r->realtime) return;
+    uint64_t due = r->startReal + (ns - r->startNs);
+    uint64_t now = monotonic_real_ns();
+    if (due <= now) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)((due - now) / 1000000000ull);
+    ts.tv_nsec = (long)((due - now) % 1000000000ull);
+    nanosleep(&ts, NULL);
+}
 
-    // Blokujemy okienka w kliencie i zerujemy time_left
-    send_to_all("IN_GAME=0\n");
-    send_to_all("TIME_LEFT=0\n");
+static void replay_set_clock(Replay *r, uint64_t ns) {
+    if (ns <= r->now) return;
+    r->now = ns;
+    clock_set_virtual(ns);
+}
 
-    // Reset state'u na kolejną rundę
-    p=playersHead;
-    while(p){
-        if(p->fd>0){
-            p->answered=0;
-            p->in_game=1;
-            if(p->response){
-                free(p->response);
-                p->response=NULL;
+// Odbiera to, co serwer wysłał klientom; gniazda zamknięte przez serwer zamyka. Zwraca liczbę zdarzeń.
+static int replay_drain_peers(Replay *r) {
+    static char sink[65536];
+    struct epoll_event events[256];
+    int n = epoll_wait(r->epfd, events, 256, 0);
+    for (int i = 0; i < n; i++) {
+        uint32_t id = events[i].data.u32;
+        int fd = r->peers[id];
+        if (fd < 0) continue;
+        for (;;) {
+            ssize_t got = recv(fd, sink, sizeof(sink), 0);
+            if (got > 0) {
+                r->bytesOut += (uint64_t)got;
+                continue;
             }
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            close(fd);
+            r->peers[id] = -1;
+            break;
         }
-        p=p->next;
     }
+    return n > 0 ? n : 0;
+}
 
-    current_round++;
-    if(current_round<g_max_rounds){
-        start_round();
-    } else {
-        // Ostatnie pytanie -> koniec gry i czekamy 20s
-        send_to_all("Koniec pytań, za 20 sekund ruszy nowa gra / koniec.\n");
-        showing_final_ranking = 1;
-        final_ranking_start = time(NULL);
-        round_in_progress=0;
-    }
+// Obsługuje wszystko, co wynikło z ostatniego zdarzenia: dane w gniazdach, przekazania między wątkami,
+// wysyłkę i odbiór u klientów - aż nic się nie dzieje
+static void replay_settle(Replay *r) {
+    int busy;
+    do {
+        busy = 0;
+        for (int i = 0; i < workerCount; i++) {
+            int n = worker_poll(&workers[i], 0);
+            if (n > 0) busy += n;
+        }
+        busy += replay_drain_peers(r);
+    } while (busy > 0);
 }
 
-// Obsługa danych od klienta (przyjście pseudonimu lub odpowiedzi)
-void handle_client_data(int fd) {
-    char buffer[BUFFER_SIZE];
-    int read_size=recv(fd, buffer, sizeof(buffer)-1,0);
+// Odpala zegary pokoi z terminem do 'until' (ns), każdy z zegarem gry ustawionym na swój termin
+static void replay_timers(Replay *r, uint64_t until) {
+    for (;;) {
+        Worker *w = NULL;
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < workerCount; i++) {
+            uint64_t next = timer_wheel_next(&workers[i].wheel);
+            if (next < best) {
+                best = next;
+                w = &workers[i];
+            }
+        }
+        if (!w || best * 1000000ull > until) return;
+        replay_wait(r, best * 1000000ull);
+        replay_set_clock(r, best * 1000000ull);
+        t_metrics = &w->metrics;
+        timer_wheel_run(&w->wheel);
+        conn_flush_all(drop_connection_cb, w);
+        r->timers++;
+        replay_settle(r);
+    }
+}
 
-    if(read_size<=0){
-        // Błąd/rozłączenie
-        remove_player(fd);
-        fprintf(stderr,"DEBUG: Rozłączono gracza fd=%d, active_players=%d\n",fd, active_players);
+// Zdarzenie z zapisu: nowe połączenie, bajty od klienta albo rozłączenie
+static void replay_event(Replay *r, const CaptureEvent *e) {
+    if (e->type == CAPTURE_ACCEPT) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv) != 0) {
+            perror("socketpair");
+            r->skipped++;
+            return;
+        }
+        Worker *w = &workers[e->worker];
+        t_metrics = &w->metrics;
+        Connection *c = admit_client(w, sv[0]);
+        if (!c) {
+            close(sv[1]);
+            r->skipped++;
+            return;
+        }
+        c->captureId = e->conn;
+        conn_flush_all(drop_connection_cb, w);
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = e->conn;
+        epoll_ctl(r->epfd, EPOLL_CTL_ADD, sv[1], &ev);
+        r->peers[e->conn] = sv[1];
         return;
     }
+    if (e->type == CAPTURE_TOKEN) return; // wydaje je game_room (capture_replay_token)
+    int fd = r->peers[e->conn];
+    if (fd < 0) {
+        r->skipped++;
+        return;
+    }
+    if (e->type == CAPTURE_CLOSE) {
+        close(fd);
+        r->peers[e->conn] = -1;
+        return;
+    }
+    size_t off = 0;
+    while (off < e->len) {
+        ssize_t n = send(fd, e->data + off, e->len - off, MSG_NOSIGNAL);
+        if (n > 0) {
+            off += (size_t)n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            // Serwer jeszcze nie odebrał poprzednich danych
+            replay_settle(r);
+        } else {
+            r->skipped++;
+            return;
+        }
+    }
+    r->bytesIn += e->len;
+}
 
-    buffer[read_size]='\0';
-    // Usuwamy ewentualne '\n'
-    if(buffer[read_size-1]=='\n'){
-        buffer[read_size-1]='\0';
+static void replay_cleanup(Replay *r) {
+    if (r->peers) {
+        for (uint32_t id = 0; id <= r->log.maxConn; id++) {
+            if (r->peers[id] >= 0) close(r->peers[id]);
+        }
+    }
+    free(r->peers);
+    if (r->epfd != -1) close(r->epfd);
+    if (workers) {
+        for (int i = 0; i < workerCount; i++) worker_cleanup(&workers[i]);
+        free(workers);
+        workers = NULL;
     }
+    capture_replay_tokens(NULL);
+    capture_log_free(&r->log);
+    clock_set_virtual(0);
+}
 
-    Player *p=find_player_by_fd(fd);
-    if(!p) return;
+// Odtwarza zapis i wypisuje metryki (stdout). Konfiguracja (config.ini) powinna być ta sama, co przy zapisie.
+static int run_replay(const char *path, int realtime) {
+    Replay r;
+    memset(&r, 0, sizeof(r));
+    r.epfd = -1;
+    r.realtime = realtime;
+    if (capture_load(path, &r.log) != 0) return -1;
+    if (r.log.count == 0) {
+        fprintf(stderr, "%s: zapis nie zawiera zdarzeń\n", path);
+        replay_cleanup(&r);
+        return -1;
+    }
 
-    // Jeśli nie ustalono pseudonimu, to wybieramy inny
-    if(!p->got_name){
-        if(is_name_taken(buffer)){
-            const char *taken_msg="Pseudonim zajęty, wybierz inny.\n";
-            send(fd, taken_msg, strlen(taken_msg),0);
-            return;
+    // Dwa deskryptory na połączenie
+    raise_fd_limit();
+    r.peers = (int *)malloc(((size_t)r.log.maxConn + 1) * sizeof(int));
+    r.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!r.peers || r.epfd == -1 || capture_replay_tokens(&r.log) != 0) {
+        fprintf(stderr, "Błąd przygotowania odtwarzania.\n");
+        replay_cleanup(&r);
+        return -1;
+    }
+    for (uint32_t id = 0; id <= r.log.maxConn; id++) r.peers[id] = -1;
+
+    // Zegar gry od chwili pierwszego zdarzenia (koła zegarów liczą od bieżącej chwili)
+    r.startNs = r.log.events[0].ns;
+    r.now = r.startNs;
+    clock_set_virtual(r.now);
+    workerCount = r.log.workers;
+    workers = (Worker *)calloc(workerCount, sizeof(Worker));
+    if (!workers) {
+        fprintf(stderr, "Błąd alokacji pamięci dla wątków.\n");
+        replay_cleanup(&r);
+        return -1;
+    }
+    for (int i = 0; i < workerCount; i++) {
+        if (worker_init(&workers[i], i, 0) != 0) {
+            workerCount = i + 1;
+            replay_cleanup(&r);
+            return -1;
         }
-        p->name=strdup(buffer);
-        p->got_name=1;
-        p->score=0;
-        p->answered=0;
-        p->in_game=0; // poczeka do next rundy
-        const char *ok_msg="Zalogowano pomyślnie!\n";
-        send(fd, ok_msg, strlen(ok_msg),0);
-
-        fprintf(stderr,"DEBUG: Zalogował się %s(fd=%d), active_players=%d\n",
-                p->name, fd, active_players);
-
-        // Jeżeli to pierwszy gracz -> czekamy 20s, żeby inni mogli dołączyć
-        if(active_players==1 && current_round<g_max_rounds && !round_in_progress){
-            send_to_all("Pierwszy gracz dołączył! Za 20 sekund start rozgrywki...\n");
-            waiting_for_first_player=1;
-            first_player_wait_start=time(NULL);
-        }
-
-        // Jeśli runda w trakcie -> nowy gracz dostaje pytanie + time_left, ale IN_GAME=0
-        if(round_in_progress && strlen(current_question)>0){
-            send(fd, current_question, strlen(current_question),0);
-            time_t now=time(NULL);
-            double elapsed=difftime(now, round_start_time);
-            int remaining=g_time_limit-(int)elapsed;
-            if(remaining<0) remaining=0;
-            char msg[64];
-            snprintf(msg,sizeof(msg),"TIME_LEFT=%d\n", remaining);
-            send(fd,msg,strlen(msg),0);
+    }
+    if (!create_room(&workers[0])) {
+        fprintf(stderr, "Błąd alokacji pamięci dla pokoju domyślnego.\n");
+        replay_cleanup(&r);
+        return -1;
+    }
 
-            const char *block_info="IN_GAME=0\n";
-            send(fd, block_info, strlen(block_info),0);
+    r.startReal = monotonic_real_ns();
+    for (size_t i = 0; i < r.log.count; i++) {
+        const CaptureEvent *e = &r.log.events[i];
+        replay_timers(&r, e->ns);
+        replay_wait(&r, e->ns);
+        replay_set_clock(&r, e->ns);
+        replay_event(&r, e);
+        replay_settle(&r);
+    }
+    double elapsed = (double)(monotonic_real_ns() - r.startReal) / 1e9;
+    double span = (double)(r.now - r.startNs) / 1e9;
+
+    // Zaległe wpisy dziennika przed podsumowaniem
+    logger_stop();
+    fprintf(stderr, "Odtworzono %zu zdarzeń (%u połączeń, wątki: %d, %.1f s zapisu) w %.3f s: %.0f zdarzeń/s, "
+            "zegary pokoi: %llu, bajty do serwera: %llu, od serwera: %llu, pominięte: %llu\n",
+            r.log.count, r.log.maxConn, workerCount, span, elapsed, elapsed > 0 ? r.log.count / elapsed : 0.0,
+            (unsigned long long)r.timers, (unsigned long long)r.bytesIn, (unsigned long long)r.bytesOut,
+            (unsigned long long)r.skipped);
+
+    Metrics *total = (Metrics *)calloc(1, sizeof(Metrics));
+    if (total) {
+        for (int i = 0; i < workerCount; i++) metrics_merge(total, &workers[i].metrics);
+        Frame *body = frame_alloc(8192);
+        if (body) body = metrics_format(body, total, workerCount);
+        if (body) {
+            fwrite(body->data, 1, body->len, stdout);
+            frame_unref(body);
         }
-        return;
+        free(total);
     }
+    replay_cleanup(&r);
+    return 0;
+}
 
-    // W przeciwnym razie -> to jest odpowiedź gracza
-    if(p->answered==0 && p->in_game==1){
-        if(p->response) free(p->response);
-        p->response=strdup(buffer);
-        p->answered=1;
-        p->answerTime = difftime(time(NULL), round_start_time);
-
-        fprintf(stderr,"DEBUG: Gracz %s odpowiedział: %s\n", p->name, p->response);
+// Wątek przeładowania bazy: SIGHUP buduje nową migawkę poza wątkami reaktora.
+// Pokoje przełączają się na nią przy starcie kolejnej rundy, połączenia i gry trwają dalej.
+static void *reload_loop(void *arg) {
+    sigset_t *set = (sigset_t *)arg;
+    for (;;) {
+        int sig;
+        if (sigwait(set, &sig) != 0) continue;
+        if (sig == SIGHUP) reload_question_bank("config.ini");
     }
+    return NULL;
 }
 
-int main(){
+int main(int argc, char **argv){
+    const char *replayPath = NULL;
+    int realtime = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = 1;
+        } else {
+            fprintf(stderr, "Użycie: %s [--replay <plik zapisu> [--realtime]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Zapis do zerwanego połączenia ma zwrócić EPIPE, a nie zabić serwer
+    signal(SIGPIPE, SIG_IGN);
+
+    // SIGHUP blokujemy we wszystkich wątkach (maska jest dziedziczona) - odbiera go tylko wątek przeładowania
+    static sigset_t reloadSignals;
+    sigemptyset(&reloadSignals);
+    sigaddset(&reloadSignals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &reloadSignals, NULL);
+
     // Wczytujemy parametry TIME_LIMIT, MAX_ROUNDS
     if (load_config("config.ini", &g_time_limit, &g_max_rounds) != 0) {
         return 1;
@@ -595,193 +1339,97 @@ int main(){
         return 1;
     }
 
-    int server_socket;
-    struct sockaddr_in server_addr;
+    // Wątek dziennika: pętle zdarzeń tylko wkładają wpisy do pierścieni (bez niego wpisy przepadają)
+    if (logger_start() != 0) {
+        fprintf(stderr, "Dziennik zdarzeń wyłączony.\n");
+    }
 
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket == -1) {
-        perror("socket");
+    if (replayPath) {
+        int rc = run_replay(replayPath, realtime);
+        logger_stop();
         free_resources();
-        return 1;
+        return rc == 0 ? 0 : 1;
     }
 
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    // Ustawiamy keepalive (obsługa zerwań łącza w sieciach WAN)
-    int keepAlive=1;
-    setsockopt(server_socket, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive));
-
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(PORT);
-
-    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        perror("bind");
-        close(server_socket);
+    if (check_port_free() != 0) {
+        logger_stop();
         free_resources();
         return 1;
     }
-    if (listen(server_socket, 5) < 0) {
-        perror("listen");
-        close(server_socket);
+
+    raise_fd_limit();
+    workerCount = g_worker_threads;
+    if (workerCount <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = cores > 0 ? (int)cores : 1;
+    }
+    workers = (Worker *)calloc(workerCount, sizeof(Worker));
+    if (!workers) {
+        fprintf(stderr, "Błąd alokacji pamięci dla wątków.\n");
+        logger_stop();
         free_resources();
         return 1;
     }
 
-    // Tworzymy epoll
-    int epfd = epoll_create1(0);
-    if (epfd == -1) {
-        perror("epoll_create1");
-        close(server_socket);
-        free_resources();
-        return 1;
+    for (int i = 0; i < workerCount; i++) {
+        if (worker_init(&workers[i], i, 1) != 0) {
+            for (int j = 0; j <= i; j++) worker_cleanup(&workers[j]);
+            free(workers);
+            logger_stop();
+            free_resources();
+            return 1;
+        }
     }
-    set_nonblock(server_socket);
 
-    struct epoll_event ev;
-    ev.events = EPOLLIN;
-    ev.data.fd = server_socket;
-    if (epoll_ctl(epfd, EPOLL_CTL_ADD, server_socket, &ev) == -1) {
-        perror("epoll_ctl");
-        close(server_socket);
-        close(epfd);
+    // Pokój domyślny 0 (wątek 0) - do niego trafiają klienci, którzy od razu podają pseudonim
+    if (!create_room(&workers[0])) {
+        fprintf(stderr, "Błąd alokacji pamięci dla pokoju domyślnego.\n");
+        for (int i = 0; i < workerCount; i++) worker_cleanup(&workers[i]);
+        free(workers);
+        logger_stop();
         free_resources();
         return 1;
     }
 
-    fprintf(stderr, "Serwer działa na porcie %d. Oczekiwanie na graczy...\n", PORT);
+    if (g_capture_path[0] && capture_open(g_capture_path, workerCount) != 0) {
+        fprintf(stderr, "Zapis zdarzeń wyłączony.\n");
+    }
 
-    // Pętla główna
-    while(1){
-        time_t now = time(NULL);
+    // Profile graczy: odtworzenie dziennika i wątek zapisu (bez dziennika serwer działa bez profili)
+    if (g_profile_log_path[0] && profile_log_open(g_profile_log_path) != 0) {
+        fprintf(stderr, "Profile graczy wyłączone.\n");
+    }
 
-        // Czekamy 20 s na start, jeśli dopiero dołączył pierwszy gracz
-        if(waiting_for_first_player==1){
-            double diff = difftime(now, first_player_wait_start);
-            if(diff >= 20.0){
-                waiting_for_first_player=0;
-                if(active_players>0 && !round_in_progress && current_round<g_max_rounds){
-                    start_round();
-                }
-            }
-        }
+    fprintf(stderr, "Serwer działa na porcie %d (wątki: %d). Oczekiwanie na graczy...\n", PORT, workerCount);
 
-        // Jeżeli pokazujemy końcowy ranking przez 20s
-        if(showing_final_ranking==1){
-            double diff = difftime(now, final_ranking_start);
-            if(diff >= 20.0){
-                showing_final_ranking=0;
-                if(active_players>0){
-                    // Reset punktów, start nowej gry
-                    Player *tmp = playersHead;
-                    while(tmp){
-                        tmp->score = 0;
-                        tmp->answered = 0;
-                        if(tmp->response){
-                            free(tmp->response);
-                            tmp->response = NULL;
-                        }
-                        tmp->in_game = 0;
-                        tmp = tmp->next;
-                    }
-                    send_to_all("Nowa gra rozpoczęta!\n");
-                    current_round = 0;
-                    start_round();
-                } else {
-                    send_to_all("Gra zakończona! Dzięki za grę!\n");
-                }
-            }
-        }
+    pthread_t reloadThread;
+    if (pthread_create(&reloadThread, NULL, reload_loop, &reloadSignals) == 0) {
+        pthread_detach(reloadThread);
+    } else {
+        perror("pthread_create");
+    }
 
-        // epoll_wait do obsługi nowo przychodzących połączeń/danych (timeout 5000ms)
-        struct epoll_event events[64];
-        int nfds = epoll_wait(epfd, events, 64, 5000);
-        if(nfds==-1){
-            perror("epoll_wait");
+    int started = 0;
+    for (int i = 1; i < workerCount; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_loop, &workers[i]) != 0) {
+            perror("pthread_create");
             break;
         }
-        // Obsługa zdarzeń
-        for(int i=0;i<nfds;i++){
-            if(events[i].data.fd==server_socket){
-                // Nowe połączenie
-                struct sockaddr_in client_addr;
-                socklen_t addr_len=sizeof(client_addr);
-                int client_fd=accept(server_socket,(struct sockaddr*)&client_addr,&addr_len);
-                if(client_fd==-1){
-                    perror("accept");
-                    continue;
-                }
-                set_nonblock(client_fd);
-
-                // Keepalive dla klienta
-                int keepC=1;
-                setsockopt(client_fd, SOL_SOCKET, SO_KEEPALIVE, &keepC, sizeof(keepC));
-
-                struct epoll_event client_ev;
-                client_ev.events=EPOLLIN;
-                client_ev.data.fd=client_fd;
-                if(epoll_ctl(epfd, EPOLL_CTL_ADD, client_fd, &client_ev)==-1){
-                    perror("epoll_ctl");
-                    close(client_fd);
-                    continue;
-                }
-
-                add_player(client_fd);
-                const char *ask_name="Podaj swój pseudonim:\n";
-                send(client_fd, ask_name, strlen(ask_name),0);
-
-            } else {
-                // Dane od istniejącego klienta
-                int cfd=events[i].data.fd;
-                handle_client_data(cfd);
-            }
-        }
-
-        // Jeżeli trwa runda -> sprawdzamy warunki jej zakończenia
-        if (round_in_progress) {
-            now = time(NULL);
-            // Upłynął czas?
-            if (difftime(now, round_start_time) >= g_time_limit) {
-                end_round();
-            } else {
-                // Czy co najmniej połowa odpowiedziała?
-                int total_in_game = 0, answered_count = 0;
-                Player *p = playersHead;
-                while (p) {
-                    if (p->in_game == 1){
-                        total_in_game++;
-                        if (p->answered == 1){
-                            answered_count++;
-                        }
-                    }
-                    p = p->next;
-                }
-
-                int required_answers;
-                // Zaokrąglamy w górę: (total_in_game+1)/2
-                if (total_in_game % 2 == 0) {
-                    required_answers = (total_in_game / 2) + 1;
-                } else {
-                    required_answers = (total_in_game + 1) / 2;
-                }
-
-                if (answered_count >= required_answers) {
-                    end_round();
-                }
-            }
-        }
+        started = i;
+    }
+    // Wątek główny obsługuje wątek 0
+    worker_loop(&workers[0]);
 
-        // Jeżeli przekroczyliśmy max_rounds i nie pokazujemy rankingu => koniec
-        if(current_round>=g_max_rounds && showing_final_ranking==0){
-            break;
-        }
+    for (int i = 1; i <= started; i++) {
+        pthread_join(workers[i].thread, NULL);
     }
 
     // Sprzątanie - zamykamy wszystkie gniazda, epoll i zasoby
-    close_all_sockets();
-    close(server_socket);
-    close(epfd);
+    for (int i = 0; i < workerCount; i++) worker_cleanup(&workers[i]);
+    free(workers);
+    profile_log_close();
+    capture_close();
+    logger_stop();
     free_resources();
     return 0;
 }
@@ -0,0 +1,166 @@
+#include "session.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/random.h>
+
+#include "answer_index.h"
+
+int session_new_token(uint64_t token[2]) {
+    char *p = (char *)token;
+    size_t got = 0;
+    while (got < 16) {
+        ssize_t n = getrandom(p + got, 16 - got, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("getrandom");
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+void session_format_token(const uint64_t token[2], int roomId, char *out, size_t cap) {
+    snprintf(out, cap, "%d-%016llx%016llx", roomId, (unsigned long long)token[0], (unsigned long long)token[1]);
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int session_parse_token(const char *text, int *roomId, uint64_t token[2]) {
+    const char *s = text;
+    long id = 0;
+    if (*s < '0' || *s > '9') return -1;
+    while (*s >= '0' && *s <= '9') {
+        id = id * 10 + (*s++ - '0');
+        if (id > 0x7FFFFFFF) return -1;
+    }
+    if (*s++ != '-') return -1;
+    for (int half = 0; half < 2; half++) {
+        uint64_t v = 0;
+        for (int i = 0; i < 16; i++) {
+            int d = hex_digit(*s++);
+            if (d < 0) return -1;
+            v = (v << 4) | (uint64_t)d;
+        }
+        token[half] = v;
+    }
+    if (*s != '\0') return -1;
+    *roomId = (int)id;
+    return 0;
+}
+
+// Token jest losowy, więc jego młodsze bity wystarczą jako hash
+static uint32_t token_bucket(const SessionTable *t, const uint64_t token[2]) {
+    return (uint32_t)token[0] & (t->capacity - 1);
+}
+
+static uint32_t name_bucket(const SessionTable *t, const char *name) {
+    return answer_hash(name, strlen(name)) & (t->capacity - 1);
+}
+
+// Podwaja liczbę kubełków i przepina wszystkie sesje
+static int grow(SessionTable *t) {
+    uint32_t oldCap = t->capacity;
+    uint32_t newCap = oldCap ? oldCap * 2 : 16;
+    Session **byToken = (Session **)calloc(newCap, sizeof(Session *));
+    Session **byName = (Session **)calloc(newCap, sizeof(Session *));
+    if (!byToken || !byName) {
+        free(byToken);
+        free(byName);
+        return -1;
+    }
+    Session **oldToken = t->byToken;
+    free(t->byName);
+    t->byToken = byToken;
+    t->byName = byName;
+    t->capacity = newCap;
+    for (uint32_t i = 0; i < oldCap; i++) {
+        Session *s = oldToken[i];
+        while (s) {
+            Session *next = s->nextByToken;
+            uint32_t b = token_bucket(t, s->token);
+            s->nextByToken = t->byToken[b];
+            t->byToken[b] = s;
+            b = name_bucket(t, s->name);
+            s->nextByName = t->byName[b];
+            t->byName[b] = s;
+            s = next;
+        }
+    }
+    free(oldToken);
+    return 0;
+}
+
+Session *session_add(SessionTable *t, const uint64_t token[2], const char *name) {
+    if ((uint32_t)t->count >= t->capacity && grow(t) != 0) return NULL;
+    Session *s = (Session *)calloc(1, sizeof(Session));
+    if (!s) return NULL;
+    s->name = strdup(name);
+    if (!s->name) {
+        free(s);
+        return NULL;
+    }
+    s->token[0] = token[0];
+    s->token[1] = token[1];
+
+    uint32_t b = token_bucket(t, token);
+    s->nextByToken = t->byToken[b];
+    t->byToken[b] = s;
+    b = name_bucket(t, name);
+    s->nextByName = t->byName[b];
+    t->byName[b] = s;
+    t->count++;
+    return s;
+}
+
+Session *session_find(const SessionTable *t, const uint64_t token[2]) {
+    if (t->count == 0) return NULL;
+    for (Session *s = t->byToken[token_bucket(t, token)]; s; s = s->nextByToken) {
+        if (s->token[0] == token[0] && s->token[1] == token[1]) return s;
+    }
+    return NULL;
+}
+
+int session_name_taken(const SessionTable *t, const char *name) {
+    if (t->count == 0) return 0;
+    for (Session *s = t->byName[name_bucket(t, name)]; s; s = s->nextByName) {
+        if (strcmp(s->name, name) == 0) return 1;
+    }
+    return 0;
+}
+
+void session_remove(SessionTable *t, Session *s) {
+    Session **pp = &t->byToken[token_bucket(t, s->token)];
+    while (*pp != s) pp = &(*pp)->nextByToken;
+    *pp = s->nextByToken;
+    pp = &t->byName[name_bucket(t, s->name)];
+    while (*pp != s) pp = &(*pp)->nextByName;
+    *pp = s->nextByName;
+    t->count--;
+    free(s->name);
+    free(s);
+}
+
+void session_table_free(SessionTable *t, void (*release)(Session *s, void *arg), void *arg) {
+    for (uint32_t i = 0; i < t->capacity; i++) {
+        Session *s = t->byToken[i];
+        while (s) {
+            Session *next = s->nextByToken;
+            if (release) release(s, arg);
+            free(s->name);
+            free(s);
+            s = next;
+        }
+    }
+    free(t->byToken);
+    free(t->byName);
+    memset(t, 0, sizeof(*t));
+}
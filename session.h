@@ -0,0 +1,53 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "timer_wheel.h"
+
+struct GameRoom;
+
+// Token wznowienia sesji: 128 losowych bitów nadawanych przy logowaniu. Klient dostaje go jako
+// "<pokój>-<32 cyfry szesnastkowe>" - numer pokoju pozwala lobby przekazać RESUME= do właściwego wątku.
+#define SESSION_TOKEN_TEXT 48
+
+// Gracz, który zerwał połączenie: pseudonim i wynik czekają w pokoju na RESUME=<token> do upływu zegara
+typedef struct Session {
+    uint64_t token[2];
+    char *name;
+    int score;
+    int correct;                // stan gry w chwili zerwania (jak w Player)
+    int played;
+    unsigned game;              // numer gry pokoju, z której pochodzi wynik
+    Timer timer;                // koniec okresu karencji
+    struct GameRoom *room;
+    struct Session *nextByToken;
+    struct Session *nextByName;
+} Session;
+
+// Sesje pokoju z dwoma indeksami (listy łańcuchowe): token -> sesja i pseudonim -> sesja
+typedef struct SessionTable {
+    Session **byToken;
+    Session **byName;
+    uint32_t capacity;          // potęga dwójki (liczba kubełków każdego indeksu)
+    int count;
+} SessionTable;
+
+// Losuje nowy token. Zwraca 0 albo -1 (brak źródła losowości).
+int session_new_token(uint64_t token[2]);
+void session_format_token(const uint64_t token[2], int roomId, char *out, size_t cap);
+// Rozbiera "<pokój>-<hex>". Zwraca 0 albo -1 przy błędnym formacie.
+int session_parse_token(const char *text, int *roomId, uint64_t token[2]);
+
+// Dodaje sesję z kopią pseudonimu (zegar wypełnia wywołujący). NULL przy błędzie alokacji.
+Session *session_add(SessionTable *t, const uint64_t token[2], const char *name);
+Session *session_find(const SessionTable *t, const uint64_t token[2]);
+int session_name_taken(const SessionTable *t, const char *name);
+// Usuwa i zwalnia sesję (zegar musi być już odwołany)
+void session_remove(SessionTable *t, Session *s);
+
+// Zwalnia wszystkie sesje; 'release' (może być NULL) dostaje każdą przed zwolnieniem
+void session_table_free(SessionTable *t, void (*release)(Session *s, void *arg), void *arg);
+
+#endif
@@ -0,0 +1,192 @@
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#include "metrics.h"
+
+// Zegar wirtualny odtwarzania (0 = wyłączony)
+static uint64_t virtualNs = 0;
+
+uint64_t monotonic_real_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t monotonic_ns() {
+    return virtualNs ? virtualNs : monotonic_real_ns();
+}
+
+void clock_set_virtual(uint64_t ns) {
+    virtualNs = ns;
+}
+
+uint64_t monotonic_ms() {
+    return monotonic_ns() / 1000000ull;
+}
+
+static void link_timer(Timer *t, Timer **head) {
+    t->list = head;
+    t->prev = NULL;
+    t->next = *head;
+    if (*head) (*head)->prev = t;
+    *head = t;
+}
+
+static void unlink_timer(TimerWheel *tw, Timer *t) {
+    if (t->prev) t->prev->next = t->next;
+    else *t->list = t->next;
+    if (t->next) t->next->prev = t->prev;
+
+    // Pusty slot znika z mapy zajętości
+    if (t->list >= tw->slots && t->list < tw->slots + WHEEL_SLOTS && *t->list == NULL) {
+        size_t idx = (size_t)(t->list - tw->slots);
+        tw->occupied[idx / 64] &= ~(1ull << (idx % 64));
+    }
+    t->list = NULL;
+    t->prev = t->next = NULL;
+}
+
+static void insert_slot(TimerWheel *tw, Timer *t) {
+    size_t idx = (size_t)(t->expires & (WHEEL_SLOTS - 1));
+    link_timer(t, &tw->slots[idx]);
+    tw->occupied[idx / 64] |= 1ull << (idx % 64);
+}
+
+int timer_wheel_init(TimerWheel *tw) {
+    memset(tw, 0, sizeof(*tw));
+    tw->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tw->tfd == -1) return -1;
+    tw->now = monotonic_ms();
+    return 0;
+}
+
+void timer_wheel_destroy(TimerWheel *tw) {
+    if (tw->tfd != -1) close(tw->tfd);
+    tw->tfd = -1;
+}
+
+void timer_init(Timer *t, void (*fn)(void *arg), void *arg) {
+    memset(t, 0, sizeof(*t));
+    t->fn = fn;
+    t->arg = arg;
+}
+
+// Najbliższy termin: najpierw szukamy w bieżącym obrocie koła, w razie czego minimum po wszystkich
+static uint64_t next_expiry(TimerWheel *tw) {
+    if (tw->expired) return tw->now;
+    for (uint64_t d = 1; d <= WHEEL_SLOTS; d++) {
+        size_t idx = (size_t)((tw->now + d) & (WHEEL_SLOTS - 1));
+        uint64_t word = tw->occupied[idx / 64] >> (idx % 64);
+        if (word == 0) {
+            // Reszta tego słowa mapy jest pusta - przeskakujemy
+            d += 63 - (idx % 64);
+            continue;
+        }
+        if (!(word & 1)) continue;
+        for (Timer *t = tw->slots[idx]; t; t = t->next) {
+            if (t->expires <= tw->now + d) return tw->now + d;
+        }
+    }
+    uint64_t best = UINT64_MAX;
+    for (size_t i = 0; i < WHEEL_SLOTS; i++) {
+        for (Timer *t = tw->slots[i]; t; t = t->next) {
+            if (t->expires < best) best = t->expires;
+        }
+    }
+    return best;
+}
+
+uint64_t timer_wheel_next(TimerWheel *tw) {
+    return tw->count > 0 ? next_expiry(tw) : UINT64_MAX;
+}
+
+static void arm(TimerWheel *tw) {
+    uint64_t next = tw->count > 0 ? next_expiry(tw) : 0;
+    if (next == tw->armedAt) return;
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (next != 0) {
+        its.it_value.tv_sec = (time_t)(next / 1000);
+        its.it_value.tv_nsec = (long)(next % 1000) * 1000000L;
+    }
+    if (timerfd_settime(tw->tfd, TFD_TIMER_ABSTIME, &its, NULL) == -1) {
+        perror("timerfd_settime");
+        return;
+    }
+    tw->armedAt = next;
+}
+
+void timer_schedule(TimerWheel *tw, Timer *t, uint64_t expires_ms) {
+    if (t->list) {
+        unlink_timer(tw, t);
+        tw->count--;
+    }
+    // Puste koło może przeskoczyć do bieżącej chwili - nie ma czego przetwarzać po drodze
+    if (tw->count == 0 && !tw->expired) tw->now = monotonic_ms();
+
+    // next_expiry() szuka terminów od slotu tw->now+1, więc termin z przeszłości (albo bieżący)
+    // trafia do najbliższego slotu - inaczej czekałby pełny obrót koła
+    t->expires = expires_ms > tw->now ? expires_ms : tw->now + 1;
+    insert_slot(tw, t);
+    tw->count++;
+    arm(tw);
+}
+
+void timer_cancel(TimerWheel *tw, Timer *t) {
+    if (!t->list) return;
+    unlink_timer(tw, t);
+    tw->count--;
+    arm(tw);
+}
+
+// Przenosi z danego slotu do listy 'expired' zegary z terminem <= target
+static void collect_slot(TimerWheel *tw, size_t idx, uint64_t target) {
+    Timer *t = tw->slots[idx];
+    while (t) {
+        Timer *next = t->next;
+        if (t->expires <= target) {
+            unlink_timer(tw, t);
+            link_timer(t, &tw->expired);
+        }
+        t = next;
+    }
+}
+
+void timer_wheel_run(TimerWheel *tw) {
+    uint64_t ticks;
+    if (read(tw->tfd, &ticks, sizeof(ticks)) < 0) {
+        // EAGAIN - timerfd już odczytany albo przestawiony
+    }
+
+    uint64_t target = monotonic_ms();
+    if (target > tw->now) {
+        if (target - tw->now >= WHEEL_SLOTS) {
+            for (size_t i = 0; i < WHEEL_SLOTS; i++) collect_slot(tw, i, target);
+        } else {
+            for (uint64_t ms = tw->now + 1; ms <= target; ms++) {
+                size_t idx = (size_t)(ms & (WHEEL_SLOTS - 1));
+                if (tw->occupied[idx / 64] & (1ull << (idx % 64))) collect_slot(tw, idx, target);
+            }
+        }
+        tw->now = target;
+    }
+
+    // Wywołania mogą ustawiać i odwoływać zegary (także te z listy 'expired')
+    while (tw->expired) {
+        Timer *t = tw->expired;
+        unlink_timer(tw, t);
+        tw->count--;
+        // Spóźnienie względem terminu mówi, jak bardzo pętla zdarzeń jest zajęta
+        // (według zegara gry - przy odtwarzaniu zegary odpalają dokładnie w terminie)
+        uint64_t now = monotonic_ns(), due = t->expires * 1000000ull;
+        hist_record(&t_metrics->loopLag, now > due ? now - due : 0);
+        t->fn(t->arg);
+    }
+    arm(tw);
+}
@@ -0,0 +1,59 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+// Koło zegarów (hashed timing wheel) z rozdzielczością 1 ms, napędzane jednym timerfd na wątek.
+// timerfd jest uzbrajany dokładnie na najbliższy termin, więc bezczynny serwer w ogóle się nie budzi.
+#define WHEEL_SLOTS 1024   // 1 ms na slot, pełny obrót ~1 s (dalsze terminy czekają kolejne obroty)
+
+struct TimerWheel;
+
+typedef struct Timer {
+    uint64_t expires;           // termin (ms zegara monotonicznego)
+    void (*fn)(void *arg);
+    void *arg;
+    struct Timer **list;        // głowa listy, na której jest zegar (NULL = nieaktywny)
+    struct Timer *prev;
+    struct Timer *next;
+} Timer;
+
+typedef struct TimerWheel {
+    int tfd;                    // timerfd (CLOCK_MONOTONIC) - do epolla wątku
+    uint64_t now;               // do jakiej chwili (ms) koło zostało przetworzone
+    uint64_t armedAt;           // na kiedy uzbrojono timerfd (0 = rozbrojony)
+    int count;                  // liczba aktywnych zegarów
+    Timer *slots[WHEEL_SLOTS];
+    uint64_t occupied[WHEEL_SLOTS / 64]; // mapa niepustych slotów
+    Timer *expired;             // zegary do wywołania w bieżącym przebiegu
+} TimerWheel;
+
+// Zegar gry: monotoniczny systemowy albo - przy odtwarzaniu zapisu zdarzeń - wirtualny
+uint64_t monotonic_ns();
+uint64_t monotonic_ms();
+// Zegar systemowy także przy odtwarzaniu (pomiary czasu obsługi w metrykach)
+uint64_t monotonic_real_ns();
+// Zatrzymuje zegar gry na chwili 'ns' (0 = powrót do zegara systemowego). Tylko przy jednym wątku gry.
+void clock_set_virtual(uint64_t ns);
+
+// Tworzy timerfd. Zwraca 0 albo -1 (errno ustawione).
+int timer_wheel_init(TimerWheel *tw);
+void timer_wheel_destroy(TimerWheel *tw);
+
+void timer_init(Timer *t, void (*fn)(void *arg), void *arg);
+
+// Ustawia (albo przestawia) zegar na chwilę 'expires_ms'; termin z przeszłości odpala w najbliższym przebiegu
+void timer_schedule(TimerWheel *tw, Timer *t, uint64_t expires_ms);
+void timer_cancel(TimerWheel *tw, Timer *t);
+
+static inline int timer_pending(const Timer *t) {
+    return t->list != 0;
+}
+
+// Najbliższy termin (ms) albo UINT64_MAX, gdy koło jest puste
+uint64_t timer_wheel_next(TimerWheel *tw);
+
+// Obsługa odczytu z timerfd: wywołuje zegary, których termin minął, i uzbraja timerfd na kolejny
+void timer_wheel_run(TimerWheel *tw);
+
+#endif
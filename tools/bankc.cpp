@@ -0,0 +1,108 @@
+// Kompilator bazy pytań: zamienia sekcje [QUESTION]/[ANSWER] pliku .ini na obraz binarny,
+// który serwer mapuje przez mmap (BANK_IMAGE=... w config.ini). Obraz zawiera pulę napisów,
+// tablice odpowiedzi i gotowe indeksy haszujące, więc start serwera nie zależy od wielkości bazy.
+//
+// Kompilacja: g++ -O2 -o bankc tools/bankc.cpp bank_image.cpp answer_index.cpp fuzzy_match.cpp
+// Użycie:     ./bankc config.ini bank.bin
+//             ./bankc -g <pytania> <odpowiedzi na pytanie> bank.bin   (syntetyczna baza do testów)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../bank_image.h"
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Syntetyczna baza: "Miasto-<q>-<n>"
+static int generate(int questions, int answers, char **image, size_t *size) {
+    BankBuilder b;
+    bank_builder_init(&b);
+    char buf[64];
+    for (int q = 0; q < questions; q++) {
+        snprintf(buf, sizeof(buf), "Pytanie testowe %d", q + 1);
+        if (bank_builder_add_question(&b, buf) != 0) goto fail;
+        for (int a = 0; a < answers; a++) {
+            snprintf(buf, sizeof(buf), "Miasto-%d-%d", q, a);
+            if (bank_builder_add_answer(&b, buf) != 0) goto fail;
+        }
+    }
+    {
+        int rc = bank_builder_finish(&b, image, size);
+        bank_builder_free(&b);
+        return rc;
+    }
+fail:
+    fprintf(stderr, "Błąd alokacji pamięci.\n");
+    bank_builder_free(&b);
+    return -1;
+}
+
+// Zapis przez plik tymczasowy i rename - działający serwer nigdy nie zobaczy połowy obrazu
+static int write_image(const char *path, const char *image, size_t size) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        perror(tmp);
+        return -1;
+    }
+    if (fwrite(image, 1, size, fp) != size || fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+        perror(tmp);
+        fclose(fp);
+        unlink(tmp);
+        return -1;
+    }
+    fclose(fp);
+    if (rename(tmp, path) != 0) {
+        perror("rename");
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    char *image = NULL;
+    size_t size = 0;
+    const char *out;
+    double t0 = now_sec();
+
+    if (argc == 5 && strcmp(argv[1], "-g") == 0) {
+        out = argv[4];
+        if (generate(atoi(argv[2]), atoi(argv[3]), &image, &size) != 0) return 1;
+    } else if (argc == 3) {
+        out = argv[2];
+        if (bank_compile_file(argv[1], &image, &size) != 0) return 1;
+    } else {
+        fprintf(stderr, "Użycie: %s config.ini bank.bin\n"
+                        "        %s -g <pytania> <odpowiedzi na pytanie> bank.bin\n", argv[0], argv[0]);
+        return 1;
+    }
+    double t1 = now_sec();
+
+    // Sprawdzenie obrazu tym samym kodem, którego używa serwer
+    QuestionBank bank;
+    if (bank_image_from_memory(&bank, image, size) != 0) return 1;
+    if (write_image(out, bank.data, bank.size) != 0) {
+        bank_image_close(&bank);
+        return 1;
+    }
+    const BankHeader *hdr = (const BankHeader *)bank.data;
+    printf("%s: pytania %u, odpowiedzi %llu, rozmiar %zu B, kompilacja %.3f s\n",
+           out, hdr->questionCount, (unsigned long long)hdr->answerCount, bank.size, t1 - t0);
+    bank_image_close(&bank);
+
+    // Czas otwarcia gotowego obrazu (to samo robi serwer przy starcie)
+    double t2 = now_sec();
+    if (bank_image_open(&bank, out) != 0) return 1;
+    double t3 = now_sec();
+    printf("otwarcie obrazu (mmap + walidacja): %.3f ms\n", (t3 - t2) * 1e3);
+    bank_image_close(&bank);
+    return 0;
+}
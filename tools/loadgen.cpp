@@ -0,0 +1,745 @@
+// Test obciążeniowy serwera. Dwa tryby:
+//   login - wiele równoległych połączeń powtarza sekwencję
+//           połączenie -> ROOM_CREATE -> pseudonim -> "Zalogowano" -> rozłączenie
+//           (każdy klient zakłada własny pokój, więc sesje rozkładają się na wszystkie wątki serwera);
+//   game  - symulowani gracze mówiący dokładnie protokołem klienta: pseudonim, pokoje po -r graczy,
+//           odpowiedzi na "Pytanie:" po czasie namysłu, IN_GAME=0 wstrzymuje odpowiedź.
+//           Odpowiedzi pochodzą z bazy config.ini: poprawne, powtarzane (ta sama odpowiedź co inni)
+//           i błędne w proporcjach z -p. Mierzymy tempo łączenia, opóźnienie odpowiedź -> ranking
+//           ("Twoje miejsce") i przepustowość serwera.
+//           Z -b gracze negocjują protokół BIN1 (PROTO=BIN1) i czytają ramki binarne zamiast linii.
+//           Z -d gracze po rankingu zrywają połączenie i wracają do gry z tokenem z logowania (RESUME=).
+//
+// Kompilacja: g++ -O2 -pthread -o loadgen tools/loadgen.cpp bank_image.cpp answer_index.cpp fuzzy_match.cpp
+// Użycie:     ./loadgen [opcje] [host] [port] [połączenia] [sekundy] [wątki]
+//   -m login|game          tryb (domyślnie login)
+//   -r <gracze>            graczy na pokój w trybie game (0 = wszyscy w pokoju domyślnym 0; domyślnie 50)
+//   -c <plik>              baza odpowiedzi (domyślnie config.ini)
+//   -p <poprawne>,<powtórzone>,<błędne>  proporcje odpowiedzi w procentach (domyślnie 60,20,20)
+//   -t fixed:<ms> | uniform:<min>:<max> | exp:<średnia>   czas namysłu (domyślnie uniform:200:3000)
+//   -R <połączeń/s>        tempo otwierania połączeń (0 = wszystkie naraz; domyślnie 0)
+//   -b                     protokół binarny BIN1 w trybie game
+//   -d <procent>           szansa, że gracz po rankingu rundy zerwie połączenie i wznowi sesję (tryb game)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "../bank_image.h"
+#include "../protocol.h"
+#include "../session.h"
+
+enum { ST_CONNECTING, ST_PROMPT, ST_PROTO, ST_ROOM, ST_WAIT_ROOM, ST_JOIN, ST_LOGIN, ST_RESUME, ST_PLAYING, ST_RETRY, ST_CLOSED };
+enum { MODE_LOGIN, MODE_GAME };
+enum { THINK_FIXED, THINK_UNIFORM, THINK_EXP };
+
+typedef struct Conn {
+    int fd;
+    int state;
+    char buf[4096];
+    int len;
+    double started;
+    int index;                  // pozycja w tablicy wątku (grupa pokoju = index / roomSize)
+    int roomId;                 // dla założyciela pokoju: numer z ROOM=<id> (-1 = jeszcze nie znany)
+    int nickTry;
+    int question;               // indeks bieżącego pytania w bazie (-1 = nieznane)
+    unsigned token;             // unieważnia zaplanowaną odpowiedź (IN_GAME=0, nowe pytanie)
+    double answerSent;          // kiedy wysłano odpowiedź w tej rundzie (0 = nie wysłano)
+    int binary;                 // serwer potwierdził PROTO=BIN1 - dalej przychodzą ramki
+    char session[SESSION_TOKEN_TEXT]; // token z TOKEN= (pusty = brak)
+    int dropPending;            // po obsłużeniu odczytu zerwać połączenie i wznowić sesję
+    int resuming;               // nowe połączenie wysyła RESUME= zamiast logowania
+} Conn;
+
+// Zaplanowana odpowiedź (kopiec minimalny po terminie)
+typedef struct Pending {
+    double due;
+    Conn *c;
+    unsigned token;
+} Pending;
+
+// Próbki opóźnień (µs), na koniec sortowane do percentyli
+typedef struct Samples {
+    double *v;
+    size_t count;
+    size_t cap;
+} Samples;
+
+typedef struct LoadThread {
+    int index;
+    pthread_t thread;
+    int conns;
+    long sessions;
+    long errors;
+    double latencySum;
+
+    // Tryb game
+    long connected;             // połączenia, które dostały powitanie serwera
+    double lastConnect;
+    long logins;
+    long answers;
+    long rankings;
+    long bytesIn;
+    long drops;
+    long resumes;
+    long resumeFailed;
+    long rejected;              // "Serwer pełny" - ponowne połączenie po podanym czasie
+    Samples connectLat;
+    Samples rankingLat;
+    Samples resumeLat;
+    Pending *heap;
+    int heapCount;
+    int heapCap;
+    unsigned rng;
+} LoadThread;
+
+static struct sockaddr_in g_addr;
+static double g_deadline;
+static int g_mode = MODE_LOGIN;
+static int g_room_size = 50;
+static int g_pct_correct = 60, g_pct_duplicate = 20;
+static int g_think_kind = THINK_UNIFORM;
+static double g_think_a = 200, g_think_b = 3000;
+static double g_connect_rate = 0;
+static int g_total_conns = 1;
+static int g_binary = 0;
+static int g_drop_pct = 0;
+static QuestionBank g_bank;
+static int g_have_bank = 0;
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned next_rand(LoadThread *t) {
+    t->rng ^= t->rng << 13;
+    t->rng ^= t->rng >> 17;
+    t->rng ^= t->rng << 5;
+    return t->rng;
+}
+
+static double rand_unit(LoadThread *t) {
+    return (next_rand(t) & 0xffffff) / (double)0x1000000;
+}
+
+// Czas namysłu gracza (sekundy)
+static double think_time(LoadThread *t) {
+    double ms;
+    if (g_think_kind == THINK_FIXED) {
+        ms = g_think_a;
+    } else if (g_think_kind == THINK_UNIFORM) {
+        ms = g_think_a + (g_think_b - g_think_a) * rand_unit(t);
+    } else {
+        ms = -g_think_a * log(1.0 - rand_unit(t));
+    }
+    return ms / 1000.0;
+}
+
+static void sample_add(Samples *s, double v) {
+    if (s->count == s->cap) {
+        size_t newCap = s->cap ? s->cap * 2 : 1024;
+        double *tmp = (double *)realloc(s->v, newCap * sizeof(double));
+        if (!tmp) return;
+        s->v = tmp;
+        s->cap = newCap;
+    }
+    s->v[s->count++] = v;
+}
+
+static void heap_push(LoadThread *t, double due, Conn *c) {
+    if (t->heapCount == t->heapCap) {
+        int newCap = t->heapCap ? t->heapCap * 2 : 1024;
+        Pending *tmp = (Pending *)realloc(t->heap, newCap * sizeof(Pending));
+        if (!tmp) return;
+        t->heap = tmp;
+        t->heapCap = newCap;
+    }
+    int i = t->heapCount++;
+    while (i > 0 && t->heap[(i - 1) / 2].due > due) {
+        t->heap[i] = t->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    t->heap[i].due = due;
+    t->heap[i].c = c;
+    t->heap[i].token = c->token;
+}
+
+static Pending heap_pop(LoadThread *t) {
+    Pending top = t->heap[0];
+    Pending last = t->heap[--t->heapCount];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= t->heapCount) break;
+        if (child + 1 < t->heapCount && t->heap[child + 1].due < t->heap[child].due) child++;
+        if (t->heap[child].due >= last.due) break;
+        t->heap[i] = t->heap[child];
+        i = child;
+    }
+    if (t->heapCount > 0) t->heap[i] = last;
+    return top;
+}
+
+static int start_connect(int epfd, Conn *c) {
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c->fd == -1) return -1;
+    c->state = ST_CONNECTING;
+    c->len = 0;
+    c->roomId = -1;
+    c->nickTry = 0;
+    c->question = -1;
+    c->answerSent = 0;
+    c->binary = 0;
+    c->token++;
+    c->started = now_sec();
+    if (connect(c->fd, (struct sockaddr *)&g_addr, sizeof(g_addr)) == -1 && errno != EINPROGRESS) {
+        close(c->fd);
+        c->fd = -1;
+        return -1;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+    return 0;
+}
+
+static void send_line(Conn *c, const char *line) {
+    if (send(c->fd, line, strlen(line), MSG_NOSIGNAL) < 0) {
+        // błąd zobaczymy przy kolejnym recv
+    }
+}
+
+static void send_nick(LoadThread *t, Conn *c) {
+    char nick[64];
+    snprintf(nick, sizeof(nick), "lg%d_%d_%d\n", t->index, c->index, c->nickTry++);
+    send_line(c, nick);
+    c->state = ST_LOGIN;
+}
+
+// Indeks pytania o danej treści albo -1
+static int find_question(const char *text) {
+    for (int q = 0; g_have_bank && q < g_bank.questionCount; q++) {
+        if (strcmp(bank_question_text(&g_bank, q), text) == 0) return q;
+    }
+    return -1;
+}
+
+// Odpowiedź wg proporcji: losowa poprawna, powtarzana (pierwsza z bazy - wszyscy mówią to samo) albo błędna
+static void send_answer(LoadThread *t, Conn *c) {
+    char line[1100];
+    int roll = (int)(next_rand(t) % 100);
+    int answers = (g_have_bank && c->question >= 0) ? bank_answer_count(&g_bank, c->question) : 0;
+    if (answers > 0 && roll < g_pct_correct) {
+        snprintf(line, sizeof(line), "%s\n", bank_answer_text(&g_bank, c->question, (int)(next_rand(t) % answers)));
+    } else if (answers > 0 && roll < g_pct_correct + g_pct_duplicate) {
+        snprintf(line, sizeof(line), "%s\n", bank_answer_text(&g_bank, c->question, 0));
+    } else {
+        snprintf(line, sizeof(line), "Atlantyda-%u\n", next_rand(t) % 100000);
+    }
+    send_line(c, line);
+    c->answerSent = now_sec();
+    t->answers++;
+}
+
+// Założyciel pokoju zna już numer - dołączają czekający członkowie grupy
+static void release_group(Conn *conns, int count, Conn *leader) {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "ROOM_JOIN=%d\n", leader->roomId);
+    for (int i = leader->index + 1; i < count && i < leader->index + g_room_size; i++) {
+        if (conns[i].state == ST_WAIT_ROOM) {
+            send_line(&conns[i], msg);
+            conns[i].state = ST_JOIN;
+        }
+    }
+}
+
+// Po powitaniu (i ewentualnym przejściu na BIN1): wznowienie sesji, pseudonim albo pokój grupy
+static void enter_lobby(LoadThread *t, Conn *conns, Conn *c) {
+    if (c->resuming) {
+        char msg[16 + SESSION_TOKEN_TEXT];
+        snprintf(msg, sizeof(msg), "RESUME=%s\n", c->session);
+        send_line(c, msg);
+        c->state = ST_RESUME;
+    } else if (g_room_size <= 0) {
+        send_nick(t, c);
+    } else if (c->index % g_room_size == 0) {
+        send_line(c, "ROOM_CREATE\n");
+        c->state = ST_ROOM;
+    } else {
+        Conn *leader = &conns[c->index - c->index % g_room_size];
+        if (leader->roomId >= 0) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "ROOM_JOIN=%d\n", leader->roomId);
+            send_line(c, msg);
+            c->state = ST_JOIN;
+        } else {
+            c->state = ST_WAIT_ROOM;
+        }
+    }
+}
+
+// Jedno zdarzenie od serwera w trybie game. Kody OP_* z protocol.h - w protokole tekstowym
+// rozpoznaje je text_event(); 'text' to treść pytania albo token, 'value' numer pokoju albo flaga IN_GAME.
+static void game_event(LoadThread *t, Conn *conns, int count, Conn *c, int op, const char *text, long value) {
+    if (c->state == ST_PROMPT && op == OP_NAME_PROMPT) {
+        // Czas łączenia liczymy do powitania - samo nawiązanie TCP nie znaczy, że serwer przyjął połączenie
+        // (ponowne połączenia po zerwaniu mierzymy osobno, do RESUMED)
+        if (!c->resuming) {
+            t->connected++;
+            t->lastConnect = now_sec();
+            sample_add(&t->connectLat, (t->lastConnect - c->started) * 1e6);
+        }
+        if (g_binary) {
+            send_line(c, "PROTO=BIN1\n");
+            c->state = ST_PROTO;
+        } else {
+            enter_lobby(t, conns, c);
+        }
+    } else if ((c->state == ST_ROOM || c->state == ST_JOIN) && op == OP_ROOM) {
+        if (c->state == ST_ROOM) {
+            c->roomId = (int)value;
+            release_group(conns, count, c);
+        }
+    } else if ((c->state == ST_ROOM || c->state == ST_JOIN) && op == OP_NAME_PROMPT) {
+        send_nick(t, c);
+    } else if (c->state == ST_RESUME && op == OP_RESUMED) {
+        c->state = ST_PLAYING;
+        c->resuming = 0;
+        t->resumes++;
+        sample_add(&t->resumeLat, (now_sec() - c->started) * 1e6);
+    } else if (c->state == ST_RESUME && op == OP_ROOM_ERROR) {
+        // Sesja wygasła - gracz loguje się od nowa (pod nowym pseudonimem, stary może być jeszcze zajęty)
+        t->resumeFailed++;
+        c->resuming = 0;
+        c->session[0] = '\0';
+        send_nick(t, c);
+    } else if (op == OP_ROOM_ERROR) {
+        t->errors++;
+    } else if (op == OP_TOKEN) {
+        snprintf(c->session, sizeof(c->session), "%s", text);
+    } else if (c->state == ST_LOGIN && op == OP_NAME_TAKEN) {
+        send_nick(t, c);
+    } else if (c->state == ST_LOGIN && op == OP_LOGIN_OK) {
+        c->state = ST_PLAYING;
+        t->logins++;
+    }
+
+    if (c->state != ST_PLAYING && c->state != ST_LOGIN) return;
+    if (op == OP_QUESTION) {
+        c->question = find_question(text);
+        c->answerSent = 0;
+        c->token++;
+        heap_push(t, now_sec() + think_time(t), c);
+    } else if (op == OP_IN_GAME && value == 0) {
+        // Gracz nie bierze udziału w tej rundzie albo runda się skończyła - odpowiedź przepada
+        c->token++;
+    } else if (op == OP_MY_RANK) {
+        t->rankings++;
+        if (c->answerSent > 0) {
+            sample_add(&t->rankingLat, (now_sec() - c->answerSent) * 1e6);
+            c->answerSent = 0;
+        }
+        if (g_drop_pct > 0 && c->session[0] && (int)(next_rand(t) % 100) < g_drop_pct) c->dropPending = 1;
+    }
+}
+
+// Linia protokołu tekstowego w trybie game: rozpoznanie zdarzenia po początku linii
+static void game_line(LoadThread *t, Conn *conns, int count, Conn *c, const char *line) {
+    if (c->state == ST_PROTO) {
+        if (strcmp(line, "PROTO=BIN1") == 0) {
+            c->binary = 1;
+            enter_lobby(t, conns, c);
+        } else if (strncmp(line, "PROTO=", 6) == 0) {
+            t->errors++;
+            enter_lobby(t, conns, c);
+        }
+    } else if (strstr(line, "pseudonim:")) {
+        game_event(t, conns, count, c, OP_NAME_PROMPT, NULL, 0);
+    } else if (strncmp(line, "ROOM=", 5) == 0) {
+        game_event(t, conns, count, c, OP_ROOM, NULL, atol(line + 5));
+    } else if (strncmp(line, "TOKEN=", 6) == 0) {
+        game_event(t, conns, count, c, OP_TOKEN, line + 6, 0);
+    } else if (strncmp(line, "RESUMED=", 8) == 0) {
+        game_event(t, conns, count, c, OP_RESUMED, NULL, atol(line + 8));
+    } else if (strncmp(line, "ROOM_ERROR", 10) == 0) {
+        game_event(t, conns, count, c, OP_ROOM_ERROR, NULL, 0);
+    } else if (strncmp(line, "Pseudonim zajęty", 17) == 0) {
+        game_event(t, conns, count, c, OP_NAME_TAKEN, NULL, 0);
+    } else if (strncmp(line, "Zalogowano", 10) == 0) {
+        game_event(t, conns, count, c, OP_LOGIN_OK, NULL, 0);
+    } else if (strncmp(line, "Pytanie: ", 9) == 0) {
+        game_event(t, conns, count, c, OP_QUESTION, line + 9, 0);
+    } else if (strcmp(line, "IN_GAME=0") == 0) {
+        game_event(t, conns, count, c, OP_IN_GAME, NULL, 0);
+    } else if (strncmp(line, "Twoje miejsce:", 14) == 0) {
+        game_event(t, conns, count, c, OP_MY_RANK, NULL, 0);
+    }
+}
+
+// Pełne ramki BIN1 z bufora od pozycji 'start'; zwraca pozycję pierwszej niepełnej
+static int game_frames(LoadThread *t, Conn *conns, int count, Conn *c, int start) {
+    while (start + BIN_HEADER_SIZE <= c->len) {
+        const unsigned char *h = (const unsigned char *)c->buf + start;
+        int n = h[0] << 8 | h[1];
+        int op = h[2];
+        if (start + BIN_HEADER_SIZE + n > c->len) break;
+        const unsigned char *pl = h + BIN_HEADER_SIZE;
+        char text[BIN_MAX_TEXT + 1];
+        long value = 0;
+        if ((op == OP_ROOM || op == OP_RESUMED) && n >= 4) {
+            value = (long)((unsigned long)pl[0] << 24 | pl[1] << 16 | pl[2] << 8 | pl[3]);
+        } else if (op == OP_IN_GAME && n >= 1) {
+            value = pl[0];
+        } else if (op == OP_QUESTION && n >= 4) {
+            int len = pl[2] << 8 | pl[3];
+            if (len > n - 4) len = n - 4;
+            memcpy(text, pl + 4, len);
+            text[len] = '\0';
+        } else if (op == OP_TOKEN && n >= 2) {
+            int len = pl[0] << 8 | pl[1];
+            if (len > n - 2) len = n - 2;
+            memcpy(text, pl + 2, len);
+            text[len] = '\0';
+        }
+        game_event(t, conns, count, c, op, text, value);
+        start += BIN_HEADER_SIZE + n;
+    }
+    return start;
+}
+
+// Odmowa przy pełnej kolejce przyjęć: łączymy się ponownie po czasie podanym przez serwer
+// (zaplanowane w kopcu jak odpowiedź). Zwraca 1, gdy linia była odmową.
+static int server_full(LoadThread *t, Conn *c, const char *line) {
+    const char *prefix = "Serwer pełny, spróbuj ponownie za ";
+    if (strncmp(line, prefix, strlen(prefix)) != 0) return 0;
+    int seconds = atoi(line + strlen(prefix));
+    t->rejected++;
+    close(c->fd);
+    c->fd = -1;
+    c->state = ST_RETRY;
+    c->token++;
+    heap_push(t, now_sec() + (seconds > 0 ? seconds : 1), c);
+    return 1;
+}
+
+// Tryb login: kolejne etapy sesji; po zalogowaniu rozłączamy się i zaczynamy od nowa
+static void login_line(LoadThread *t, int epfd, Conn *c, const char *line) {
+    if (c->state == ST_PROMPT && strstr(line, "pseudonim:")) {
+        send_line(c, "ROOM_CREATE\n");
+        c->state = ST_ROOM;
+    } else if (c->state == ST_ROOM && strstr(line, "pseudonim:")) {
+        send_nick(t, c);
+    } else if (c->state == ST_LOGIN && strncmp(line, "Zalogowano", 10) == 0) {
+        t->sessions++;
+        t->latencySum += now_sec() - c->started;
+        close(c->fd);
+        if (start_connect(epfd, c) != 0) t->errors++;
+    }
+}
+
+static void *load_thread(void *arg) {
+    LoadThread *t = (LoadThread *)arg;
+    int epfd = epoll_create1(0);
+    Conn *conns = (Conn *)calloc(t->conns, sizeof(Conn));
+    t->rng = 2463534242u + 7919u * (unsigned)t->index;
+
+    for (int i = 0; i < t->conns; i++) {
+        conns[i].index = i;
+        conns[i].fd = -1;
+    }
+
+    // Przy -R każdy wątek otwiera swoją część połączeń w równym tempie
+    double begin = now_sec();
+    double rate = g_connect_rate > 0 ? g_connect_rate * t->conns / g_total_conns : 0;
+    int opened = 0;
+
+    struct epoll_event events[256];
+    while (now_sec() < g_deadline) {
+        double now = now_sec();
+        int due = rate > 0 ? (int)((now - begin) * rate) + 1 : t->conns;
+        while (opened < t->conns && opened < due) {
+            if (start_connect(epfd, &conns[opened]) != 0) t->errors++;
+            opened++;
+        }
+
+        // Odpowiedzi, którym minął czas namysłu (unieważnione pomijamy)
+        while (t->heapCount > 0 && t->heap[0].due <= now) {
+            Pending p = heap_pop(t);
+            if (p.token != p.c->token) continue;
+            if (p.c->state == ST_PLAYING) {
+                send_answer(t, p.c);
+            } else if (p.c->state == ST_RETRY && start_connect(epfd, p.c) != 0) {
+                t->errors++;
+                p.c->state = ST_CLOSED;
+            }
+        }
+        int timeout = opened < t->conns ? 1 : 100;
+        if (t->heapCount > 0) {
+            int ms = (int)ceil((t->heap[0].due - now) * 1000.0);
+            if (ms < timeout) timeout = ms < 0 ? 0 : ms;
+        }
+
+        int n = epoll_wait(epfd, events, 256, timeout);
+        for (int i = 0; i < n; i++) {
+            Conn *c = (Conn *)events[i].data.ptr;
+            if (c->state == ST_CONNECTING && (events[i].events & EPOLLOUT)) {
+                struct epoll_event ev;
+                ev.events = EPOLLIN;
+                ev.data.ptr = c;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+                c->state = ST_PROMPT;
+            }
+            if (!(events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))) continue;
+
+            int r = recv(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len, 0);
+            if (r <= 0) {
+                if (r < 0 && errno == EAGAIN) continue;
+                t->errors++;
+                close(c->fd);
+                c->fd = -1;
+                if (g_mode == MODE_LOGIN) {
+                    start_connect(epfd, c);
+                } else {
+                    // W grze nie łączymy się ponownie - pokój by się rozjechał
+                    c->state = ST_CLOSED;
+                    c->token++;
+                }
+                continue;
+            }
+            t->bytesIn += r;
+            c->len += r;
+
+            // Obsługujemy pełne linie (albo ramki BIN1), resztę zostawiamy na kolejny odczyt
+            int start = 0;
+            for (int k = 0; k < c->len && !c->binary; k++) {
+                if (c->buf[k] != '\n') continue;
+                c->buf[k] = '\0';
+                if (k > start && c->buf[k - 1] == '\r') c->buf[k - 1] = '\0';
+                if (server_full(t, c, c->buf + start)) {
+                    start = c->len = 0;
+                    break;
+                }
+                if (g_mode == MODE_GAME) {
+                    game_line(t, conns, t->conns, c, c->buf + start);
+                } else {
+                    login_line(t, epfd, c, c->buf + start);
+                    if (c->state == ST_CONNECTING) {
+                        start = c->len = 0;
+                        break;
+                    }
+                }
+                start = k + 1;
+            }
+            if (c->binary) start = game_frames(t, conns, t->conns, c, start);
+            if (start > 0) {
+                memmove(c->buf, c->buf + start, c->len - start);
+                c->len -= start;
+            }
+            if (c->len >= (int)sizeof(c->buf) - 1) c->len = 0;
+
+            // Symulowane zerwanie łącza: nowe połączenie wznowi sesję tokenem
+            if (c->dropPending) {
+                c->dropPending = 0;
+                close(c->fd);
+                c->fd = -1;
+                t->drops++;
+                if (start_connect(epfd, c) != 0) {
+                    t->errors++;
+                    c->state = ST_CLOSED;
+                } else {
+                    c->resuming = 1;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < t->conns; i++) {
+        if (conns[i].fd >= 0) close(conns[i].fd);
+    }
+    free(conns);
+    close(epfd);
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void samples_merge(Samples *dst, Samples *src) {
+    for (size_t i = 0; i < src->count; i++) sample_add(dst, src->v[i]);
+    free(src->v);
+    memset(src, 0, sizeof(*src));
+}
+
+// Percentyle próbek (ms)
+static void print_percentiles(const char *label, Samples *s) {
+    if (s->count == 0) {
+        printf("%s: brak pomiarów\n", label);
+        return;
+    }
+    qsort(s->v, s->count, sizeof(double), cmp_double);
+    const double qs[] = {0.5, 0.9, 0.99, 0.999};
+    printf("%s (%zu):", label, s->count);
+    for (int i = 0; i < 4; i++) {
+        size_t idx = (size_t)(qs[i] * (double)(s->count - 1));
+        printf(" p%g=%.2f ms", qs[i] * 100, s->v[idx] / 1000.0);
+    }
+    printf(" max=%.2f ms\n", s->v[s->count - 1] / 1000.0);
+}
+
+static int parse_think(const char *spec) {
+    if (sscanf(spec, "fixed:%lf", &g_think_a) == 1) {
+        g_think_kind = THINK_FIXED;
+    } else if (sscanf(spec, "uniform:%lf:%lf", &g_think_a, &g_think_b) == 2 && g_think_b >= g_think_a) {
+        g_think_kind = THINK_UNIFORM;
+    } else if (sscanf(spec, "exp:%lf", &g_think_a) == 1) {
+        g_think_kind = THINK_EXP;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *configFile = "config.ini";
+    int opt;
+    while ((opt = getopt(argc, argv, "m:r:c:p:t:R:bd:")) != -1) {
+        if (opt == 'm') {
+            g_mode = strcmp(optarg, "game") == 0 ? MODE_GAME : MODE_LOGIN;
+        } else if (opt == 'r') {
+            g_room_size = atoi(optarg);
+        } else if (opt == 'c') {
+            configFile = optarg;
+        } else if (opt == 'p') {
+            int wrong;
+            if (sscanf(optarg, "%d,%d,%d", &g_pct_correct, &g_pct_duplicate, &wrong) != 3 ||
+                g_pct_correct + g_pct_duplicate + wrong != 100) {
+                fprintf(stderr, "-p: trzy liczby sumujące się do 100, np. 60,20,20\n");
+                return 1;
+            }
+        } else if (opt == 'b') {
+            g_binary = 1;
+        } else if (opt == 'd') {
+            g_drop_pct = atoi(optarg);
+        } else if (opt == 'R') {
+            g_connect_rate = atof(optarg);
+        } else if (opt == 't') {
+            if (parse_think(optarg) != 0) {
+                fprintf(stderr, "-t: fixed:<ms> | uniform:<min>:<max> | exp:<średnia>\n");
+                return 1;
+            }
+        } else {
+            fprintf(stderr, "Użycie: %s [-m login|game] [-r gracze] [-c config.ini] [-p 60,20,20] [-t uniform:200:3000]"
+                            " [-R połączeń/s] [-b] [-d procent] [host] [port] [połączenia] [sekundy] [wątki]\n", argv[0]);
+            return 1;
+        }
+    }
+    const char *host = optind < argc ? argv[optind] : "127.0.0.1";
+    int port = optind + 1 < argc ? atoi(argv[optind + 1]) : 12345;
+    int conns = optind + 2 < argc ? atoi(argv[optind + 2]) : 256;
+    int seconds = optind + 3 < argc ? atoi(argv[optind + 3]) : 10;
+    int threads = optind + 4 < argc ? atoi(argv[optind + 4]) : 4;
+    g_total_conns = conns > 0 ? conns : 1;
+
+    memset(&g_addr, 0, sizeof(g_addr));
+    g_addr.sin_family = AF_INET;
+    g_addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &g_addr.sin_addr) != 1) {
+        fprintf(stderr, "Niepoprawny adres: %s\n", host);
+        return 1;
+    }
+
+    // Tysiące połączeń wymagają podniesienia limitu deskryptorów
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    if (g_mode == MODE_GAME) {
+        char *image = NULL;
+        size_t size = 0;
+        if (bank_compile_file(configFile, &image, &size) == 0 && bank_image_from_memory(&g_bank, image, size) == 0) {
+            g_have_bank = 1;
+        } else {
+            fprintf(stderr, "Bez bazy odpowiedzi - wszystkie odpowiedzi będą błędne\n");
+        }
+    }
+
+    printf("loadgen: %s:%d, tryb=%s%s, połączenia=%d, czas=%ds, wątki=%d\n", host, port,
+           g_mode == MODE_GAME ? "game" : "login", g_mode == MODE_GAME && g_binary ? " (BIN1)" : "",
+           conns, seconds, threads);
+
+    LoadThread *ts = (LoadThread *)calloc(threads, sizeof(LoadThread));
+    double start = now_sec();
+    g_deadline = start + seconds;
+    for (int i = 0; i < threads; i++) {
+        ts[i].index = i;
+        ts[i].conns = conns / threads + (i < conns % threads ? 1 : 0);
+        pthread_create(&ts[i].thread, NULL, load_thread, &ts[i]);
+    }
+
+    long sessions = 0, errors = 0, connected = 0, logins = 0, answers = 0, rankings = 0, bytesIn = 0;
+    long drops = 0, resumes = 0, resumeFailed = 0, rejected = 0;
+    double latencySum = 0, lastConnect = start;
+    Samples connectLat = {NULL, 0, 0}, rankingLat = {NULL, 0, 0}, resumeLat = {NULL, 0, 0};
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ts[i].thread, NULL);
+        sessions += ts[i].sessions;
+        errors += ts[i].errors;
+        latencySum += ts[i].latencySum;
+        connected += ts[i].connected;
+        logins += ts[i].logins;
+        answers += ts[i].answers;
+        rankings += ts[i].rankings;
+        bytesIn += ts[i].bytesIn;
+        drops += ts[i].drops;
+        resumes += ts[i].resumes;
+        resumeFailed += ts[i].resumeFailed;
+        rejected += ts[i].rejected;
+        if (ts[i].lastConnect > lastConnect) lastConnect = ts[i].lastConnect;
+        samples_merge(&connectLat, &ts[i].connectLat);
+        samples_merge(&rankingLat, &ts[i].rankingLat);
+        samples_merge(&resumeLat, &ts[i].resumeLat);
+        free(ts[i].heap);
+    }
+    double elapsed = now_sec() - start;
+
+    if (g_mode == MODE_LOGIN) {
+        printf("sesje: %ld (%.0f/s), błędy: %ld, średni czas sesji: %.2f ms\n",
+               sessions, sessions / elapsed, errors, sessions ? latencySum * 1000.0 / sessions : 0.0);
+    } else {
+        double connectSpan = lastConnect - start;
+        printf("połączenia z powitaniem: %ld/%d (%.0f/s), zalogowani: %ld, błędy: %ld\n",
+               connected, conns, connectSpan > 0 ? connected / connectSpan : 0.0, logins, errors);
+        print_percentiles("czas do powitania", &connectLat);
+        printf("odpowiedzi: %ld (%.0f/s), rankingi: %ld (%.0f/s), odebrano: %.1f MB (%.2f MB/s)\n",
+               answers, answers / elapsed, rankings, rankings / elapsed, bytesIn / 1e6, bytesIn / 1e6 / elapsed);
+        print_percentiles("odpowiedź -> ranking", &rankingLat);
+        if (g_drop_pct > 0) {
+            printf("zerwania: %ld, wznowienia: %ld, nieudane wznowienia: %ld\n", drops, resumes, resumeFailed);
+            print_percentiles("zerwanie -> RESUMED", &resumeLat);
+        }
+    }
+    if (rejected > 0) printf("odmowy \"Serwer pełny\" (z ponownym połączeniem): %ld\n", rejected);
+    free(connectLat.v);
+    free(rankingLat.v);
+    free(resumeLat.v);
+    if (g_have_bank) bank_image_close(&g_bank);
+    free(ts);
+    return 0;
+}
@@ -0,0 +1,225 @@
+// Licznik wywołań systemowych działającego serwera (porównanie zapleczy IO_BACKEND=epoll / io_uring).
+// Podpina się przez ptrace do wszystkich wątków procesu, przez podany czas liczy wejścia do wywołań
+// systemowych i odłącza się. Z -m pobiera quiz_rounds_total z portu metryk przed i po pomiarze
+// i podaje wywołania na rundę.
+// Śledzenie spowalnia serwer (dwa zatrzymania na każde wywołanie) - opóźnienia mierzymy bez niego.
+//
+// Kompilacja: g++ -O2 -o syscount tools/syscount.cpp
+// Użycie:     ./syscount [-m port_metryk] <pid> [sekundy]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#define MAX_SYSCALL 512
+#define MAX_THREADS 1024
+
+static unsigned long counts[MAX_SYSCALL];
+static pid_t threads[MAX_THREADS];
+static int threadCount = 0;
+static volatile sig_atomic_t timeUp = 0;
+
+static void on_alarm(int) {
+    timeUp = 1;
+}
+
+static const char *syscall_name(long nr) {
+    switch (nr) {
+    case __NR_read: return "read";
+    case __NR_write: return "write";
+    case __NR_writev: return "writev";
+    case __NR_readv: return "readv";
+    case __NR_recvfrom: return "recvfrom";
+    case __NR_sendto: return "sendto";
+    case __NR_recvmsg: return "recvmsg";
+    case __NR_sendmsg: return "sendmsg";
+    case __NR_accept: return "accept";
+    case __NR_accept4: return "accept4";
+    case __NR_close: return "close";
+    case __NR_setsockopt: return "setsockopt";
+    case __NR_fcntl: return "fcntl";
+    case __NR_epoll_wait: return "epoll_wait";
+    case __NR_epoll_pwait: return "epoll_pwait";
+    case __NR_epoll_ctl: return "epoll_ctl";
+    case __NR_io_uring_enter: return "io_uring_enter";
+    case __NR_futex: return "futex";
+    case __NR_getrandom: return "getrandom";
+    case __NR_timerfd_settime: return "timerfd_settime";
+    case __NR_clock_gettime: return "clock_gettime";
+    case __NR_fdatasync: return "fdatasync";
+    case __NR_mmap: return "mmap";
+    case __NR_munmap: return "munmap";
+    case __NR_madvise: return "madvise";
+    default: return NULL;
+    }
+}
+
+static void add_thread(pid_t tid) {
+    for (int i = 0; i < threadCount; i++) {
+        if (threads[i] == tid) return;
+    }
+    if (threadCount < MAX_THREADS) threads[threadCount++] = tid;
+}
+
+static void remove_thread(pid_t tid) {
+    for (int i = 0; i < threadCount; i++) {
+        if (threads[i] == tid) {
+            threads[i] = threads[--threadCount];
+            return;
+        }
+    }
+}
+
+// Podpina się do wszystkich istniejących wątków (nowe dołączy PTRACE_O_TRACECLONE)
+static int seize_all(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return -1;
+    }
+    struct dirent *de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        pid_t tid = (pid_t)atoi(de->d_name);
+        if (ptrace(PTRACE_SEIZE, tid, NULL, (void *)(long)(PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE)) != 0) {
+            perror("PTRACE_SEIZE");
+            continue;
+        }
+        add_thread(tid);
+        // Zatrzymanie, żeby wznowić wątek już z PTRACE_SYSCALL
+        ptrace(PTRACE_INTERRUPT, tid, NULL, NULL);
+    }
+    closedir(dir);
+    return threadCount > 0 ? 0 : -1;
+}
+
+// Licznik quiz_rounds_total z portu metryk (-1 przy błędzie)
+static long long fetch_rounds(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    static char buf[65536];
+    size_t got = 0;
+    const char *req = "GET /metrics HTTP/1.0\r\n\r\n";
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || write(fd, req, strlen(req)) < 0) {
+        close(fd);
+        return -1;
+    }
+    ssize_t n;
+    while (got < sizeof(buf) - 1 && (n = read(fd, buf + got, sizeof(buf) - 1 - got)) > 0) got += (size_t)n;
+    close(fd);
+    buf[got] = '\0';
+    const char *p = strstr(buf, "\nquiz_rounds_total ");
+    return p ? atoll(p + 19) : -1;
+}
+
+static int compare_counts(const void *a, const void *b) {
+    unsigned long x = counts[*(const int *)a], y = counts[*(const int *)b];
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+int main(int argc, char **argv) {
+    int metricsPort = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:")) != -1) {
+        if (opt == 'm') {
+            metricsPort = atoi(optarg);
+        } else {
+            fprintf(stderr, "Użycie: %s [-m port_metryk] <pid> [sekundy]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Użycie: %s [-m port_metryk] <pid> [sekundy]\n", argv[0]);
+        return 1;
+    }
+    pid_t pid = (pid_t)atoi(argv[optind]);
+    int seconds = optind + 1 < argc ? atoi(argv[optind + 1]) : 10;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_alarm;   // bez SA_RESTART: waitpid() przerwie się po czasie pomiaru
+    sigaction(SIGALRM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+
+    long long roundsBefore = metricsPort ? fetch_rounds(metricsPort) : -1;
+    if (seize_all(pid) != 0) return 1;
+    alarm(seconds > 0 ? seconds : 1);
+
+    unsigned long total = 0;
+    while (!timeUp) {
+        int status;
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            remove_thread(tid);
+            continue;
+        }
+        if (!WIFSTOPPED(status)) continue;
+        int sig = WSTOPSIG(status);
+        int event = status >> 16;
+        int inject = 0;
+        if (sig == (SIGTRAP | 0x80)) {
+            struct __ptrace_syscall_info info;
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, tid, (void *)sizeof(info), &info) > 0 &&
+                info.op == PTRACE_SYSCALL_INFO_ENTRY) {
+                if (info.entry.nr < MAX_SYSCALL) counts[info.entry.nr]++;
+                total++;
+            }
+        } else if (event == PTRACE_EVENT_CLONE) {
+            unsigned long child;
+            if (ptrace(PTRACE_GETEVENTMSG, tid, NULL, &child) == 0) add_thread((pid_t)child);
+        } else if (event == 0) {
+            inject = sig;   // zwykły sygnał dla procesu - przekazujemy go dalej
+        }
+        ptrace(PTRACE_SYSCALL, tid, NULL, (void *)(long)inject);
+    }
+
+    // Odłączenie: każdy wątek trzeba najpierw zatrzymać
+    for (int i = 0; i < threadCount; i++) ptrace(PTRACE_INTERRUPT, threads[i], NULL, NULL);
+    while (threadCount > 0) {
+        int status;
+        pid_t tid = waitpid(-1, &status, __WALL);
+        if (tid < 0) break;
+        if (WIFSTOPPED(status)) {
+            int sig = WSTOPSIG(status);
+            int inject = (status >> 16) == 0 && sig != (SIGTRAP | 0x80) ? sig : 0;
+            ptrace(PTRACE_DETACH, tid, NULL, (void *)(long)inject);
+        }
+        remove_thread(tid);
+    }
+    long long roundsAfter = metricsPort ? fetch_rounds(metricsPort) : -1;
+
+    int order[MAX_SYSCALL];
+    for (int i = 0; i < MAX_SYSCALL; i++) order[i] = i;
+    qsort(order, MAX_SYSCALL, sizeof(int), compare_counts);
+    printf("wywołania systemowe w %d s: %lu\n", seconds, total);
+    for (int i = 0; i < MAX_SYSCALL && counts[order[i]] > 0; i++) {
+        const char *name = syscall_name(order[i]);
+        if (name) printf("  %-16s %10lu\n", name, counts[order[i]]);
+        else printf("  nr %-13d %10lu\n", order[i], counts[order[i]]);
+    }
+    if (roundsBefore >= 0 && roundsAfter > roundsBefore) {
+        long long rounds = roundsAfter - roundsBefore;
+        printf("rundy: %lld, wywołań na rundę: %.0f\n", rounds, (double)total / rounds);
+    }
+    return 0;
+}
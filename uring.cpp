@@ -0,0 +1,210 @@
+#include "uring.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned toSubmit, unsigned wait, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, wait, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned op, void *arg, unsigned nr) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, nr);
+}
+
+static void *map_ring(int fd, size_t size, off_t offset) {
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+// Pierścień buforów odbioru: tablica opisów bufora (wyrównana do strony) i same bufory
+static int setup_buffers(Uring *r) {
+    r->bufRingSize = URING_BUFFERS * sizeof(struct io_uring_buf);
+    void *ring = mmap(NULL, r->bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void *bufs = mmap(NULL, (size_t)URING_BUFFERS * URING_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED || bufs == MAP_FAILED) {
+        if (ring != MAP_FAILED) munmap(ring, r->bufRingSize);
+        if (bufs != MAP_FAILED) munmap(bufs, (size_t)URING_BUFFERS * URING_BUFFER_SIZE);
+        return -1;
+    }
+    r->bufRing = (struct io_uring_buf_ring *)ring;
+    r->bufs = (char *)bufs;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = URING_BUFFERS;
+    reg.bgid = URING_BUFFER_GROUP;
+    if (sys_register(r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) return -1;
+
+    for (unsigned bid = 0; bid < URING_BUFFERS; bid++) uring_buffer_return(r, (unsigned short)bid);
+    return 0;
+}
+
+// Mapuje SQ, CQ i tablicę zgłoszeń
+static int map_rings(Uring *r, const struct io_uring_params *p) {
+    r->sqMapSize = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+    r->cqMapSize = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+    if ((p->features & IORING_FEAT_SINGLE_MMAP) && r->cqMapSize > r->sqMapSize) r->sqMapSize = r->cqMapSize;
+    r->sqMap = map_ring(r->fd, r->sqMapSize, IORING_OFF_SQ_RING);
+    if (!r->sqMap) return -1;
+    char *sq = (char *)r->sqMap;
+    char *cq = sq;
+    if (!(p->features & IORING_FEAT_SINGLE_MMAP)) {
+        r->cqMap = map_ring(r->fd, r->cqMapSize, IORING_OFF_CQ_RING);
+        if (!r->cqMap) return -1;
+        cq = (char *)r->cqMap;
+    }
+    r->sqesSize = p->sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe *)map_ring(r->fd, r->sqesSize, IORING_OFF_SQES);
+    if (!r->sqes) return -1;
+
+    r->sqHead = (unsigned *)(sq + p->sq_off.head);
+    r->sqTail = (unsigned *)(sq + p->sq_off.tail);
+    r->sqMask = *(unsigned *)(sq + p->sq_off.ring_mask);
+    r->sqEntries = p->sq_entries;
+    r->sqLocalTail = *r->sqTail;
+    // Zgłoszenie i-te zawsze w slocie i-tym
+    unsigned *array = (unsigned *)(sq + p->sq_off.array);
+    for (unsigned i = 0; i < p->sq_entries; i++) array[i] = i;
+    r->cqHead = (unsigned *)(cq + p->cq_off.head);
+    r->cqTail = (unsigned *)(cq + p->cq_off.tail);
+    r->cqMask = *(unsigned *)(cq + p->cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p->cq_off.cqes);
+    return 0;
+}
+
+int uring_init(Uring *r, unsigned entries, unsigned cqEntries, int buffers) {
+    memset(r, 0, sizeof(*r));
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    p.cq_entries = cqEntries;
+    r->fd = sys_setup(entries, &p);
+    if (r->fd < 0 && errno == EINVAL) {
+        // Starsze jądro - bez opcjonalnych flag
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = cqEntries;
+        r->fd = sys_setup(entries, &p);
+    }
+    if (r->fd < 0) return -1;
+
+    if (map_rings(r, &p) != 0 || (buffers && setup_buffers(r) != 0)) {
+        int err = errno;
+        uring_destroy(r);
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+void uring_destroy(Uring *r) {
+    if (r->bufRing) munmap(r->bufRing, r->bufRingSize);
+    if (r->bufs) munmap(r->bufs, (size_t)URING_BUFFERS * URING_BUFFER_SIZE);
+    if (r->sqes) munmap(r->sqes, r->sqesSize);
+    if (r->cqMap) munmap(r->cqMap, r->cqMapSize);
+    if (r->sqMap) munmap(r->sqMap, r->sqMapSize);
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+struct io_uring_sqe *uring_sqe(Uring *r) {
+    if (r->sqLocalTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE) >= r->sqEntries) {
+        if (uring_submit(r, 0) != 0) return NULL;
+        if (r->sqLocalTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE) >= r->sqEntries) return NULL;
+    }
+    struct io_uring_sqe *sqe = &r->sqes[r->sqLocalTail & r->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sqLocalTail++;
+    return sqe;
+}
+
+int uring_submit(Uring *r, unsigned wait) {
+    __atomic_store_n(r->sqTail, r->sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = r->sqLocalTail - __atomic_load_n(r->sqHead, __ATOMIC_ACQUIRE);
+    if (toSubmit == 0) {
+        // Zakończenia już czekają - nie ma po co wchodzić do jądra
+        unsigned ready = __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE) - *r->cqHead;
+        if (ready >= wait) return 0;
+    }
+    r->enters++;
+    int ret = sys_enter(r->fd, toSubmit, wait, wait ? IORING_ENTER_GETEVENTS : 0);
+    return ret < 0 ? -1 : 0;
+}
+
+void uring_buffer_return(Uring *r, unsigned bid) {
+    // Opis bufora 0 dzieli pamięć z ogonem pierścienia - nie zerujemy całego wpisu.
+    // Nie przez bufRing->bufs: w C++ __DECLARE_FLEX_ARRAY przesuwa tę tablicę o 8 bajtów.
+    struct io_uring_buf *b = (struct io_uring_buf *)r->bufRing + (r->bufTail & (URING_BUFFERS - 1));
+    b->addr = (uint64_t)(uintptr_t)uring_buffer(r, bid);
+    b->len = URING_BUFFER_SIZE;
+    b->bid = (unsigned short)bid;
+    r->bufTail++;
+    __atomic_store_n(&r->bufRing->tail, r->bufTail, __ATOMIC_RELEASE);
+}
+
+void uring_prep_accept(struct io_uring_sqe *sqe, int fd, uint64_t user) {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = user;
+}
+
+void uring_prep_poll(struct io_uring_sqe *sqe, int fd, unsigned events, int multishot, uint64_t user) {
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = user;
+}
+
+void uring_prep_recv(struct io_uring_sqe *sqe, int fd, uint64_t user) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = user;
+}
+
+void uring_prep_sendmsg(struct io_uring_sqe *sqe, int fd, const struct msghdr *msg, unsigned flags, uint64_t user) {
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = flags;
+    sqe->user_data = user;
+}
+
+void uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t target, uint64_t user) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = user;
+}
+
+void uring_prep_cancel_fd(struct io_uring_sqe *sqe, int fd, uint64_t user) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = user;
+}
+
+void uring_prep_close(struct io_uring_sqe *sqe, int fd, uint64_t user) {
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = user;
+}
@@ -0,0 +1,84 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+// io_uring przez surowe wywołania systemowe (bez liburing): pierścień zgłoszeń (SQ) i zakończeń (CQ)
+// zmapowane z jądra oraz pierścień buforów odbioru (provided buffers), z których jądro samo
+// bierze bufor dla każdej paczki danych z odbioru multishot.
+#define URING_ENTRIES 1024          // zgłoszeń w SQ
+#define URING_CQ_ENTRIES 8192       // zakończeń w CQ (odbiór multishot daje wiele zakończeń na zgłoszenie)
+#define URING_BUFFERS 1024          // buforów odbioru (potęga dwójki)
+#define URING_BUFFER_SIZE 2048
+#define URING_BUFFER_GROUP 0
+
+typedef struct Uring {
+    int fd;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned sqLocalTail;       // przygotowane zgłoszenia (do *sqTail trafiają przy wysłaniu)
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    void *sqMap;
+    size_t sqMapSize;
+    void *cqMap;                // NULL, gdy CQ dzieli mapowanie z SQ
+    size_t cqMapSize;
+    size_t sqesSize;
+
+    struct io_uring_buf_ring *bufRing;  // NULL = bez buforów odbioru
+    char *bufs;
+    size_t bufRingSize;
+    unsigned short bufTail;
+
+    unsigned long enters;       // wywołania io_uring_enter (statystyka)
+} Uring;
+
+// Tworzy pierścień (z buforami odbioru, gdy 'buffers'). Zwraca 0 albo -1 (errno ustawione).
+int uring_init(Uring *r, unsigned entries, unsigned cqEntries, int buffers);
+void uring_destroy(Uring *r);
+
+// Wolne (wyzerowane) zgłoszenie; przy pełnym SQ najpierw wysyła przygotowane. NULL przy błędzie.
+struct io_uring_sqe *uring_sqe(Uring *r);
+// Wysyła przygotowane zgłoszenia i czeka, aż w CQ będzie co najmniej 'wait' zakończeń.
+// Zwraca 0 albo -1 (errno ustawione, np. EINTR).
+int uring_submit(Uring *r, unsigned wait);
+
+// Najstarsze nieobsłużone zakończenie albo NULL
+static inline struct io_uring_cqe *uring_peek(Uring *r) {
+    unsigned head = *r->cqHead;
+    if (head == __atomic_load_n(r->cqTail, __ATOMIC_ACQUIRE)) return NULL;
+    return &r->cqes[head & r->cqMask];
+}
+
+// Zwalnia miejsce po zakończeniu z uring_peek() (wcześniej trzeba skopiować jego pola)
+static inline void uring_seen(Uring *r) {
+    __atomic_store_n(r->cqHead, *r->cqHead + 1, __ATOMIC_RELEASE);
+}
+
+// Bufor odbioru o numerze z zakończenia (cqe->flags >> IORING_CQE_BUFFER_SHIFT)
+static inline char *uring_buffer(Uring *r, unsigned bid) {
+    return r->bufs + (size_t)bid * URING_BUFFER_SIZE;
+}
+// Oddaje bufor jądru do kolejnych odbiorów
+void uring_buffer_return(Uring *r, unsigned bid);
+
+// Przygotowanie zgłoszeń
+void uring_prep_accept(struct io_uring_sqe *sqe, int fd, uint64_t user);        // multishot, SOCK_NONBLOCK
+void uring_prep_poll(struct io_uring_sqe *sqe, int fd, unsigned events, int multishot, uint64_t user);
+void uring_prep_recv(struct io_uring_sqe *sqe, int fd, uint64_t user);          // multishot z buforów odbioru
+void uring_prep_sendmsg(struct io_uring_sqe *sqe, int fd, const struct msghdr *msg, unsigned flags, uint64_t user);
+// Odwołuje wszystkie zgłoszenia o danym user_data
+void uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t target, uint64_t user);
+// Odwołuje wszystkie zgłoszenia dotyczące 'fd' (deskryptor musi być jeszcze otwarty)
+void uring_prep_cancel_fd(struct io_uring_sqe *sqe, int fd, uint64_t user);
+void uring_prep_close(struct io_uring_sqe *sqe, int fd, uint64_t user);
+
+#endif